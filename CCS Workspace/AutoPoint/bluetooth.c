@@ -7,277 +7,240 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-
-#include "driverlib/gpio.h"
-#include "driverlib/sysctl.h"
-#include "driverlib/uart.h"
-#include "inc/hw_memmap.h"
-#include "inc/hw_gpio.h"
-#include "inc/hw_uart.h"
-#include "driverlib/pin_map.h"
+#include <string.h>
 
 #include "util.h"
+#include "frame.h"
+#include "ring.h"
 #include "bluetooth.h"
+#include "bluetooth_uart.h"
 #include "bluetooth_packet_handler.h"
+#include "rn42.h"
+#include "trace.h"
 
-/* BT module pin assignments
- *
- * UART RX: PB0 / U1RX
- * UART TX: PB1 / U1TX
- * UART RTS: PF0 / U1RTS (may not work)
- * UART CTS: PF1 / U1CTS (may not work)
- *
- * ~RESET:          PE0
- * 9.6K_BAUD:       PE3
- * CONNECTED:       PE4
+/* The link to the RN42: RN42 bring-up, then framing, dispatch and the TX queue. Getting bytes
+ * through the UART itself is bluetooth_uart.c's job (see bluetooth_uart.h).
  */
 
-#define TX_BUFF_SIZE 1024
-#define RX_BUFF_SIZE 1024
+uint8_t bluetooth_rx_buff[BLUETOOTH_RX_BUFF_SIZE];
+static uint8_t tx_buff[BLUETOOTH_TX_BUFF_SIZE];
+ring_t bluetooth_tx_ring;
+
+/* Absolute RX position read up to, and times the UART side lapped us */
+static uint32_t rx_read = 0;
+static uint32_t rx_overruns = 0;
+
+/* Arrival time (util_clock_cycles64) of frame delimiters, with their absolute position in
+ * the RX stream. Lets the time sync see when a request actually came in rather than when we
+ * got round to it. Only delimiters the UART side stamps get one (on the TM4C a message that ends
+ * exactly on a DMA burst has no arrival time), and the time sync drops the rest. */
+#define RX_STAMP_SIZE 8
+typedef struct {
+    uint32_t pos;
+    uint64_t cycles;
+} rx_stamp_t;
+static rx_stamp_t rx_stamps[RX_STAMP_SIZE];
+static volatile uint32_t rx_stamp_head = 0;
+static volatile uint32_t rx_stamp_tail = 0;
+
+/* One character on the wire (8N1) */
+static uint32_t baud = BLUETOOTH_BAUD_BOOT;
+static uint32_t char_cycles = 10 * (UTIL_CLOCK_HZ / BLUETOOTH_BAUD_BOOT);
+
+/* Frames are handed on where they sit in rx_buff. rx_read is the start of the frame being
+ * received, rx_scan how far we've looked for its delimiter. Only a frame that wraps round the end
+ * of rx_buff is copied, into packet_buff, to give the handler one contiguous run. During bring-up
+ * the "frames" are RN42 response lines. Anything too long is dropped whole. */
+static uint8_t packet_buff[FRAME_MAX_ENCODED];
+static uint32_t rx_scan = 0;
+static bool rx_skipping = false;
+static bool rx_framed = false;
+static uint32_t rx_dropped = 0;
+static uint32_t rx_wrapped = 0;
+
+/* Record a delimiter's arrival, if there's room */
+void bluetooth_rx_stamp(uint32_t pos, uint64_t cycles) {
+    trace_rx_stamp(pos, cycles);
+
+    if (rx_stamp_head - rx_stamp_tail < RX_STAMP_SIZE) {
+        rx_stamp_t* st = &rx_stamps[rx_stamp_head % RX_STAMP_SIZE];
+        st->pos = pos;
+        st->cycles = cycles;
+        rx_stamp_head++;
+    }
+}
 
-/* TX buffer, insert chars at head, retrieve at tail. */
-char tx_buff[TX_BUFF_SIZE];
-volatile uint32_t tx_head = 0;
-volatile uint32_t tx_tail = 0;
+/* Arrival time of the delimiter at absolute position pos, 0 if it wasn't stamped */
+static uint64_t rx_stamp_at(uint32_t pos) {
+    uint64_t stamp = 0;
+    bool irq = trace_lock();
+    while (rx_stamp_tail != rx_stamp_head) {
+        const rx_stamp_t* s = &rx_stamps[rx_stamp_tail % RX_STAMP_SIZE];
+        if ((int32_t) (s->pos - pos) > 0) break;
+        if (s->pos == pos) stamp = s->cycles;
+        rx_stamp_tail++;
+    }
+    trace_unlock(irq);
+    return stamp;
+}
 
-/* RX buffer, insert chars at head, retrieve at tail. */
-char rx_buff[RX_BUFF_SIZE];
-volatile uint32_t rx_head = 0;
-volatile uint32_t rx_tail = 0;
+/* Sent bytes off the TX ring */
+void bluetooth_tx_done(uint32_t len) {
+    trace_tx_done(len);
+    ring_consume(&bluetooth_tx_ring, len);
+}
 
-/* Packets guaranteed(tm) to be 255b or smaller */
-char packet_buff[256];
-uint32_t packet_ptr = 0;
+/* Hand on the len byte frame starting at absolute position start */
+static void rx_dispatch(uint32_t start, uint32_t len, uint64_t stamp, bool ready) {
+    uint32_t at = start % BLUETOOTH_RX_BUFF_SIZE;
+    uint8_t* frame = &bluetooth_rx_buff[at];
+
+    if (at + len > BLUETOOTH_RX_BUFF_SIZE) {
+        uint32_t first = BLUETOOTH_RX_BUFF_SIZE - at;
+        memcpy(packet_buff, frame, first);
+        memcpy(&packet_buff[first], bluetooth_rx_buff, len - first);
+        frame = packet_buff;
+        rx_wrapped++;
+    }
 
-/* Try to pop a char from the RX buffer.
- * Returns true if successful, false if empty
- */
-static bool rx_pop(char* data) {
-    if(rx_head == rx_tail) return false;
-    *data = rx_buff[rx_tail];
-    rx_tail = (rx_tail + 1) % RX_BUFF_SIZE;
-    return true;
+    if (!ready) {
+        rn42_line((const char*) frame, len);
+    } else if (len > 0) {
+        handle_new_packet(frame, len, stamp);
+    }
 }
 
-/* Called periodically from the main loop. Pops all packets from the rx buffer and
- * passes them on to the packet handler.
- *
- * Partially received packets will stay in packet_buff until the rest is received.
- */
-void bluetooth_handle_packets() {
-    /* Possible conditions:
-     * Packet end
-     * Out of data
-     */
-    while(true) {
-        char data;
-        bool ok = rx_pop(&data);
-        if (!ok) break;
-        packet_buff[packet_ptr++] = data;
-        if (data == '\n' || packet_ptr >= 255) {
-            handle_new_packet(packet_buff, packet_ptr);
-            packet_ptr = 0;
-        }
+/* How far the UART side has written. If it has lapped rx_read, whatever was in flight is gone:
+ * count it and carry on from there, dropping up to the next delimiter. */
+static uint32_t rx_check(void) {
+    uint32_t written = trace_rx(bluetooth_uart_rx_written(), bluetooth_rx_buff, BLUETOOTH_RX_BUFF_SIZE);
+
+    if (written - rx_read > BLUETOOTH_RX_BUFF_SIZE) {
+        rx_overruns++;
+        rx_read = written;
+        rx_scan = written;
+        rx_skipping = true;
     }
+    return written;
 }
 
-static void bluetooth_uart_isr(void) {
-    uint32_t cause = UARTIntStatus(UART1_BASE, true);
+/* Called periodically from the main loop. Pops all frames from the rx buffer and
+ * passes them on to the packet handler (or lines to the RN42 bring-up, until that's done).
+ *
+ * Partially received frames stay where they are in rx_buff until the rest is received.
+ */
+void bluetooth_handle_packets() {
+    uint32_t written = rx_check();
 
-    if (cause & UART_INT_TX) {
-        /* TX complete interrupt. Send more data. */
-        UARTIntClear(UART1_BASE, UART_INT_TX);
+    if (rx_framed != rn42_is_ready()) {
+        /* bring-up finished (or restarted) outside a line, look again with the other delimiter */
+        rx_framed = rn42_is_ready();
+        rx_scan = rx_read;
+    }
 
-        /* fill with 16 chars or until FIFO full, whichever comes first */
-        for (uint32_t i = 0; i < 16; i++) {
+    while (rx_scan != written) {
+        /* the bring-up can finish on any line, so pick the delimiter per frame */
+        bool ready = rn42_is_ready();
+        uint32_t at = rx_scan % BLUETOOTH_RX_BUFF_SIZE;
+        uint32_t run = written - rx_scan;
+        if (run > BLUETOOTH_RX_BUFF_SIZE - at) run = BLUETOOTH_RX_BUFF_SIZE - at;
+
+        const uint8_t* delim = memchr(&bluetooth_rx_buff[at], ready ? FRAME_DELIM : '\n', run);
+        if (delim == NULL) {
+            rx_scan += run;
+            continue;
+        }
+        rx_scan += (uint32_t) (delim - &bluetooth_rx_buff[at]);
 
-            if (tx_tail == tx_head) {
-                /* no more data to send */
-                break;
-            }
+        /* frames are handed on in place, and a slow handler earlier in this pass (a catalog entry,
+         * a flash save) gives the UART side time to come round again: look before each one */
+        written = rx_check();
+        if (rx_scan == written) continue;   /* lapped, and this frame with it */
 
-            char data = tx_buff[tx_tail];
-            bool ok = UARTCharPutNonBlocking(UART1_BASE, data);
+        uint32_t len = rx_scan - rx_read;
+        uint64_t stamp = rx_stamp_at(rx_scan);
 
-            if (ok) {
-                tx_tail = (tx_tail + 1) % TX_BUFF_SIZE;
-            } else {
-                break;
-            }
+        if (rx_skipping || len > FRAME_MAX_ENCODED) {
+            rx_dropped++;
+        } else {
+            rx_dispatch(rx_read, len, stamp, ready);
         }
+        rx_skipping = false;
+        rx_scan++;
+        rx_read = rx_scan;
     }
 
-    if (cause & (UART_INT_RX | UART_INT_RT)) {
-        /* RX interrupt, we got data. */
-        UARTIntClear(UART1_BASE, UART_INT_RX | UART_INT_RT);
-
-        while(true) {
-            /* Pull data out of the hardware FIFO until there isn't any more */
-            int32_t data = UARTCharGetNonBlocking(UART1_BASE);
-
-            if (data == -1) {
-                /* input RX FIFO is empty, stop. */
-                break;
-            } else {
-                uint32_t next_rx_head = (rx_head + 1) % RX_BUFF_SIZE;
-                if (next_rx_head == rx_tail) {
-                    /* silently drop packets if the RX buff is full */
-                } else {
-                    rx_buff[rx_head] = data;
-                    rx_head = next_rx_head;
-                }
-            }
-        }
+    /* no delimiter in sight and already too long: stop holding it, drop up to the next one */
+    if (rx_scan - rx_read > FRAME_MAX_ENCODED) {
+        rx_skipping = true;
+        rx_read = rx_scan;
     }
-}
 
-/* Send a LOW pulse to the RN42 ~RESET pin */
-static void bluetooth_reset() {
-    GPIOPinWrite(GPIO_PORTE_BASE, (1<<0), 0);
-    util_delay_us(250 * 1000);
-    GPIOPinWrite(GPIO_PORTE_BASE, (1<<0), (1<<0));
+    /* frames are handled in place, so the UART side can only have the space back now */
+    bluetooth_uart_rx_release(rx_read);
+
+    if (!rn42_is_ready()) rn42_update();
 }
 
-static void bluetooth_force_baud(bool force) {
-    if(force) {
-        GPIOPinWrite(GPIO_PORTE_BASE, (1<<3), (1<<3));
-    } else {
-        GPIOPinWrite(GPIO_PORTE_BASE, (1<<3), 0);
-    }
+/* Bytes queued for sending that haven't reached the UART FIFO yet */
+uint32_t bluetooth_tx_pending(void) {
+    return trace_value(bluetooth_uart_tx_pending());
 }
 
-static void bluetooth_send_sync(const char* data) {
-    const char* ptr = data;
+/* Change the UART baud, once everything queued has gone out. Main loop only. */
+void bluetooth_set_baud(uint32_t new_baud) {
+    if (new_baud == baud) return;
 
-    while (*ptr != 0) {
-        UARTCharPut(UART1_BASE, *ptr);
-        ptr++;
-    }
+    bluetooth_uart_set_baud(new_baud);
+    baud = new_baud;
+    char_cycles = 10 * (UTIL_CLOCK_HZ / new_baud);
 }
 
-static void bluetooth_uart_clear() {
-    while(UARTCharGetNonBlocking(UART1_BASE) != -1);
+uint32_t bluetooth_get_baud(void) {
+    return baud;
 }
 
-static uint32_t bluetooth_read_line(char* buf, uint32_t size) {
+/* Time for one character on the wire, in cycles */
+uint32_t bluetooth_char_cycles(void) {
+    return char_cycles;
+}
 
-    /* wait for something to happen... */
+/* Queue len bytes for sending. Main loop only. Returns false (and sends nothing, but counts it)
+ * if they don't fit in the TX buffer. */
+bool bluetooth_write(const void* data, uint32_t len) {
+    bool irq = trace_lock();
+    bool queued = ring_write(&bluetooth_tx_ring, data, len);
+    trace_unlock(irq);
+    if (!queued) return false;
 
-    uint32_t i = 0;
+    bluetooth_uart_tx_start();
+    return true;
+}
 
-    while(i < size) {
-       int c = UARTCharGet(UART1_BASE);
-       if (c == '\r' || c == '\n') {
-           buf[i] = 0;
-           bluetooth_uart_clear();
-           return i;
-       } else {
-           buf[i] = c;
-           i++;
-       }
-    }
+/* Queue a string (RN42 commands) */
+bool bluetooth_send(const char* data) {
+    return bluetooth_write(data, strlen(data));
 }
 
-static bool bluetooth_get_ack() {
-    char buf[8];
-    uint32_t len = bluetooth_read_line(buf, 8);
-    if (len != 3) goto fail;
-    if (buf[0] != 'A') goto fail;
-    if (buf[1] != 'O') goto fail;
-    if (buf[2] != 'K') goto fail;
-    return true;
+/* Frame up a message and queue it, all or nothing (see frame.h) */
+bool bluetooth_send_frame(uint8_t type, const void* payload, uint32_t len) {
+    uint8_t buf[FRAME_MAX_ENCODED];
+    uint32_t n = frame_encode(type, payload, len, buf);
+    return n > 0 && bluetooth_write(buf, n);
+}
 
-    fail:
-    while(true);
+void bluetooth_get_stats(bluetooth_stats_t* out) {
+    out->tx_high_water = bluetooth_tx_ring.high_water;
+    out->tx_overflows = bluetooth_tx_ring.overflows;
+    out->rx_overruns = rx_overruns;
+    out->rx_dropped = rx_dropped;
+    out->rx_wrapped = rx_wrapped;
 }
 
 void bluetooth_init(void) {
+    ring_init(&bluetooth_tx_ring, tx_buff, BLUETOOTH_TX_BUFF_SIZE);
+    bluetooth_uart_init(BLUETOOTH_BAUD_BOOT);
 
-    /* initialize UART comm pins */
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOB));
-
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOE));
-
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOF));
-
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART1);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_UART1));
-
-    /* Configure GPIO pins */
-    GPIOPinTypeGPIOOutput(GPIO_PORTE_BASE, (1<<0) | (1<<3));
-    GPIOPinTypeGPIOInput(GPIO_PORTE_BASE, (1<<4));
-
-    /* Configure UART pins: drive settings */
-    GPIOPinTypeUART(GPIO_PORTB_BASE, (1<<0) | (1<<1));
-    GPIOPinTypeUART(GPIO_PORTF_BASE, (1<<0) | (1<<1));
-
-    /* Configure UART pins: set pinmux */
-    GPIOPinConfigure(GPIO_PB0_U1RX);
-    GPIOPinConfigure(GPIO_PB1_U1TX);
-    GPIOPinConfigure(GPIO_PF0_U1RTS);
-    GPIOPinConfigure(GPIO_PF1_U1CTS);
-
-    /* Configure comm UART:
-     * UART 1
-     * 80 MHz system clock
-     * 9600 baud
-     * 8, N, 1 */
-    UARTConfigSetExpClk(UART1_BASE, 80000000, 9600, UART_CONFIG_WLEN_8 | UART_CONFIG_PAR_NONE | UART_CONFIG_STOP_ONE);
-    UARTEnable(UART1_BASE);
-
-    /* Reset the RN42 bluetooth module, and force a known baud rate. */
-    bluetooth_force_baud(true);
-    bluetooth_reset();
-
-    util_delay_us(1 * 1000 * 1000);
-
-    /* Send configuration strings to the RN42. Note settings starting with "S" */
-    char buf[100];
-
-    bluetooth_uart_clear();
-    bluetooth_send_sync("$$$");
-    bluetooth_read_line(buf, 100);
-    util_delay_us(100 * 1000);
-
-    /* set security PIN to 69420 */
-    bluetooth_uart_clear();
-    bluetooth_send_sync("SP,69420\r\n");
-    bluetooth_get_ack();
-
-    /* full power */
-    util_delay_us(100 * 1000);
-    bluetooth_uart_clear();
-    bluetooth_send_sync("SY,0010\r\n");
-    bluetooth_get_ack();
-
-    /* serial port profile */
-    util_delay_us(100 * 1000);
-    bluetooth_uart_clear();
-    bluetooth_send_sync("S~,0\r\n");
-    bluetooth_get_ack();
-
-    /* set name */
-    util_delay_us(100 * 1000);
-    bluetooth_uart_clear();
-    bluetooth_send_sync("SN,laser\r\n");
-    bluetooth_get_ack();
-
-    /* set UUID for android shit */
-    util_delay_us(100 * 1000);
-    bluetooth_uart_clear();
-    bluetooth_send_sync("SE,0000110100001000800000805F9B34FB\r\n");
-    bluetooth_get_ack();
-
-    /* reboot device so changes take effect... */
-    bluetooth_reset();
-
-    /* Enable interrupts: RX fifo, RX timeout, TX complete */
-    UARTFIFOLevelSet(UART1_BASE, UART_FIFO_TX1_8, UART_FIFO_RX6_8);
-    UARTTxIntModeSet(UART1_BASE, UART_TXINT_MODE_EOT);
-    UARTIntRegister(UART1_BASE, bluetooth_uart_isr);
-    UARTIntEnable(UART1_BASE, UART_INT_RX | UART_INT_RT | UART_INT_TX);
-    return;
+    /* and get the module going, which finishes from the main loop */
+    rn42_start();
 }
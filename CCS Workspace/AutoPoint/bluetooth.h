@@ -8,7 +8,32 @@
 #ifndef BLUETOOTH_H_
 #define BLUETOOTH_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
+/* UART baud to the RN42. It boots at BLUETOOTH_BAUD_BOOT (strapped by the 9.6K_BAUD pin), and
+ * the bring-up switches both ends to BLUETOOTH_BAUD_FAST once it's configured (see rn42.h). */
+#define BLUETOOTH_BAUD_BOOT 9600
+#define BLUETOOTH_BAUD_FAST 115200
+
+typedef struct {
+    uint32_t tx_high_water;     /* most ever queued to send */
+    uint32_t tx_overflows;      /* writes turned away, TX buffer full */
+    uint32_t rx_overruns;       /* times the RX DMA lapped the main loop */
+    uint32_t rx_dropped;        /* frames too long, or cut short by an overrun */
+    uint32_t rx_wrapped;        /* frames copied out because they wrapped round rx_buff */
+} bluetooth_stats_t;
+
 void bluetooth_init(void);
 void bluetooth_handle_packets(void);
+bool bluetooth_write(const void* data, uint32_t len);
+bool bluetooth_send(const char* data);
+bool bluetooth_send_frame(uint8_t type, const void* payload, uint32_t len);
+uint32_t bluetooth_tx_pending(void);
+void bluetooth_get_stats(bluetooth_stats_t* out);
+
+void bluetooth_set_baud(uint32_t baud);
+uint32_t bluetooth_get_baud(void);
+uint32_t bluetooth_char_cycles(void);
 
 #endif /* BLUETOOTH_H_ */
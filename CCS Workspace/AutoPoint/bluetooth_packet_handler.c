@@ -1,28 +1,289 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pointing.h"
+#include "horizon.h"
+#include "mount.h"
+#include "pointing_model.h"
+#include "interlock.h"
+#include "setpoint.h"
+#include "util.h"
+#include "bluetooth.h"
+#include "timesync.h"
+#include "linktest.h"
+#include "catalog.h"
+#include "propagator.h"
+#include "telemetry.h"
+#include "frame.h"
+#include "protocol.h"
 #include "bluetooth_packet_handler.h"
 
-/* Packet Format (for now, keeping it ASCII & fixed width)
- *
- * $[ ID x3 ]:[ data ]\n
+/* Packet Format: binary frames, see frame.h for the framing and protocol.h for the messages.
  *
- * UTC Set
- * $1:[ year x4]:[ month x2]:[ day x2]:[ hour x2]:[ min x2]:[ sec x2]:[ ms x3]\n
- *s
+ * Messages are dispatched through the handlers table below, indexed by type. The table also
+ * holds each message's payload length limits, so a handler only ever sees a payload of a size
+ * it can parse. Adding a command is a handler and a line in the table.
  *
+ * Anything that fails (bad frame, unknown type, wrong length, handler said no) is counted in
+ * pkt_errors, and against its type in the stats if the type is known.
  */
 
+#define DEG2RAD (3.14159265f / 180.0f)
+#define ARCSEC2RAD (DEG2RAD / 3600.0f)
+
 uint32_t pkt_errors = 0;
 
-void handle_new_packet(char* pkt, uint32_t len) {
+typedef struct {
+    packet_handler_t handler;
+    uint8_t min_len;
+    uint8_t max_len;
+} packet_entry_t;
+
+static packet_stats_t stats[PROTO_TYPE_COUNT];
+
+static bool parse_table(uint8_t c, horizon_table_t* table) {
+    if (c == 'M') {
+        *table = HORIZON_TABLE_MASK;
+    } else if (c == 'R') {
+        *table = HORIZON_TABLE_REFRACTION;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool handle_site_set(const packet_t* pkt) {
+    const uint8_t* p = pkt->payload;
+    float lat = le_get_f32(&p[0]);
+    float lon = le_get_f32(&p[4]);
+    float alt = le_get_f32(&p[8]);
+
+    return pointing_set_site(lat * DEG2RAD, lon * DEG2RAD, alt * 0.001f);
+}
+
+static bool handle_table_upload(const packet_t* pkt) {
+    const uint8_t* p = pkt->payload;
+    horizon_table_t table;
+
+    if (!parse_table(p[0], &table)) return false;
+    uint32_t offset = le_get_u16(&p[1]);
+
+    return horizon_stage(table, offset, &p[3], pkt->len - 3);
+}
+
+static bool handle_table_commit(const packet_t* pkt) {
+    horizon_table_t table;
+
+    if (!parse_table(pkt->payload[0], &table)) return false;
+    return horizon_commit(table);
+}
+
+static bool handle_table_reset(const packet_t* pkt) {
+    horizon_table_t table;
+
+    if (!parse_table(pkt->payload[0], &table)) return false;
+    return horizon_reset(table);
+}
+
+static bool handle_mount_gains(const packet_t* pkt) {
+    const uint8_t* p = pkt->payload;
+    mount_axis_t axis;
+    mount_pid_gains_t gains = mount_default_gains;
+
+    if (p[0] == 'A') {
+        axis = MOUNT_AXIS_AZ;
+    } else if (p[0] == 'E') {
+        axis = MOUNT_AXIS_EL;
+    } else {
+        return false;
+    }
+
+    /* the packet carries the loop gains, the filter and output limit stay at their defaults */
+    gains.kp = le_get_f32(&p[1]);
+    gains.ki = le_get_f32(&p[5]);
+    gains.kd = le_get_f32(&p[9]);
+    gains.kff = le_get_f32(&p[13]);
+
+    mount_set_gains(axis, &gains);
+    return true;
+}
+
+static bool handle_mount_enable(const packet_t* pkt) {
+    mount_enable(pkt->payload[0] == 1);
+    return true;
+}
+
+static bool handle_pointing_model(const packet_t* pkt) {
+    const uint8_t* p = pkt->payload;
+    float terms[PM_TERM_COUNT];
+
+    for (uint32_t i = 0; i < PM_TERM_COUNT; i++) {
+        terms[i] = le_get_f32(&p[i * 4]) * ARCSEC2RAD;
+    }
+
+    return pointing_model_set(terms);
+}
+
+static bool handle_zone_set(const packet_t* pkt) {
+    const uint8_t* p = pkt->payload;
+    interlock_zone_t zone;
+
+    uint32_t index = p[0];
+    zone.az_min = le_get_f32(&p[1]) * DEG2RAD;
+    zone.az_max = le_get_f32(&p[5]) * DEG2RAD;
+    zone.el_min = le_get_f32(&p[9]) * DEG2RAD;
+    zone.el_max = le_get_f32(&p[13]) * DEG2RAD;
+
+    return interlock_set_zone(index, zone.el_max > zone.el_min ? &zone : NULL);
+}
+
+static bool handle_laser_arm(const packet_t* pkt) {
+    interlock_arm(pkt->payload[0] == 1);
+    return true;
+}
+
+static bool handle_interlock_status(const packet_t* pkt) {
+    interlock_status_t st;
+    setpoint_stats_t sp_stats;
+    uint8_t buf[18];
 
-    /* Do some basic sanity checks on the packet... */
-    if(pkt[0] != '$') goto err;
+    interlock_get_status(&st);
+    setpoint_get_stats(&sp_stats);
 
-    if(pkt[1] == '1') {
-        /* UTC Set */
+    /* a hazard that shows up just after a check is caught on the next tick, which may itself
+     * be late, then takes up to the measured latency to act on */
+    uint32_t worst = UTIL_CLOCK_HZ / SETPOINT_RATE_HZ + sp_stats.max_jitter_cycles + st.max_latency_cycles;
+
+    buf[0] = st.armed;
+    buf[1] = st.laser_on;
+    le_put_u32(&buf[2], st.reasons);
+    le_put_u32(&buf[6], st.trips);
+    le_put_u32(&buf[10], util_cycles_ns(st.max_latency_cycles));
+    le_put_u32(&buf[14], util_cycles_ns(worst));
+
+    return bluetooth_send_frame(PROTO_INTERLOCK_STATUS | PROTO_REPLY, buf, sizeof(buf));
+}
+
+static bool handle_time_request(const packet_t* pkt) {
+    const uint8_t* p = pkt->payload;
+    return timesync_request(le_get_u32(&p[0]), le_get_i64(&p[4]), pkt->rx_cycles, pkt->wire_len);
+}
+
+static bool handle_time_apply(const packet_t* pkt) {
+    const uint8_t* p = pkt->payload;
+    return timesync_apply(le_get_i64(&p[0]), le_get_u32(&p[8]));
+}
+
+static bool handle_link_send(const packet_t* pkt) {
+    return linktest_start_send(le_get_u32(pkt->payload));
+}
+
+static bool handle_link_fill(const packet_t* pkt) {
+    linktest_receive(pkt->wire_len);
+    return true;
+}
+
+static bool handle_link_count(const packet_t* pkt) {
+    return linktest_report();
+}
+
+static bool handle_packet_stats(const packet_t* pkt) {
+    packet_stats_t st;
+    uint8_t buf[17];
+    uint8_t type = pkt->payload[0];
+
+    if (!packet_get_stats(type, &st)) return false;
+
+    uint32_t mean = st.count ? (uint32_t) (st.total_cycles / st.count) : 0;
+
+    buf[0] = type;
+    le_put_u32(&buf[1], st.count);
+    le_put_u32(&buf[5], st.errors);
+    le_put_u32(&buf[9], util_cycles_ns(mean));
+    le_put_u32(&buf[13], util_cycles_ns(st.max_cycles));
+
+    return bluetooth_send_frame(PROTO_PACKET_STATS | PROTO_REPLY, buf, sizeof(buf));
+}
+
+static bool handle_catalog_begin(const packet_t* pkt) {
+    return catalog_upload_begin(pkt->len > 0 ? pkt->payload[0] : 0);
+}
+
+static bool handle_catalog_chunk(const packet_t* pkt) {
+    return catalog_upload_chunk(le_get_u16(pkt->payload), &pkt->payload[2], pkt->len - 2);
+}
+
+static bool handle_catalog_end(const packet_t* pkt) {
+    return catalog_upload_end(le_get_u16(pkt->payload));
+}
+
+static bool handle_catalog_select(const packet_t* pkt) {
+    return propagator_select(le_get_u32(pkt->payload));
+}
+
+static bool handle_telemetry(const packet_t* pkt) {
+    return telemetry_configure(le_get_u16(pkt->payload));
+}
+
+static const packet_entry_t handlers[PROTO_TYPE_COUNT] = {
+    [PROTO_TIME_REQUEST]        = { handle_time_request,        12, 12 },
+    [PROTO_SITE]                = { handle_site_set,            12, 12 },
+    [PROTO_TABLE_UPLOAD]        = { handle_table_upload,        3, FRAME_MAX_PAYLOAD },
+    [PROTO_TABLE_COMMIT]        = { handle_table_commit,        1, 1 },
+    [PROTO_TABLE_RESET]         = { handle_table_reset,         1, 1 },
+    [PROTO_GAINS]               = { handle_mount_gains,         17, 17 },
+    [PROTO_MOUNT_ENABLE]        = { handle_mount_enable,        1, 1 },
+    [PROTO_POINTING_MODEL]      = { handle_pointing_model,      PM_TERM_COUNT * 4, PM_TERM_COUNT * 4 },
+    [PROTO_ZONE]                = { handle_zone_set,            17, 17 },
+    [PROTO_LASER_ARM]           = { handle_laser_arm,           1, 1 },
+    [PROTO_INTERLOCK_STATUS]    = { handle_interlock_status,    0, 0 },
+    [PROTO_TIME_APPLY]          = { handle_time_apply,          12, 12 },
+    [PROTO_LINK_SEND]           = { handle_link_send,           4, 4 },
+    [PROTO_LINK_FILL]           = { handle_link_fill,           0, FRAME_MAX_PAYLOAD },
+    [PROTO_LINK_COUNT]          = { handle_link_count,          0, 0 },
+    [PROTO_PACKET_STATS]        = { handle_packet_stats,        1, 1 },
+    [PROTO_CATALOG_BEGIN]       = { handle_catalog_begin,       0, 1 },
+    [PROTO_CATALOG_CHUNK]       = { handle_catalog_chunk,       2, 2 + CATALOG_CHUNK_MAX },
+    [PROTO_CATALOG_END]         = { handle_catalog_end,         2, 2 },
+    [PROTO_CATALOG_SELECT]      = { handle_catalog_select,      4, 4 },
+    [PROTO_TELEMETRY]           = { handle_telemetry,           2, 2 },
+};
+
+void handle_new_packet(uint8_t* frame, uint32_t len, uint64_t rx_cycles) {
+    uint32_t start = util_clock_cycles();
+    packet_t pkt;
+    uint8_t type;
+    uint8_t* p;
+
+    /* Decode in place and check the CRC, which rejects anything mangled on the way */
+    int32_t n = frame_decode(frame, len, &type, &p);
+    if (n < 0 || type >= PROTO_TYPE_COUNT || handlers[type].handler == NULL) {
+        pkt_errors++;
         return;
     }
 
-    return;
-    err:
+    const packet_entry_t* entry = &handlers[type];
+    packet_stats_t* st = &stats[type];
+    st->count++;
+
+    pkt.payload = p;
+    pkt.len = (uint32_t) n;
+    pkt.wire_len = len + 1;
+    pkt.rx_cycles = rx_cycles;
+
+    if (pkt.len < entry->min_len || pkt.len > entry->max_len || !entry->handler(&pkt)) {
+        st->errors++;
         pkt_errors++;
+    }
+
+    uint32_t cycles = util_clock_cycles() - start;
+    st->total_cycles += cycles;
+    if (cycles > st->max_cycles) st->max_cycles = cycles;
+}
+
+/* Counts and handling time for one message type. False if there's no such type. */
+bool packet_get_stats(uint8_t type, packet_stats_t* out) {
+    if (type >= PROTO_TYPE_COUNT || handlers[type].handler == NULL) return false;
+    *out = stats[type];
+    return true;
 }
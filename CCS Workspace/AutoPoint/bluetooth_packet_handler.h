@@ -8,8 +8,36 @@
 #ifndef BLUETOOTH_PACKET_HANDLER_H_
 #define BLUETOOTH_PACKET_HANDLER_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
-void handle_new_packet(char* pkt, uint32_t len);
+/* A received message, as handed to its handler.
+ *
+ * payload points straight into the bluetooth RX ring unless the frame wrapped round the end of
+ * it, in which case it points at a copy. Either way it's only good for the duration of the call.
+ */
+typedef struct {
+    const uint8_t* payload;
+    uint32_t len;
+    uint32_t wire_len;      /* the whole frame on the wire, delimiter included */
+    uint64_t rx_cycles;     /* util_clock_cycles64() when its delimiter arrived, 0 if unknown */
+} packet_t;
+
+/* Returns false for anything it won't take, which is counted against its type */
+typedef bool (*packet_handler_t)(const packet_t* pkt);
+
+/* Per message type. Handling time covers decode, CRC and handler, in system clock cycles. */
+typedef struct {
+    uint32_t count;
+    uint32_t errors;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+} packet_stats_t;
+
+/* frame: a received frame, still COBS encoded, len bytes without its delimiter (decoded in place).
+ * rx_cycles: util_clock_cycles64() when its delimiter arrived, 0 if unknown */
+void handle_new_packet(uint8_t* frame, uint32_t len, uint64_t rx_cycles);
+
+bool packet_get_stats(uint8_t type, packet_stats_t* out);
 
 #endif /* BLUETOOTH_PACKET_HANDLER_H_ */
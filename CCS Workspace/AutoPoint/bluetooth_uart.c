@@ -0,0 +1,373 @@
+/*
+ * bluetooth_uart.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driverlib/gpio.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/udma.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_gpio.h"
+#include "inc/hw_uart.h"
+#include "driverlib/pin_map.h"
+
+#include "hal.h"
+#include "util.h"
+#include "frame.h"
+#include "bluetooth.h"
+#include "bluetooth_uart.h"
+
+/* BT module pin assignments
+ *
+ * UART RX: PB0 / U1RX
+ * UART TX: PB1 / U1TX
+ * UART RTS: PF0 / U1RTS (PF0 is locked out of reset, see bluetooth_uart_init)
+ * UART CTS: PF1 / U1CTS
+ *
+ * ~RESET:          PE0
+ * 9.6K_BAUD:       PE3
+ * CONNECTED:       PE4
+ */
+
+/* Below the setpoint tick, so bluetooth traffic can never delay motor commands */
+#define BLUETOOTH_INT_PRIORITY 0x40
+
+/* Both directions go through the uDMA controller, so the CPU only sees whole buffers:
+ *
+ * RX: channel 22 runs ping-pong between the two halves of bluetooth_rx_buff. The main loop works
+ *  out how far it has got from the channel's remaining transfer count, and a finished half is only
+ *  re-armed once the main loop has read past it (bluetooth_uart_rx_release()). Until then the
+ *  channel stops, the RX FIFO fills and RTS holds the RN42 off, so a slow main loop loses nothing.
+ *  The UART only
+ *  asks for DMA a burst (8 bytes, half its FIFO) at a time, so whatever is left over at the end of
+ *  a message sits in the FIFO until the receive timeout interrupt, which copies it in by hand and
+ *  moves the channel past it. That interrupt is also where frame delimiters get their arrival time.
+ *
+ * TX: channel 23 sends the contiguous run at the tail of bluetooth_tx_ring in one basic
+ *  transfer, straight out of the buffer. Its completion interrupt consumes that run and starts
+ *  the next.
+ *
+ * Both completions come in on the UART1 vector.
+ */
+#define DMA_CH_RX   UDMA_CHANNEL_UART1RX
+#define DMA_CH_TX   UDMA_CHANNEL_UART1TX
+
+#define RX_HALF_SIZE (BLUETOOTH_RX_BUFF_SIZE / 2)
+
+/* Longest a baud change waits for TX to go out. A wedged module can hold CTS for ever, and the
+ * main loop can't wait on that. */
+#define TX_DRAIN_CYCLES (UTIL_CLOCK_HZ / 50)
+
+/* tx_dma_len bytes from the ring's tail are being sent */
+static volatile uint32_t tx_dma_len = 0;
+
+/* rx_laps counts filled halves, so the absolute count of bytes received is
+ * rx_laps * RX_HALF_SIZE plus however far into the current half the channel is. rx_armed counts
+ * the halves handed to the channel (the first two at init), which is at most two ahead of rx_laps:
+ * fill n goes in half n & 1, and can only be armed once the main loop has read everything up to
+ * the end of fill n - 2, i.e. rx_released has got to (n - 1) * RX_HALF_SIZE. */
+static volatile uint32_t rx_laps = 0;
+static volatile uint32_t rx_armed = 2;
+static volatile uint32_t rx_released = 0;
+static volatile bool rx_stalled = false;
+
+/* The UART's receive timeout (32 bit periods) */
+static uint32_t rx_timeout_cycles = 32 * (UTIL_CLOCK_HZ / BLUETOOTH_BAUD_BOOT);
+
+static uint32_t rx_select(uint32_t half) {
+    return DMA_CH_RX | (half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT);
+}
+
+/* Point one half's control structure at that half of the buffer, starting offset bytes in */
+static void rx_arm(uint32_t half, uint32_t offset) {
+    uDMAChannelTransferSet(rx_select(half), UDMA_MODE_PINGPONG,
+                           (void*) (UART1_BASE + UART_O_DR), &bluetooth_rx_buff[half * RX_HALF_SIZE + offset],
+                           RX_HALF_SIZE - offset);
+}
+
+/* Point a half we've filled by hand at nothing, so the channel stops rather than carry on into it */
+static void rx_disarm(uint32_t half) {
+    uDMAChannelTransferSet(rx_select(half), UDMA_MODE_STOP,
+                           (void*) (UART1_BASE + UART_O_DR), &bluetooth_rx_buff[half * RX_HALF_SIZE],
+                           RX_HALF_SIZE);
+}
+
+/* Absolute count of bytes the DMA has written. Retries if a half completes under us. A half that
+ * isn't armed yet has nothing in it. */
+uint32_t bluetooth_uart_rx_written(void) {
+    uint32_t laps, remaining;
+    do {
+        laps = rx_laps;
+        remaining = laps != rx_armed ? uDMAChannelSizeGet(rx_select(laps & 1)) : RX_HALF_SIZE;
+    } while (laps != rx_laps);
+
+    return laps * RX_HALF_SIZE + RX_HALF_SIZE - remaining;
+}
+
+/* Start sending the next contiguous run of queued data, if the channel is idle */
+static void tx_start(void) {
+    const uint8_t* run;
+
+    if (tx_dma_len != 0) return;
+
+    tx_dma_len = ring_read_span(&bluetooth_tx_ring, &run);
+    if (tx_dma_len == 0) return;
+
+    uDMAChannelTransferSet(DMA_CH_TX | UDMA_PRI_SELECT, UDMA_MODE_BASIC,
+                           (void*) run, (void*) (UART1_BASE + UART_O_DR), tx_dma_len);
+    uDMAChannelEnable(DMA_CH_TX);
+}
+
+/* Main loop, after queueing. The completion interrupt also starts transfers. */
+void bluetooth_uart_tx_start(void) {
+    IntDisable(INT_UART1);
+    tx_start();
+    IntEnable(INT_UART1);
+}
+
+/* Bytes queued for sending that haven't reached the UART FIFO yet */
+uint32_t bluetooth_uart_tx_pending(void) {
+    IntDisable(INT_UART1);
+    uint32_t queued = ring_used(&bluetooth_tx_ring);
+    uint32_t moved = tx_dma_len - uDMAChannelSizeGet(DMA_CH_TX | UDMA_PRI_SELECT);
+    IntEnable(INT_UART1);
+
+    return queued - moved;
+}
+
+/* Drop everything queued for sending, whether it's in the ring, the DMA or the TX FIFO. For a
+ * module that's being reset, which won't take it. Main loop only. */
+void bluetooth_uart_tx_discard(void) {
+    IntDisable(INT_UART1);
+    uDMAChannelDisable(DMA_CH_TX);
+    tx_dma_len = 0;
+
+    uint32_t queued = ring_used(&bluetooth_tx_ring);
+    if (queued != 0) bluetooth_tx_done(queued);
+
+    /* turning the FIFOs off flushes them */
+    UARTFIFODisable(UART1_BASE);
+    UARTFIFOEnable(UART1_BASE);
+    IntEnable(INT_UART1);
+}
+
+/* Once everything queued has gone out, or TX_DRAIN_CYCLES on if it hasn't (what's left is
+ * dropped) */
+void bluetooth_uart_set_baud(uint32_t baud) {
+    uint64_t give_up = hal_cycles64() + TX_DRAIN_CYCLES;
+    while (ring_used(&bluetooth_tx_ring) != 0 || UARTBusy(UART1_BASE)) {
+        if (hal_cycles64() >= give_up) {
+            bluetooth_uart_tx_discard();
+            break;
+        }
+    }
+
+    UARTConfigSetExpClk(UART1_BASE, UTIL_CLOCK_HZ, baud, UART_CONFIG_WLEN_8 | UART_CONFIG_PAR_NONE | UART_CONFIG_STOP_ONE);
+
+    IntDisable(INT_UART1);
+    rx_timeout_cycles = 32 * (UTIL_CLOCK_HZ / baud);
+    IntEnable(INT_UART1);
+}
+
+void bluetooth_uart_pin_reset(bool assert) {
+    GPIOPinWrite(GPIO_PORTE_BASE, (1<<0), assert ? 0 : (1<<0));
+}
+
+void bluetooth_uart_pin_force_baud(bool force) {
+    GPIOPinWrite(GPIO_PORTE_BASE, (1<<3), force ? (1<<3) : 0);
+}
+
+/* Count the RX halves the DMA has finished, and re-arm the ones the main loop has read past */
+static void rx_complete(void) {
+    while (rx_laps != rx_armed && uDMAChannelModeGet(rx_select(rx_laps & 1)) == UDMA_MODE_STOP) {
+        rx_laps++;
+    }
+    while (rx_armed - rx_laps < 2 && (int32_t) (rx_released - (rx_armed - 1) * RX_HALF_SIZE) >= 0) {
+        rx_arm(rx_armed & 1, 0);
+        rx_armed++;
+    }
+}
+
+/* Nowhere to put what's in the RX FIFO: leave the channel off and the rest in the FIFO (which
+ * holds the RN42 off on RTS once it fills), and stop taking receive timeouts over it, until
+ * bluetooth_uart_rx_release() makes room */
+static void rx_stall(void) {
+    rx_stalled = true;
+    UARTIntDisable(UART1_BASE, UART_INT_RT);
+}
+
+/* Main loop: everything before absolute RX position read has been dealt with, so the halves it
+ * was in can take more */
+void bluetooth_uart_rx_release(uint32_t read) {
+    IntDisable(INT_UART1);
+    rx_released = read;
+    rx_complete();
+    if (rx_stalled && rx_armed != rx_laps) {
+        rx_stalled = false;
+        uDMAChannelEnable(DMA_CH_RX);
+        UARTIntEnable(UART1_BASE, UART_INT_RT);
+    }
+    IntEnable(INT_UART1);
+}
+
+/* Receive timeout: the end of a message is stuck in the FIFO below the DMA burst size. Copy it
+ * to where the DMA would have put it, and restart the channel after it. */
+static void rx_tail(void) {
+    uDMAChannelDisable(DMA_CH_RX);
+    rx_complete();
+    if (rx_armed == rx_laps) {
+        rx_stall();
+        return;
+    }
+
+    /* everything drained took a character time each, and the timeout fires a fixed time
+     * after the last one */
+    uint64_t now = hal_cycles64() - rx_timeout_cycles;
+    uint32_t char_cycles = bluetooth_char_cycles();
+
+    uint32_t half = rx_laps & 1;
+    uint32_t pos = RX_HALF_SIZE - uDMAChannelSizeGet(rx_select(half));
+    uint32_t start = rx_laps * RX_HALF_SIZE + pos;
+    uint32_t nl_at[4];
+    uint32_t nl_count = 0;
+    uint32_t drained = 0;
+
+    int32_t data;
+    while ((data = UARTCharGetNonBlocking(UART1_BASE)) != -1) {
+        bluetooth_rx_buff[half * RX_HALF_SIZE + pos] = data;
+        if (data == FRAME_DELIM && nl_count < 4) nl_at[nl_count++] = drained;
+        drained++;
+
+        if (++pos == RX_HALF_SIZE) {
+            /* filled this half by hand: carry on in the other one, if it's been read */
+            rx_disarm(half);
+            rx_laps++;
+            half ^= 1;
+            pos = 0;
+            if (half) {
+                uDMAChannelAttributeEnable(DMA_CH_RX, UDMA_ATTR_ALTSELECT);
+            } else {
+                uDMAChannelAttributeDisable(DMA_CH_RX, UDMA_ATTR_ALTSELECT);
+            }
+            if (rx_armed == rx_laps) break;
+        }
+    }
+
+    if (rx_armed != rx_laps) {
+        rx_arm(half, pos);
+        uDMAChannelEnable(DMA_CH_RX);
+    } else {
+        rx_stall();
+    }
+
+    for (uint32_t i = 0; i < nl_count; i++) {
+        bluetooth_rx_stamp(start + nl_at[i], now - (uint64_t) (drained - 1 - nl_at[i]) * char_cycles);
+    }
+}
+
+static void bluetooth_uart_isr(void) {
+    uint32_t cause = UARTIntStatus(UART1_BASE, true);
+    UARTIntClear(UART1_BASE, cause);
+
+    uint32_t done = uDMAIntStatus() & ((1 << DMA_CH_RX) | (1 << DMA_CH_TX));
+    uDMAIntClear(done);
+
+    if (done & (1 << DMA_CH_TX)) {
+        bluetooth_tx_done(tx_dma_len);
+        tx_dma_len = 0;
+        tx_start();
+    }
+
+    if (cause & UART_INT_RT) {
+        rx_tail();
+    } else if (done & (1 << DMA_CH_RX)) {
+        rx_complete();
+        /* the channel stops itself on a half that isn't armed: carry on if it is now, or wait for
+         * the main loop to read past one */
+        if (!uDMAChannelIsEnabled(DMA_CH_RX)) {
+            if (rx_armed != rx_laps) {
+                uDMAChannelEnable(DMA_CH_RX);
+            } else {
+                rx_stall();
+            }
+        }
+    }
+}
+
+void bluetooth_uart_init(uint32_t baud) {
+
+    /* initialize UART comm pins */
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOB));
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOE));
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOF));
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART1);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_UART1));
+
+    /* Configure GPIO pins */
+    GPIOPinTypeGPIOOutput(GPIO_PORTE_BASE, (1<<0) | (1<<3));
+    GPIOPinTypeGPIOInput(GPIO_PORTE_BASE, (1<<4));
+
+    /* PF0 doubles as NMI, so it has to be unlocked before it can be muxed to anything else */
+    HWREG(GPIO_PORTF_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+    HWREG(GPIO_PORTF_BASE + GPIO_O_CR) |= (1<<0);
+    HWREG(GPIO_PORTF_BASE + GPIO_O_LOCK) = 0;
+
+    /* Configure UART pins: drive settings */
+    GPIOPinTypeUART(GPIO_PORTB_BASE, (1<<0) | (1<<1));
+    GPIOPinTypeUART(GPIO_PORTF_BASE, (1<<0) | (1<<1));
+
+    /* Configure UART pins: set pinmux */
+    GPIOPinConfigure(GPIO_PB0_U1RX);
+    GPIOPinConfigure(GPIO_PB1_U1TX);
+    GPIOPinConfigure(GPIO_PF0_U1RTS);
+    GPIOPinConfigure(GPIO_PF1_U1CTS);
+
+    /* Configure comm UART:
+     * UART 1
+     * UTIL_CLOCK_HZ system clock
+     * baud (BLUETOOTH_BAUD_BOOT, until the bring-up switches it)
+     * 8, N, 1
+     * RTS/CTS flow control, so the RN42 holds off while our RX FIFO is full (and vice versa) */
+    UARTConfigSetExpClk(UART1_BASE, UTIL_CLOCK_HZ, baud, UART_CONFIG_WLEN_8 | UART_CONFIG_PAR_NONE | UART_CONFIG_STOP_ONE);
+    UARTFlowControlSet(UART1_BASE, UART_FLOWCONTROL_TX | UART_FLOWCONTROL_RX);
+    UARTEnable(UART1_BASE);
+    rx_timeout_cycles = 32 * (UTIL_CLOCK_HZ / baud);
+
+    /* Start receiving into the first half, with the second queued up behind it. The UART asks for
+     * a burst once the RX FIFO is half full, and for TX whenever there's room. */
+    uDMAChannelAssign(UDMA_CH22_UART1RX);
+    uDMAChannelAssign(UDMA_CH23_UART1TX);
+    uDMAChannelAttributeDisable(DMA_CH_RX, UDMA_ATTR_ALL);
+    uDMAChannelAttributeDisable(DMA_CH_TX, UDMA_ATTR_ALL);
+    uDMAChannelAttributeEnable(DMA_CH_RX, UDMA_ATTR_USEBURST);
+
+    uDMAChannelControlSet(DMA_CH_RX | UDMA_PRI_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_8);
+    uDMAChannelControlSet(DMA_CH_RX | UDMA_ALT_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_8);
+    uDMAChannelControlSet(DMA_CH_TX | UDMA_PRI_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4);
+    rx_arm(0, 0);
+    rx_arm(1, 0);
+    uDMAChannelEnable(DMA_CH_RX);
+
+    UARTFIFOLevelSet(UART1_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    UARTDMAEnable(UART1_BASE, UART_DMA_RX | UART_DMA_TX);
+
+    /* Enable interrupts: RX timeout. DMA completions come in on the same vector. */
+    UARTIntRegister(UART1_BASE, bluetooth_uart_isr);
+    IntPrioritySet(INT_UART1, BLUETOOTH_INT_PRIORITY);
+    UARTIntEnable(UART1_BASE, UART_INT_RT);
+}
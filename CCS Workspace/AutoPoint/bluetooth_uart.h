@@ -0,0 +1,61 @@
+/*
+ * bluetooth_uart.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef BLUETOOTH_UART_H_
+#define BLUETOOTH_UART_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ring.h"
+
+/* The UART under bluetooth.c, which moves bytes between the RN42 and the buffers bluetooth.c
+ * owns. bluetooth_uart.c does it with UART1 and the uDMA; on a PC, host/sim_uart.c stands in for
+ * it with a pty (see host/). Only bluetooth.c and rn42.c should need this.
+ *
+ * RX: the UART side fills bluetooth_rx_buff as a ring and counts every byte it has ever written.
+ *  bluetooth.c reads behind it and hands back what it's done with through
+ *  bluetooth_uart_rx_release(); the UART side holds the RN42 off with RTS rather than write over
+ *  anything before that. bluetooth.c still notices if it has been lapped. Frame delimiters get their
+ *  arrival time through bluetooth_rx_stamp(), when the UART side knows it.
+ *
+ * TX: bluetooth.c queues into bluetooth_tx_ring and calls bluetooth_uart_tx_start(), main loop
+ *  only. The UART side sends from the ring's read end and hands back what's gone with
+ *  bluetooth_tx_done().
+ *
+ * Those two calls are all the firmware sees of the UART side's timing, and what trace.h records
+ * of it. The UART side reads the clock with hal_cycles64(), not util_clock_cycles64(), so its
+ * own reads stay out of the trace.
+ */
+
+/* Powers of two. TX is also the most one uDMA transfer can move. */
+#define BLUETOOTH_RX_BUFF_SIZE  1024
+#define BLUETOOTH_TX_BUFF_SIZE  1024
+
+extern uint8_t bluetooth_rx_buff[BLUETOOTH_RX_BUFF_SIZE];
+extern ring_t bluetooth_tx_ring;
+
+/* In bluetooth.c, for the UART side to call: the delimiter at absolute RX position pos came in at
+ * util_clock_cycles64() time cycles. In order, from one context. */
+void bluetooth_rx_stamp(uint32_t pos, uint64_t cycles);
+
+/* In bluetooth.c, for the UART side to call: len bytes from the TX ring's read end have been sent */
+void bluetooth_tx_done(uint32_t len);
+
+void bluetooth_uart_init(uint32_t baud);
+uint32_t bluetooth_uart_rx_written(void);
+void bluetooth_uart_rx_release(uint32_t read);
+void bluetooth_uart_tx_start(void);
+void bluetooth_uart_tx_discard(void);
+uint32_t bluetooth_uart_tx_pending(void);
+void bluetooth_uart_set_baud(uint32_t baud);
+
+/* RN42 control lines: ~RESET, and 9.6K_BAUD (module comes up at BLUETOOTH_BAUD_BOOT) */
+void bluetooth_uart_pin_reset(bool assert);
+void bluetooth_uart_pin_force_baud(bool force);
+
+#endif /* BLUETOOTH_UART_H_ */
@@ -0,0 +1,348 @@
+/*
+ * catalog.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bluetooth.h"
+#include "frame.h"
+#include "protocol.h"
+#include "tle.h"
+#include "catalog.h"
+
+/* 'a' for AFSPC, 'i' for "improved" */
+const char opsmode = 'i';
+
+/* WGS72 or WGS84 mode. WGS84, since we're using this stuff with GPS data. */
+const gravconsttype whichconst = wgs84;
+
+/* Until something gets uploaded */
+static const char default_name[] = "ISS (ZARYA)";
+static const char default_line1[] = "1 25544U 98067A   17360.63489756  .00001290  00000-0  26644-4 0  9993";
+static const char default_line2[] = "2 25544  51.6415 158.9361 0002587 294.1321 164.6117 15.54215205 91681";
+
+/* Longest text line we'll hold (TLE lines are 69, names 24) */
+#define TLE_BUFF_LEN    130
+
+static catalog_entry_t entries[CATALOG_SIZE];
+static uint32_t entry_count = 0;
+static uint32_t revision = 0;
+
+/* sgp4init's output, checked before it goes over a catalog entry */
+static elsetrec scratch;
+
+/* Upload in progress. The stream is cut into lines as it arrives; line 1 of a set waits in
+ * pending_line1 for its line 2. */
+static bool upload_active = false;
+static bool upload_delta;
+static catalog_progress_t progress;
+static uint32_t since_ack;
+static bool nacked;
+static uint16_t nack_seq;
+
+static char line[TLE_BUFF_LEN];
+static uint32_t line_len;
+static bool line_long;
+
+static char pending_name[CATALOG_NAME_LEN + 1];
+static char pending_line1[TLE_BUFF_LEN];
+static bool have_line1;
+
+/* Delta uploads: the record being received, record_want bytes long */
+static uint8_t record[255];
+static uint32_t record_len;
+static uint32_t record_want;
+
+static catalog_entry_t* find(uint32_t norad) {
+    for (uint32_t i = 0; i < entry_count; i++) {
+        if (entries[i].elements.norad == norad) return &entries[i];
+    }
+    return NULL;
+}
+
+/* Put a set in the catalog, over any older set for the same satellite. This is the one place
+ * sgp4init runs, a few hundred us per set. */
+static bool catalog_add(const char* name, const tle_elements_t* el) {
+    catalog_entry_t* e = find(el->norad);
+    if (e == NULL && entry_count >= CATALOG_SIZE) return false;
+
+    if (!tle_init_satrec(el, whichconst, opsmode, &scratch)) return false;
+
+    if (e == NULL) {
+        e = &entries[entry_count++];
+        e->name[0] = '\0';
+    }
+    e->revision = ++revision;
+    e->elements = *el;
+    tle_epoch(el, &e->epoch);
+    if (name != NULL) {
+        strncpy(e->name, name, CATALOG_NAME_LEN);
+        e->name[CATALOG_NAME_LEN] = '\0';
+    }
+    e->satrec = scratch;
+    return true;
+}
+
+static bool catalog_add_text(const char* name, const char* line1, const char* line2) {
+    tle_elements_t el;
+    return tle_parse(line1, line2, &el) && catalog_add(name, &el);
+}
+
+void catalog_init(void) {
+    entry_count = 0;
+    catalog_add_text(default_name, default_line1, default_line2);
+}
+
+uint32_t catalog_count(void) {
+    return entry_count;
+}
+
+const catalog_entry_t* catalog_get(uint32_t index) {
+    return index < entry_count ? &entries[index] : NULL;
+}
+
+const catalog_entry_t* catalog_find(uint32_t norad) {
+    return find(norad);
+}
+
+/* One whole line of the upload, without its line end */
+static void upload_line(const char* l, uint32_t len) {
+    if (len == 0) return;
+
+    if (l[0] == '1' && l[1] == ' ') {
+        if (have_line1) progress.errors++;
+        memcpy(pending_line1, l, len + 1);
+        have_line1 = true;
+        return;
+    }
+
+    if (l[0] == '2' && l[1] == ' ') {
+        if (!have_line1) {
+            progress.errors++;
+            return;
+        }
+        if (catalog_add_text(pending_name, pending_line1, l)) {
+            progress.sets++;
+        } else {
+            progress.errors++;
+        }
+        have_line1 = false;
+        pending_name[0] = '\0';
+        return;
+    }
+
+    /* anything else is a name line (3 line sets), with or without the "0 " */
+    if (have_line1) progress.errors++;
+    have_line1 = false;
+
+    if (len >= 2 && l[0] == '0' && l[1] == ' ') {
+        l += 2;
+        len -= 2;
+    }
+    while (len > 0 && l[len - 1] == ' ') len--;
+    if (len > CATALOG_NAME_LEN) len = CATALOG_NAME_LEN;
+    memcpy(pending_name, l, len);
+    pending_name[len] = '\0';
+}
+
+static void upload_byte(uint8_t c) {
+    if (c == '\r') return;
+
+    if (c == '\n') {
+        if (line_long) {
+            progress.errors++;
+            have_line1 = false;
+        } else {
+            line[line_len] = '\0';
+            upload_line(line, line_len);
+        }
+        line_len = 0;
+        line_long = false;
+        return;
+    }
+
+    if (line_len < sizeof(line) - 1) {
+        line[line_len++] = (char) c;
+    } else {
+        line_long = true;
+    }
+}
+
+static bool get_varint(const uint8_t** p, const uint8_t* end, uint32_t* out) {
+    uint32_t v = 0;
+
+    for (uint32_t shift = 0; shift < 35 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        v |= (uint32_t) (b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool get_zigzag(const uint8_t** p, const uint8_t* end, int32_t* out) {
+    uint32_t u;
+    if (!get_varint(p, end, &u)) return false;
+    *out = (int32_t) (u >> 1) ^ -(int32_t) (u & 1);
+    return true;
+}
+
+static uint32_t wrap_deg(uint32_t a, int32_t d) {
+    int32_t v = ((int32_t) a + d) % TLE_DEG_FULL;
+    return (uint32_t) (v < 0 ? v + TLE_DEG_FULL : v);
+}
+
+/* Apply one delta record to the resident set it names. Only a set that actually changed goes
+ * back through sgp4init. */
+static bool apply_delta(const uint8_t* p, uint32_t len) {
+    const uint8_t* end = p + len;
+    uint32_t norad, base_day, base_frac, mask;
+    int32_t d[CATALOG_DELTA_FIELDS];
+
+    if (!get_varint(&p, end, &norad) || !get_varint(&p, end, &base_day) ||
+        !get_varint(&p, end, &base_frac) || !get_varint(&p, end, &mask)) {
+        return false;
+    }
+
+    /* only against the exact set the phone thinks we have */
+    const catalog_entry_t* e = find(norad);
+    if (e == NULL || e->elements.epoch_day != (int32_t) base_day || e->elements.epoch_frac != base_frac) return false;
+
+    for (uint32_t i = 0; i < CATALOG_DELTA_FIELDS; i++) {
+        d[i] = 0;
+        if ((mask & (1u << i)) && !get_zigzag(&p, end, &d[i])) return false;
+    }
+    if (p != end || (mask >> CATALOG_DELTA_FIELDS) != 0) return false;
+    if (mask == 0) return true;
+
+    tle_elements_t el = e->elements;
+    int64_t epoch = (int64_t) el.epoch_day * 100000000 + el.epoch_frac + d[0];
+    el.epoch_day = (int32_t) (epoch / 100000000);
+    el.epoch_frac = (uint32_t) (epoch % 100000000);
+    el.ndot += d[1];
+    el.nddot_m += d[2];
+    el.nddot_e += d[3];
+    el.bstar_m += d[4];
+    el.bstar_e += d[5];
+    el.inclo += d[6];
+    el.nodeo = wrap_deg(el.nodeo, d[7]);
+    el.ecco += d[8];
+    el.argpo = wrap_deg(el.argpo, d[9]);
+    el.mo = wrap_deg(el.mo, d[10]);
+    el.no += d[11];
+
+    return tle_valid(&el) && catalog_add(NULL, &el);
+}
+
+/* Delta uploads are a run of u8 length, record */
+static void delta_byte(uint8_t c) {
+    if (record_want == 0) {
+        record_want = c;
+        record_len = 0;
+        return;
+    }
+
+    record[record_len++] = c;
+    if (record_len < record_want) return;
+
+    if (apply_delta(record, record_len)) {
+        progress.sets++;
+    } else {
+        progress.errors++;
+    }
+    record_want = 0;
+}
+
+static bool send_progress(uint8_t type, catalog_status_t status) {
+    uint8_t buf[7];
+
+    le_put_u16(&buf[0], progress.next_seq);
+    le_put_u16(&buf[2], progress.sets);
+    le_put_u16(&buf[4], progress.errors);
+    buf[6] = status;
+    return bluetooth_send_frame(type | PROTO_REPLY, buf, sizeof(buf));
+}
+
+/* Start an upload. Unless it's a merge (or a delta upload, which always is) the catalog is
+ * emptied first. The propagator keeps its own copy of whatever it's tracking, so that carries on
+ * undisturbed until a new set for it comes in. */
+bool catalog_upload_begin(uint8_t flags) {
+    uint8_t buf[4];
+
+    if (flags & ~(CATALOG_BEGIN_MERGE | CATALOG_BEGIN_DELTA)) return false;
+
+    if (!(flags & (CATALOG_BEGIN_MERGE | CATALOG_BEGIN_DELTA))) entry_count = 0;
+    upload_active = true;
+    upload_delta = (flags & CATALOG_BEGIN_DELTA) != 0;
+    memset(&progress, 0, sizeof(progress));
+    since_ack = 0;
+    nacked = false;
+    line_len = 0;
+    line_long = false;
+    have_line1 = false;
+    pending_name[0] = '\0';
+    record_want = 0;
+
+    buf[0] = CATALOG_WINDOW;
+    buf[1] = CATALOG_CHUNK_MAX;
+    le_put_u16(&buf[2], CATALOG_SIZE);
+    return bluetooth_send_frame(PROTO_CATALOG_BEGIN | PROTO_REPLY, buf, sizeof(buf));
+}
+
+/* One chunk of the stream. A lost acknowledgement isn't an error here: the phone times out and
+ * resends, and the repeat gets one. */
+bool catalog_upload_chunk(uint16_t seq, const uint8_t* data, uint32_t len) {
+    if (!upload_active || len > CATALOG_CHUNK_MAX) return false;
+
+    if (seq != progress.next_seq) {
+        /* a gap or a repeat: say where we are, once per pass of the phone's window (a seq at or
+         * before the last one we answered means it has gone back and started a new pass) */
+        if (nacked && (int16_t) (seq - nack_seq) > 0) return true;
+        nacked = true;
+        nack_seq = seq;
+        send_progress(PROTO_CATALOG_CHUNK, CATALOG_STATUS_RESEND);
+        return true;
+    }
+
+    progress.next_seq++;
+    nacked = false;
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (upload_delta) {
+            delta_byte(data[i]);
+        } else {
+            upload_byte(data[i]);
+        }
+    }
+
+    if (++since_ack >= CATALOG_ACK_EVERY) {
+        since_ack = 0;
+        send_progress(PROTO_CATALOG_CHUNK, CATALOG_STATUS_ACK);
+    }
+    return true;
+}
+
+/* The phone has sent chunks [0, chunks). Done if we have them all, otherwise the answer says
+ * where to resend from. Repeats of a finished upload's end get the same answer. */
+bool catalog_upload_end(uint16_t chunks) {
+    bool done = chunks == progress.next_seq;
+
+    if (!upload_active && !done) return false;
+
+    if (upload_active && done) {
+        /* last line without a line end (or a delta record cut short, which is just lost) */
+        if (!upload_delta && line_len > 0) upload_byte('\n');
+        if (upload_delta && record_want != 0) progress.errors++;
+        upload_active = false;
+    }
+    since_ack = 0;
+    return send_progress(PROTO_CATALOG_END, done ? CATALOG_STATUS_DONE : CATALOG_STATUS_RESEND);
+}
@@ -0,0 +1,115 @@
+/*
+ * catalog.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef CATALOG_H_
+#define CATALOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clock.h"
+#include "sgp4_wrapper.h"
+#include "tle.h"
+
+/* Element set catalog, loaded over bluetooth.
+ *
+ * Holds up to CATALOG_SIZE satellites, each already through sgp4init so the propagator can pick
+ * one up without parsing anything. It starts out holding the built-in ISS set.
+ *
+ * Upload streams plain TLE text (2 or 3 line sets, '\n' or "\r\n" line ends) in numbered chunks
+ * of up to CATALOG_CHUNK_MAX bytes. Chunks may split lines anywhere. The phone keeps up to
+ * CATALOG_WINDOW chunks in flight without waiting for an answer; we acknowledge cumulatively
+ * (the next chunk we want) every CATALOG_ACK_EVERY chunks, and straight away on a gap or a
+ * repeat, which is the phone's cue to go back and resend from there (go-back-N). Chunks past a
+ * gap are dropped, so the stream is always parsed in order.
+ *
+ * Each set is parsed as soon as its line 2 arrives, so the start of the catalog is usable while
+ * the rest is still coming in. Sets with a bad checksum, mismatched catalog numbers or that sgp4
+ * won't take are skipped and counted.
+ *
+ * An upload normally replaces the catalog. A merge upload (CATALOG_BEGIN_MERGE) keeps what's there
+ * and only adds or replaces the sets it carries.
+ *
+ * Delta uploads (CATALOG_BEGIN_DELTA) refresh resident sets without resending them. The stream is
+ * then a run of u8 length, record, where a record is LEB128 varints
+ *
+ *  norad, base epoch day, base epoch frac, field mask, then a zigzag delta per set mask bit
+ *
+ * against the set we hold, in tle_elements_t units, in catalog_delta_field_t order. The base epoch
+ * (tle_elements_t's epoch_day and epoch_frac) has to match the resident set exactly or the record
+ * is skipped and counted, and the phone should send that set whole in a merge upload. A daily
+ * refresh is about 30 bytes a set against 140 for the TLE text, sets that didn't change aren't
+ * sent at all, and only the ones that did go through sgp4init again.
+ *
+ * The window is sized so a full window of chunks fits in the bluetooth RX ring with room to spare.
+ */
+
+#define CATALOG_SIZE        16
+#define CATALOG_NAME_LEN    24
+
+#define CATALOG_CHUNK_MAX   128
+#define CATALOG_WINDOW      4
+#define CATALOG_ACK_EVERY   2
+
+/* Catalog Begin flags */
+#define CATALOG_BEGIN_MERGE 0x01
+#define CATALOG_BEGIN_DELTA 0x02
+
+/* Delta record fields, mask bit n is field n. Angles wrap, everything else just adds. */
+typedef enum {
+    CATALOG_DELTA_EPOCH = 0,    /* 1e-8 day */
+    CATALOG_DELTA_NDOT,
+    CATALOG_DELTA_NDDOT_M,
+    CATALOG_DELTA_NDDOT_E,
+    CATALOG_DELTA_BSTAR_M,
+    CATALOG_DELTA_BSTAR_E,
+    CATALOG_DELTA_INCLO,
+    CATALOG_DELTA_NODEO,
+    CATALOG_DELTA_ECCO,
+    CATALOG_DELTA_ARGPO,
+    CATALOG_DELTA_MO,
+    CATALOG_DELTA_NO,
+    CATALOG_DELTA_FIELDS
+} catalog_delta_field_t;
+
+typedef struct {
+    uint32_t revision;          /* changes whenever this set is replaced */
+    tle_elements_t elements;    /* as uploaded, what deltas apply to */
+    clock_time_t epoch;         /* full precision, satrec.jdsatepoch is only a float */
+    char name[CATALOG_NAME_LEN + 1];
+    elsetrec satrec;
+} catalog_entry_t;
+
+/* Last byte of an acknowledgement */
+typedef enum {
+    CATALOG_STATUS_ACK = 0,     /* have everything before next seq */
+    CATALOG_STATUS_DONE,        /* have it all, upload finished */
+    CATALOG_STATUS_RESEND       /* missing next seq, go back and send from there */
+} catalog_status_t;
+
+/* Upload progress, as sent in acknowledgements */
+typedef struct {
+    uint16_t next_seq;          /* next chunk we want */
+    uint16_t sets;              /* sets loaded this upload */
+    uint16_t errors;            /* sets skipped this upload */
+} catalog_progress_t;
+
+/* sgp4 settings for everything in the catalog */
+extern const char opsmode;
+extern const gravconsttype whichconst;
+
+void catalog_init(void);
+
+uint32_t catalog_count(void);
+const catalog_entry_t* catalog_get(uint32_t index);
+const catalog_entry_t* catalog_find(uint32_t norad);
+
+bool catalog_upload_begin(uint8_t flags);
+bool catalog_upload_chunk(uint16_t seq, const uint8_t* data, uint32_t len);
+bool catalog_upload_end(uint16_t chunks);
+
+#endif /* CATALOG_H_ */
@@ -5,34 +5,209 @@
  *      Author: james
  */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <math.h>
 
+#include "hal.h"
+#include "util.h"
 #include "clock.h"
+#include "trace.h"
 
-/* Use a 64-bit wide timer to use as our "time since epoch" clock */
+#define US_PER_DAY      86400000000ll
+#define CYCLES_PER_US   (UTIL_CLOCK_HZ / 1000000)
+
+/* Battery-backed hibernation memory layout */
+#define HIB_MAGIC       0x41504354 /* "APCT" */
+#define HIB_WORDS       3           /* magic, microseconds past the RTC second, rate */
+
+/* Placeholder time until the clock is set, same as the old hardcoded date */
+#define DEFAULT_UTC_US  (18 * 3600 * 1000000ll)     /* 2000-01-01 18:00 */
+
+/* Drift estimation, see clock_discipline() */
+#define RATE_LIMIT_PPM      500.0f      /* way past any crystal that's working */
+#define DRIFT_INITIAL_PPM   50.0f       /* 1 sigma before the first estimate */
+#define DRIFT_WALK_PPM2_S   1e-6f       /* how fast the crystal can wander (temperature), ppm^2/s */
+#define DRIFT_MIN_GAP_S     30.0f       /* syncs closer than this don't say much about frequency */
+
+#define SYNC_BUDGET_US      1000.0f     /* resync before drift could have added this much error */
+#define SYNC_MIN_S          60
+#define SYNC_MAX_S          (4 * 3600)
+
+/* UTC (microseconds since 2000-01-01) at anchor_cycles. Only changed by the main loop. */
+static int64_t anchor_us;
+static uint64_t anchor_cycles;
+static bool is_set = false;
+
+/* Bumped whenever the clock is set or stepped, so anything caching derived time can tell */
+static uint32_t generation;
+
+/* Frequency correction on the cycle counter, in units of 2^-32 (so 1 ppm ~ 4295) */
+static int32_t rate = 0;
+
+/* Frequency error estimate (ppm) and its variance (ppm^2) */
+static float drift_ppm = 0.0f;
+static float drift_var = DRIFT_INITIAL_PPM * DRIFT_INITIAL_PPM;
+
+static bool synced = false;
+static uint64_t last_sync_cycles;
+static uint32_t last_sync_uncertainty_us;
+
+static int64_t utc_us_at(uint64_t cycles) {
+    int64_t elapsed = (int64_t) (cycles - anchor_cycles) / CYCLES_PER_US;
+    return anchor_us + elapsed + elapsed * rate / (1ll << 32);
+}
+
+/* Bring up the battery backed RTC and pick up the time from it, if it was ever set. */
 void clock_init() {
+    bool running = trace_value(hal_rtc_init());
+
+    uint32_t hib[HIB_WORDS];
+    hal_rtc_data_get(hib, HIB_WORDS);
+    for (uint32_t i = 0; i < HIB_WORDS; i++) hib[i] = trace_value(hib[i]);
 
+    if (running && hib[0] == HIB_MAGIC) {
+        uint32_t sec, subsec;
+        hal_rtc_read(&sec, &subsec);
+        sec = trace_value(sec);
+        subsec = trace_value(subsec);
+        anchor_cycles = util_clock_cycles64();
+        anchor_us = (int64_t) sec * 1000000 + ((int64_t) subsec * 1000000) / HAL_RTC_SUBSEC_HZ + hib[1];
+        is_set = true;
+
+        /* last known crystal error, as a starting point */
+        rate = (int32_t) hib[2];
+        drift_ppm = rate * (1e6f / 4294967296.0f);
+    } else {
+        anchor_cycles = util_clock_cycles64();
+        anchor_us = DEFAULT_UTC_US;
+        is_set = false;
+    }
 }
 
-/* Returns the julian day value for a given time IN UTC:
- * year: like "2017"
- * month: range 1-12
- * day: 0-31ish or w/e
- */
-static float jday(uint32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t min, uint32_t sec, uint32_t msec) {
-    return (
-            367.0f * year
-            - floorf((7.0f * (year + floorf((month + 9.0f) / 12.0f))) * 0.25f)
-            + floorf( 275 * month / 9.0f )
-            + day
-            + 1721013.5f
-            + ((sec / 60.0f + min) / 60.0f + hour) / 24.0f
-            + msec * 1.15471e-8f
-            );
-}
-
-float clock_now_jday(void);
-
-float clock_set_utc(uint32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t min, uint32_t sec, uint32_t msec) {
-    return jday(2000, 1, 1, 18, 0, 0, 0);
+bool clock_is_set(void) {
+    return is_set;
+}
+
+/* Make 'us' the time at 'cycles'. The RTC gets the whole seconds (loading it clears its subsecond
+ * counter) and the leftover microseconds go in hibernation memory. */
+static void set_us(uint64_t cycles, int64_t us) {
+    anchor_cycles = cycles;
+    anchor_us = us;
+    is_set = true;
+    generation++;
+
+    /* the RTC load happens now, not at 'cycles' */
+    us = utc_us_at(util_clock_cycles64());
+
+    uint32_t hib[HIB_WORDS];
+    hib[0] = HIB_MAGIC;
+    hib[1] = (uint32_t) (us % 1000000);
+    hib[2] = (uint32_t) rate;
+    hal_rtc_set((uint32_t) (us / 1000000));
+    hal_rtc_data_set(hib, HIB_WORDS);
+}
+
+/* Set the clock to the given UTC time, taken as right now */
+void clock_set_utc(uint32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t min, uint32_t sec, uint32_t msec) {
+    int64_t us = (int64_t) tconv_days_from_civil(year, month, day) * US_PER_DAY
+               + ((int64_t) ((hour * 60 + min) * 60 + sec) * 1000 + msec) * 1000;
+
+    set_us(util_clock_cycles64(), us);
+}
+
+/* Step the clock by offset microseconds (positive = forwards) */
+void clock_adjust_us(int64_t offset) {
+    uint64_t now = util_clock_cycles64();
+    set_us(now, utc_us_at(now) + offset);
+}
+
+/* Apply a time sync: step the clock by offset microseconds (measured to +- uncertainty) and use
+ * it to refine the crystal frequency estimate.
+ *
+ * After the first sync the clock runs on the current estimate, so any offset the next sync finds
+ * is the residual frequency error times the time in between. That's one measurement of the
+ * residual (ppm = us/s) with a variance from the two syncs' uncertainties, which goes through a
+ * scalar Kalman update. The estimate's variance grows slowly with time to let it follow
+ * temperature changes. */
+void clock_discipline(int64_t offset_us, uint32_t uncertainty_us) {
+    uint64_t now = util_clock_cycles64();
+
+    if (synced) {
+        float gap = (float) (now - last_sync_cycles) * (1.0f / UTIL_CLOCK_HZ);
+
+        if (gap >= DRIFT_MIN_GAP_S) {
+            float residual = (float) offset_us / gap;
+            float sigma = (float) (uncertainty_us + last_sync_uncertainty_us) / gap;
+
+            drift_var += DRIFT_WALK_PPM2_S * gap;
+            float k = drift_var / (drift_var + sigma * sigma);
+            drift_ppm += k * residual;
+            drift_var *= 1.0f - k;
+
+            if (drift_ppm > RATE_LIMIT_PPM) drift_ppm = RATE_LIMIT_PPM;
+            if (drift_ppm < -RATE_LIMIT_PPM) drift_ppm = -RATE_LIMIT_PPM;
+        }
+    }
+
+    /* step at the old rate, then switch rates at the new anchor so time stays continuous */
+    int64_t us = utc_us_at(now) + offset_us;
+    rate = (int32_t) (drift_ppm * (4294967296.0f / 1e6f));
+    set_us(now, us);
+
+    synced = true;
+    last_sync_cycles = now;
+    last_sync_uncertainty_us = uncertainty_us;
+}
+
+/* Current frequency correction and its 1 sigma uncertainty, in ppm */
+void clock_get_drift(float* ppm, float* sigma_ppm) {
+    *ppm = drift_ppm;
+    *sigma_ppm = sqrtf(drift_var);
+}
+
+/* Seconds until the error the frequency uncertainty can build up since the last sync reaches
+ * SYNC_BUDGET_US. With a good drift estimate this stretches
+ * out to hours, so the phone doesn't need to talk to us in the middle of a pass. */
+uint32_t clock_next_sync_s(void) {
+    if (!synced) return SYNC_MIN_S;
+
+    float sigma = sqrtf(drift_var);
+    float since = (float) (util_clock_cycles64() - last_sync_cycles) * (1.0f / UTIL_CLOCK_HZ);
+    float t = (sigma > 0.0f ? SYNC_BUDGET_US / sigma : (float) SYNC_MAX_S) - since;
+
+    if (t < SYNC_MIN_S) return SYNC_MIN_S;
+    if (t > SYNC_MAX_S) return SYNC_MAX_S;
+    return (uint32_t) t;
+}
+
+uint32_t clock_generation(void) {
+    return generation;
+}
+
+int64_t clock_unix_us(uint64_t cycles) {
+    return utc_us_at(cycles) + CLOCK_UNIX_EPOCH_US;
+}
+
+void clock_at(uint64_t cycles, clock_time_t* out) {
+    int64_t us = utc_us_at(cycles);
+    out->day = (int32_t) (us / US_PER_DAY);
+    out->frac = (float) (us - (int64_t) out->day * US_PER_DAY) * (1.0f / US_PER_DAY);
+}
+
+void clock_now(clock_time_t* out) {
+    clock_at(util_clock_cycles64(), out);
+}
+
+/* Current Julian date as a float. Only good to a fraction of a day, use clock_now() for real work. */
+float clock_now_jday(void) {
+    clock_time_t t;
+    clock_now(&t);
+    return tconv_split_to_jd(t);
+}
+
+/* Minutes from epoch to the given cycle count, for sgp4() */
+float clock_tsince(const clock_time_t* epoch, uint64_t cycles) {
+    int64_t epoch_us = (int64_t) epoch->day * US_PER_DAY + (int64_t) (epoch->frac * (float) US_PER_DAY);
+    return (float) (utc_us_at(cycles) - epoch_us) * (1.0f / 60000000.0f);
 }
@@ -8,10 +8,49 @@
 #ifndef CLOCK_H_
 #define CLOCK_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "sgp4/timeconv.h"
+
+/* UTC clock.
+ *
+ * Whole seconds live in the hibernation module RTC, which keeps running through resets (and
+ * power off, with a backup battery on VBAT), so a set clock is good again right after power up.
+ * At init the RTC is read once (with its 1/32768 s subsecond counter) and tied to the 64-bit
+ * cycle counter; from then on time comes from the cycle counter, so it's cheap and has
+ * sub-microsecond resolution.
+ *
+ * The cycle counter runs off the 16 MHz crystal, which is good to tens of ppm. clock_discipline()
+ * estimates its frequency error from successive bluetooth time syncs and corrects for it with a
+ * fixed point rate, so time holds between syncs (see timesync.h).
+ *
+ * A float Julian date only resolves ~0.25 day at current dates, so times are carried split into
+ * a whole day number and a fraction (clock_time_t). tsince for SGP4 is computed from that in
+ * integer microseconds and only converted to float minutes at the end.
+ */
+
+/* Unix time of day 0, in microseconds, for talking to the outside world */
+#define CLOCK_UNIX_EPOCH_US 946684800000000ll
+
+/* Days since 2000-01-01 00:00 UTC plus fraction of the day, see timeconv.h */
+typedef tconv_split_t clock_time_t;
+
+void clock_init(void);
+bool clock_is_set(void);
+
+void clock_set_utc(uint32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t min, uint32_t sec, uint32_t msec);
+void clock_adjust_us(int64_t offset);
+void clock_discipline(int64_t offset_us, uint32_t uncertainty_us);
+void clock_get_drift(float* ppm, float* sigma_ppm);
+uint32_t clock_next_sync_s(void);
+uint32_t clock_generation(void);
+int64_t clock_unix_us(uint64_t cycles);
+
+void clock_now(clock_time_t* out);
+void clock_at(uint64_t cycles, clock_time_t* out);
 float clock_now_jday(void);
 
-float clock_set_utc(uint32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t min, uint32_t sec, uint32_t msec);
+float clock_tsince(const clock_time_t* epoch, uint64_t cycles);
 
 #endif /* CLOCK_H_ */
@@ -0,0 +1,27 @@
+/*
+ * dma.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+
+#include "dma.h"
+
+/* Primary and alternate control structures for all 32 channels. The controller needs the
+ * table aligned to its size. */
+#pragma DATA_ALIGN(dma_table, 1024)
+static tDMAControlTable dma_table[64];
+
+void dma_init(void) {
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_UDMA));
+
+    uDMAEnable();
+    uDMAControlBaseSet(dma_table);
+}
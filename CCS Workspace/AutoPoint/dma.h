@@ -0,0 +1,16 @@
+/*
+ * dma.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef DMA_H_
+#define DMA_H_
+
+/* Owns the uDMA controller and its channel control table. Drivers that use a channel set it
+ * up themselves with driverlib/udma.h once dma_init() has run. */
+
+void dma_init(void);
+
+#endif /* DMA_H_ */
@@ -0,0 +1,89 @@
+/*
+ * frame.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "driverlib/sw_crc.h"
+
+#include "frame.h"
+
+/* COBS encode len bytes. out needs room for len + len / 254 + 1. No delimiter is added.
+ * Returns the encoded length. */
+uint32_t cobs_encode(const uint8_t* in, uint32_t len, uint8_t* out) {
+    uint32_t code_at = 0;
+    uint32_t o = 1;
+    uint8_t code = 1;
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (in[i] != 0) {
+            out[o++] = in[i];
+            code++;
+        }
+        if (in[i] == 0 || code == 0xFF) {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+
+    return o;
+}
+
+/* COBS decode len bytes (delimiter not included). out may be the same buffer as in, since the
+ * output never overtakes the input. Returns the decoded length, or -1 if it isn't valid COBS. */
+int32_t cobs_decode(const uint8_t* in, uint32_t len, uint8_t* out) {
+    uint32_t i = 0;
+    uint32_t o = 0;
+
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) return -1;
+
+        for (uint8_t j = 1; j < code; j++) {
+            if (in[i] == 0) return -1;
+            out[o++] = in[i++];
+        }
+
+        /* a zero was removed here, unless this block was full or the last one */
+        if (code != 0xFF && i < len) out[o++] = 0;
+    }
+
+    return (int32_t) o;
+}
+
+/* Build a frame, delimiter included, into out (FRAME_MAX_ENCODED bytes is always enough).
+ * Returns its length on the wire, or 0 if the payload is too long. */
+uint32_t frame_encode(uint8_t type, const void* payload, uint32_t len, uint8_t* out) {
+    uint8_t raw[FRAME_MAX_PAYLOAD + FRAME_OVERHEAD];
+
+    if (len > FRAME_MAX_PAYLOAD) return 0;
+
+    raw[0] = type;
+    memcpy(&raw[1], payload, len);
+    le_put_u16(&raw[1 + len], Crc16(0, raw, 1 + len));
+
+    uint32_t n = cobs_encode(raw, len + FRAME_OVERHEAD, out);
+    out[n++] = FRAME_DELIM;
+    return n;
+}
+
+/* Decode a received frame in place (len bytes, delimiter not included) and check its CRC.
+ * On success points *payload into buf and returns the payload length; -1 if the frame is bad. */
+int32_t frame_decode(uint8_t* buf, uint32_t len, uint8_t* type, uint8_t** payload) {
+    int32_t n = cobs_decode(buf, len, buf);
+    if (n < FRAME_OVERHEAD) return -1;
+
+    n -= 2;
+    if (Crc16(0, buf, (uint32_t) n) != le_get_u16(&buf[n])) return -1;
+
+    *type = buf[0];
+    *payload = &buf[1];
+    return n - 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * frame.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Binary link framing, shared by the firmware and the host tools (plain C99, the only dependency
+ * is driverlib/sw_crc.c, which builds on the host as is).
+ *
+ * On the wire a frame is
+ *
+ *  COBS( type | payload | crc16 ) 0x00
+ *
+ * COBS (consistent overhead byte stuffing) removes every zero byte from the frame for the cost of
+ * one extra byte per 254, so 0x00 only ever appears as the delimiter and a receiver can always
+ * find the next frame boundary. crc16 is CRC-16/ARC (sw_crc's Crc16() seeded with 0) over type
+ * and payload, little-endian. A frame that doesn't decode or doesn't match its CRC is dropped.
+ *
+ * Payloads are packed little-endian fields; the le_* helpers below read and write them from any
+ * alignment. Message types and layouts are in protocol.h.
+ */
+
+#define FRAME_DELIM         0x00
+#define FRAME_MAX_PAYLOAD   250
+
+/* type + crc, and the worst case encoded size (COBS byte and delimiter included) */
+#define FRAME_OVERHEAD      3
+#define FRAME_MAX_ENCODED   (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD + 2)
+
+uint32_t cobs_encode(const uint8_t* in, uint32_t len, uint8_t* out);
+int32_t cobs_decode(const uint8_t* in, uint32_t len, uint8_t* out);
+
+uint32_t frame_encode(uint8_t type, const void* payload, uint32_t len, uint8_t* out);
+int32_t frame_decode(uint8_t* buf, uint32_t len, uint8_t* type, uint8_t** payload);
+
+static inline uint32_t frame_encoded_len(uint32_t payload_len) {
+    uint32_t n = payload_len + FRAME_OVERHEAD;
+    return n + n / 254 + 1 + 1;
+}
+
+static inline uint16_t le_get_u16(const uint8_t* p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static inline uint32_t le_get_u32(const uint8_t* p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline int64_t le_get_i64(const uint8_t* p) {
+    return (int64_t) ((uint64_t) le_get_u32(p) | ((uint64_t) le_get_u32(p + 4) << 32));
+}
+
+static inline float le_get_f32(const uint8_t* p) {
+    uint32_t u = le_get_u32(p);
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static inline void le_put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+}
+
+static inline void le_put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+    p[2] = (uint8_t) (v >> 16);
+    p[3] = (uint8_t) (v >> 24);
+}
+
+static inline void le_put_i64(uint8_t* p, int64_t v) {
+    le_put_u32(p, (uint32_t) v);
+    le_put_u32(p + 4, (uint32_t) ((uint64_t) v >> 32));
+}
+
+static inline void le_put_f32(uint8_t* p, float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    le_put_u32(p, u);
+}
+
+#endif /* FRAME_H_ */
@@ -0,0 +1,106 @@
+/*
+ * hal.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef HAL_H_
+#define HAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The hardware the firmware drives, as little of it as the modules actually use. hal_tm4c.c is
+ * the real thing (driverlib); host/hal_sim.c stands in for it on a PC with a virtual clock,
+ * timers, pins, flash and RTC, and a model of the mount's motors (see host/). The bluetooth UART
+ * has its own port, bluetooth_uart.h, which works the same way.
+ *
+ * Nothing here is called before hal_init(). Pins, timers and axes are named for what they do;
+ * the backend knows where they are.
+ */
+
+typedef enum {
+    HAL_PIN_LASER_SWITCH = 0,   /* PB5 */
+    HAL_PIN_LASER_ENABLE,       /* PA2 */
+    HAL_PIN_AZ_STEP,            /* PD2 */
+    HAL_PIN_AZ_DIR,             /* PD3 */
+    HAL_PIN_EL_STEP,            /* PE1 */
+    HAL_PIN_EL_DIR,             /* PE2 */
+    HAL_PIN_COUNT
+} hal_pin_t;
+
+/* Periodic interrupts off the system clock */
+typedef enum {
+    HAL_TIMER_SETPOINT = 0,     /* TIMER1 */
+    HAL_TIMER_AZ_STEP,          /* TIMER2 */
+    HAL_TIMER_EL_STEP,          /* TIMER3 */
+    HAL_TIMER_COUNT
+} hal_timer_t;
+
+/* H-bridge and quadrature encoder pairs (pins in mount.h) */
+typedef enum {
+    HAL_AXIS_AZ = 0,
+    HAL_AXIS_EL,
+    HAL_AXIS_COUNT
+} hal_axis_t;
+
+typedef void (*hal_isr_t)(void);
+
+/* System clock to UTIL_CLOCK_HZ, and whatever shared peripherals drivers expect to find running.
+ * Doesn't come back if the clock isn't right. */
+void hal_init(void);
+
+/* End of a pass through the main loop. Nothing on the board; the simulation moves virtual time
+ * on here. */
+void hal_idle(void);
+
+/* Interrupts off, returning whether they already were, and back as they were. For a few
+ * instructions at a time. */
+bool hal_irq_disable(void);
+void hal_irq_restore(bool was_disabled);
+
+/* Free running cycle counter at UTIL_CLOCK_HZ. The 32-bit read is the cheap one. */
+void hal_timebase_init(void);
+uint32_t hal_cycles(void);
+uint64_t hal_cycles64(void);
+
+/* Output pins. Writes are a single store, safe from any ISR. */
+void hal_pin_output(hal_pin_t pin, bool level);
+void hal_pin_write(hal_pin_t pin, bool level);
+bool hal_pin_read(hal_pin_t pin);
+
+/* Timers start stopped with their interrupt unmasked. A new period takes effect at the next
+ * timeout, so an interval in flight isn't cut short. The ISR acks its timer first thing. */
+void hal_timer_init(hal_timer_t timer, hal_isr_t isr, uint8_t priority);
+void hal_timer_set_period(hal_timer_t timer, uint32_t cycles);
+void hal_timer_start(hal_timer_t timer);
+void hal_timer_stop(hal_timer_t timer);
+void hal_timer_mask(hal_timer_t timer, bool masked);
+void hal_timer_ack(hal_timer_t timer);
+
+/* Motor drive: duty -1 to 1, sign is direction, 0 lets the motor coast. Encoders count all four
+ * quadrature edges, free running over 32 bits (read back as signed). */
+void hal_motor_init(uint32_t pwm_hz);
+void hal_motor_drive(hal_axis_t axis, float duty);
+void hal_encoder_init(void);
+int32_t hal_encoder_get(hal_axis_t axis);
+void hal_encoder_set(hal_axis_t axis, int32_t count);
+
+/* On-chip flash, in 1 KB erase blocks. Programming takes whole words. */
+bool hal_flash_erase(uint32_t addr);
+bool hal_flash_program(const uint32_t* words, uint32_t addr, uint32_t len);
+const void* hal_flash_map(uint32_t addr);
+
+/* Battery backed RTC (seconds, and 1/32768 s subseconds) and a few words of memory that survive
+ * with it. hal_rtc_init() says whether it kept running through the reset. */
+#define HAL_RTC_SUBSEC_HZ   32768
+#define HAL_RTC_WORDS       16
+
+bool hal_rtc_init(void);
+void hal_rtc_read(uint32_t* sec, uint32_t* subsec);
+void hal_rtc_set(uint32_t sec);
+void hal_rtc_data_get(uint32_t* words, uint32_t count);
+void hal_rtc_data_set(const uint32_t* words, uint32_t count);
+
+#endif /* HAL_H_ */
@@ -0,0 +1,302 @@
+/*
+ * hal_tm4c.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_gpio.h"
+#include "inc/hw_ints.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/gpio.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/timer.h"
+#include "driverlib/pwm.h"
+#include "driverlib/qei.h"
+#include "driverlib/flash.h"
+#include "driverlib/hibernate.h"
+
+#include "util.h"
+#include "dma.h"
+#include "hal.h"
+
+/* hal.h on the TM4C123, straight onto driverlib */
+
+typedef struct {
+    uint32_t periph;
+    uint32_t port;
+    uint8_t mask;
+    uint32_t data;      /* masked GPIODATA address, so a write is one store */
+} pin_def_t;
+
+#define PIN(p, n) { SYSCTL_PERIPH_GPIO##p, GPIO_PORT##p##_BASE, (1<<(n)), \
+                    GPIO_PORT##p##_BASE + GPIO_O_DATA + ((1<<(n)) << 2) }
+
+static const pin_def_t pins[HAL_PIN_COUNT] = {
+    [HAL_PIN_LASER_SWITCH]  = PIN(B, 5),
+    [HAL_PIN_LASER_ENABLE]  = PIN(A, 2),
+    [HAL_PIN_AZ_STEP]       = PIN(D, 2),
+    [HAL_PIN_AZ_DIR]        = PIN(D, 3),
+    [HAL_PIN_EL_STEP]       = PIN(E, 1),
+    [HAL_PIN_EL_DIR]        = PIN(E, 2),
+};
+
+typedef struct {
+    uint32_t periph;
+    uint32_t base;
+    uint32_t interrupt;
+} timer_def_t;
+
+static const timer_def_t timers[HAL_TIMER_COUNT] = {
+    [HAL_TIMER_SETPOINT]    = { SYSCTL_PERIPH_TIMER1, TIMER1_BASE, INT_TIMER1A },
+    [HAL_TIMER_AZ_STEP]     = { SYSCTL_PERIPH_TIMER2, TIMER2_BASE, INT_TIMER2A },
+    [HAL_TIMER_EL_STEP]     = { SYSCTL_PERIPH_TIMER3, TIMER3_BASE, INT_TIMER3A },
+};
+
+static const uint32_t pwm_base[HAL_AXIS_COUNT] = { PWM0_BASE, PWM1_BASE };
+static const uint32_t qei_base[HAL_AXIS_COUNT] = { QEI0_BASE, QEI1_BASE };
+
+static uint32_t pwm_period;
+
+static void enable(uint32_t periph) {
+    SysCtlPeripheralEnable(periph);
+    while(!SysCtlPeripheralReady(periph));
+}
+
+void hal_init(void) {
+    /* set system clock to 80MHz with 16MHz external crystal */
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ | SYSCTL_OSC_MAIN);
+
+    /* make sure it actually happened */
+    if (SysCtlClockGet() != UTIL_CLOCK_HZ) {
+        while(1);
+    }
+
+    dma_init();
+}
+
+void hal_idle(void) {
+}
+
+bool hal_irq_disable(void) {
+    return IntMasterDisable();
+}
+
+void hal_irq_restore(bool was_disabled) {
+    if (!was_disabled) IntMasterEnable();
+}
+
+/* WTIMER0 counting system clock cycles in concatenated 64-bit mode. At 80MHz that takes ~7000
+ * years to wrap. */
+void hal_timebase_init(void) {
+    enable(SYSCTL_PERIPH_WTIMER0);
+
+    TimerConfigure(WTIMER0_BASE, TIMER_CFG_PERIODIC_UP);
+    TimerClockSourceSet(WTIMER0_BASE, TIMER_CLOCK_SYSTEM);
+    TimerLoadSet64(WTIMER0_BASE, 0xFFFFFFFFFFFFFFFFull);
+    TimerEnable(WTIMER0_BASE, TIMER_A);
+}
+
+uint32_t hal_cycles(void) {
+    return TimerValueGet(WTIMER0_BASE, TIMER_A);
+}
+
+/* TimerValueGet64 re-reads the high word until it gets a consistent pair, so this is lock-free
+ * and safe from any context */
+uint64_t hal_cycles64(void) {
+    return TimerValueGet64(WTIMER0_BASE);
+}
+
+void hal_pin_output(hal_pin_t pin, bool level) {
+    const pin_def_t* p = &pins[pin];
+    enable(p->periph);
+    GPIOPinTypeGPIOOutput(p->port, p->mask);
+    GPIOPinWrite(p->port, p->mask, level ? p->mask : 0);
+}
+
+void hal_pin_write(hal_pin_t pin, bool level) {
+    HWREG(pins[pin].data) = level ? pins[pin].mask : 0;
+}
+
+bool hal_pin_read(hal_pin_t pin) {
+    return HWREG(pins[pin].data) != 0;
+}
+
+void hal_timer_init(hal_timer_t timer, hal_isr_t isr, uint8_t priority) {
+    const timer_def_t* t = &timers[timer];
+    enable(t->periph);
+
+    TimerConfigure(t->base, TIMER_CFG_PERIODIC);
+    TimerClockSourceSet(t->base, TIMER_CLOCK_SYSTEM);
+    TimerUpdateMode(t->base, TIMER_A, TIMER_UP_LOAD_TIMEOUT);
+
+    TimerIntRegister(t->base, TIMER_A, isr);
+    IntPrioritySet(t->interrupt, priority);
+    TimerIntEnable(t->base, TIMER_TIMA_TIMEOUT);
+}
+
+void hal_timer_set_period(hal_timer_t timer, uint32_t cycles) {
+    TimerLoadSet(timers[timer].base, TIMER_A, cycles - 1);
+}
+
+void hal_timer_start(hal_timer_t timer) {
+    TimerEnable(timers[timer].base, TIMER_A);
+}
+
+void hal_timer_stop(hal_timer_t timer) {
+    TimerDisable(timers[timer].base, TIMER_A);
+}
+
+void hal_timer_mask(hal_timer_t timer, bool masked) {
+    if (masked) {
+        TimerIntDisable(timers[timer].base, TIMER_TIMA_TIMEOUT);
+    } else {
+        TimerIntEnable(timers[timer].base, TIMER_TIMA_TIMEOUT);
+    }
+}
+
+void hal_timer_ack(hal_timer_t timer) {
+    TimerIntClear(timers[timer].base, TIMER_TIMA_TIMEOUT);
+}
+
+/* H-bridge IN1/IN2 on generator 0 of each PWM module */
+void hal_motor_init(uint32_t pwm_hz) {
+    enable(SYSCTL_PERIPH_GPIOB);
+    enable(SYSCTL_PERIPH_GPIOD);
+    enable(SYSCTL_PERIPH_PWM0);
+    enable(SYSCTL_PERIPH_PWM1);
+
+    /* PWM clock straight off the system clock */
+    SysCtlPWMClockSet(SYSCTL_PWMDIV_1);
+    pwm_period = UTIL_CLOCK_HZ / pwm_hz;
+
+    GPIOPinConfigure(GPIO_PB6_M0PWM0);
+    GPIOPinConfigure(GPIO_PB7_M0PWM1);
+    GPIOPinTypePWM(GPIO_PORTB_BASE, (1<<6) | (1<<7));
+
+    GPIOPinConfigure(GPIO_PD0_M1PWM0);
+    GPIOPinConfigure(GPIO_PD1_M1PWM1);
+    GPIOPinTypePWM(GPIO_PORTD_BASE, (1<<0) | (1<<1));
+
+    for (uint32_t i = 0; i < HAL_AXIS_COUNT; i++) {
+        PWMGenConfigure(pwm_base[i], PWM_GEN_0, PWM_GEN_MODE_DOWN | PWM_GEN_MODE_NO_SYNC);
+        PWMGenPeriodSet(pwm_base[i], PWM_GEN_0, pwm_period);
+
+        /* motors off */
+        PWMOutputState(pwm_base[i], PWM_OUT_0_BIT | PWM_OUT_1_BIT, false);
+        PWMGenEnable(pwm_base[i], PWM_GEN_0);
+    }
+}
+
+/* PWM on the IN pin for the direction we want, the other held low */
+void hal_motor_drive(hal_axis_t axis, float duty) {
+    uint32_t base = pwm_base[axis];
+    uint32_t width = (uint32_t) ((duty < 0 ? -duty : duty) * pwm_period);
+
+    /* a width of the whole period isn't valid on the generator, full scale is one count short */
+    if (width >= pwm_period) width = pwm_period - 1;
+
+    if (width == 0) {
+        PWMOutputState(base, PWM_OUT_0_BIT | PWM_OUT_1_BIT, false);
+    } else if (duty > 0) {
+        PWMPulseWidthSet(base, PWM_OUT_0, width);
+        PWMOutputState(base, PWM_OUT_1_BIT, false);
+        PWMOutputState(base, PWM_OUT_0_BIT, true);
+    } else {
+        PWMPulseWidthSet(base, PWM_OUT_1, width);
+        PWMOutputState(base, PWM_OUT_0_BIT, false);
+        PWMOutputState(base, PWM_OUT_1_BIT, true);
+    }
+}
+
+void hal_encoder_init(void) {
+    enable(SYSCTL_PERIPH_GPIOC);
+    enable(SYSCTL_PERIPH_GPIOD);
+    enable(SYSCTL_PERIPH_QEI0);
+    enable(SYSCTL_PERIPH_QEI1);
+
+    /* PD7 is an NMI pin and locked by default */
+    HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+    HWREG(GPIO_PORTD_BASE + GPIO_O_CR) |= (1<<7);
+    HWREG(GPIO_PORTD_BASE + GPIO_O_LOCK) = 0;
+
+    GPIOPinConfigure(GPIO_PD6_PHA0);
+    GPIOPinConfigure(GPIO_PD7_PHB0);
+    GPIOPinTypeQEI(GPIO_PORTD_BASE, (1<<6) | (1<<7));
+
+    GPIOPinConfigure(GPIO_PC5_PHA1);
+    GPIOPinConfigure(GPIO_PC6_PHB1);
+    GPIOPinTypeQEI(GPIO_PORTC_BASE, (1<<5) | (1<<6));
+
+    for (uint32_t i = 0; i < HAL_AXIS_COUNT; i++) {
+        QEIConfigure(qei_base[i], QEI_CONFIG_CAPTURE_A_B | QEI_CONFIG_NO_RESET | QEI_CONFIG_QUADRATURE | QEI_CONFIG_NO_SWAP, 0xFFFFFFFF);
+        QEIPositionSet(qei_base[i], 0);
+        QEIEnable(qei_base[i]);
+    }
+}
+
+int32_t hal_encoder_get(hal_axis_t axis) {
+    return (int32_t) QEIPositionGet(qei_base[axis]);
+}
+
+void hal_encoder_set(hal_axis_t axis, int32_t count) {
+    QEIPositionSet(qei_base[axis], (uint32_t) count);
+}
+
+bool hal_flash_erase(uint32_t addr) {
+    return FlashErase(addr) == 0;
+}
+
+bool hal_flash_program(const uint32_t* words, uint32_t addr, uint32_t len) {
+    return FlashProgram((uint32_t*) words, addr, len) == 0;
+}
+
+/* Flash is memory mapped */
+const void* hal_flash_map(uint32_t addr) {
+    return (const void*) addr;
+}
+
+/* The hibernation module's RTC, off its 32.768 kHz crystal */
+bool hal_rtc_init(void) {
+    enable(SYSCTL_PERIPH_HIBERNATE);
+
+    bool running = HibernateIsActive();
+
+    HibernateEnableExpClk(SysCtlClockGet());
+
+    if (!running) {
+        /* cold start: get the oscillator going, nothing in the RTC worth keeping */
+        HibernateClockConfig(HIBERNATE_OSC_LOWDRIVE);
+        HibernateRTCEnable();
+    }
+    return running;
+}
+
+/* Seconds and subseconds as a consistent pair */
+void hal_rtc_read(uint32_t* sec, uint32_t* subsec) {
+    uint32_t s;
+    do {
+        s = HibernateRTCGet();
+        *subsec = HibernateRTCSSGet() & 0x7FFF;
+    } while (s != HibernateRTCGet());
+    *sec = s;
+}
+
+/* Loading the seconds clears the subsecond counter */
+void hal_rtc_set(uint32_t sec) {
+    HibernateRTCSet(sec);
+}
+
+void hal_rtc_data_get(uint32_t* words, uint32_t count) {
+    HibernateDataGet(words, count);
+}
+
+void hal_rtc_data_set(const uint32_t* words, uint32_t count) {
+    HibernateDataSet((uint32_t*) words, count);
+}
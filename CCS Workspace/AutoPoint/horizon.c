@@ -0,0 +1,187 @@
+/*
+ * horizon.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "storage.h"
+#include "horizon.h"
+#include "trace.h"
+
+#define PI 3.14159265f
+#define DEG2RAD (PI / 180.0f)
+#define ARCSEC2RAD (PI / (180.0f * 3600.0f))
+
+/* Default refraction table: Saemundsson's formula at 10 C / 1010 mbar,
+ *
+ *     R [arcmin] = 1.02 / tan(h + 10.3 / (h + 5.11)),  h = true elevation in degrees
+ *
+ * evaluated offline every REFRACTION_STEP_DEG from REFRACTION_MIN_DEG up to zenith, in arcseconds.
+ * Upload a site-specific table to account for altitude / typical temperature.
+ */
+static const uint16_t default_refraction[REFRACTION_TABLE_SIZE] = {
+    2672, 2591, 2328, 2021, 1739, 1500, 1305, 1145, 1016,  909,  820,  745,
+     682,  627,  580,  540,  504,  472,  444,  419,  396,  376,  357,  340,
+     324,  310,  297,  285,  274,  263,  254,  244,  236,  228,  220,  213,
+     207,  200,  195,  189,  183,  178,  174,  169,  164,  160,  156,  152,
+     149,  145,  142,  138,  135,  132,  129,  126,  124,  121,  118,  116,
+     114,  111,  109,  107,  105,  103,  101,   99,   97,   95,   93,   92,
+      90,   88,   87,   85,   83,   82,   80,   79,   78,   76,   75,   74,
+      72,   71,   70,   69,   67,   66,   65,   64,   63,   62,   61,   60,
+      59,   58,   57,   56,   55,   54,   53,   52,   51,   50,   49,   48,
+      48,   47,   46,   45,   44,   43,   43,   42,   41,   40,   39,   39,
+      38,   37,   37,   36,   35,   34,   34,   33,   32,   32,   31,   30,
+      30,   29,   28,   28,   27,   26,   26,   25,   25,   24,   23,   23,
+      22,   22,   21,   20,   20,   19,   19,   18,   17,   17,   16,   16,
+      15,   15,   14,   13,   13,   12,   12,   11,   11,   10,   10,    9,
+       8,    8,    7,    7,    6,    6,    5,    5,    4,    4,    3,    3,
+       2,    1,    1,    0,    0,
+};
+
+/* Default horizon mask: flat horizon, everything above 0 degrees is clear. */
+static const uint8_t default_mask[HORIZON_MASK_BINS] = { 0 };
+
+/* Active tables. Point either at the defaults above or at a record in flash. */
+static const uint8_t* mask = default_mask;
+static const uint16_t* refraction = default_refraction;
+
+/* Staging area for tables being uploaded over bluetooth. Only one table is staged at a time. */
+static union {
+    uint8_t mask[HORIZON_MASK_BINS];
+    uint16_t refraction[REFRACTION_TABLE_SIZE];
+} staging;
+static int32_t staged_table = -1;
+
+/* Precomputed lookup scale factors */
+static const float mask_bins_per_rad = HORIZON_MASK_BINS / (2.0f * PI);
+static const float mask_unit_rad = HORIZON_MASK_UNIT_DEG * DEG2RAD;
+static const float refraction_steps_per_rad = 1.0f / (REFRACTION_STEP_DEG * DEG2RAD);
+static const float refraction_min_rad = REFRACTION_MIN_DEG * DEG2RAD;
+
+/* The interlock checks the mask in the control tick, so switching it is a trace sync point */
+static void use_mask(const uint8_t* m) {
+    bool irq = trace_lock();
+    mask = m;
+    trace_unlock(irq);
+}
+
+/* Load any previously uploaded tables out of flash */
+void horizon_init(void) {
+    const void* stored;
+
+    stored = storage_get(STORAGE_SLOT_HORIZON_MASK, sizeof(default_mask));
+    use_mask(stored ? (const uint8_t*) stored : default_mask);
+
+    stored = storage_get(STORAGE_SLOT_REFRACTION, sizeof(default_refraction));
+    refraction = stored ? (const uint16_t*) stored : default_refraction;
+}
+
+/* Minimum clear elevation (radians) at the given azimuth (radians, 0 to 2pi) */
+float horizon_mask_el(float az) {
+    int32_t bin = (int32_t) (az * mask_bins_per_rad);
+
+    /* tolerate azimuths slightly outside [0, 2pi) from float roundoff */
+    if (bin < 0) bin = 0;
+    if (bin >= HORIZON_MASK_BINS) bin = HORIZON_MASK_BINS - 1;
+
+    return mask[bin] * mask_unit_rad;
+}
+
+/* True if a line of sight at (az, el) clears the horizon mask. Radians. */
+bool horizon_is_clear(float az, float el) {
+    return el >= horizon_mask_el(az);
+}
+
+/* Convert a true (geometric) elevation to the apparent elevation, in radians. */
+float horizon_refract(float el) {
+    float idx = (el - refraction_min_rad) * refraction_steps_per_rad;
+
+    if (idx <= 0.0f) return el + refraction[0] * ARCSEC2RAD;
+    if (idx >= REFRACTION_TABLE_SIZE - 1) return el + refraction[REFRACTION_TABLE_SIZE - 1] * ARCSEC2RAD;
+
+    int32_t i = (int32_t) idx;
+    float t = idx - i;
+    float r = refraction[i] + t * ((float) refraction[i + 1] - (float) refraction[i]);
+
+    return el + r * ARCSEC2RAD;
+}
+
+static uint8_t* staging_for(horizon_table_t table, uint32_t* size) {
+    if (table == HORIZON_TABLE_MASK) {
+        *size = sizeof(staging.mask);
+        return staging.mask;
+    } else if (table == HORIZON_TABLE_REFRACTION) {
+        *size = sizeof(staging.refraction);
+        return (uint8_t*) staging.refraction;
+    }
+    return NULL;
+}
+
+/* Write a chunk of a new table (raw little-endian bytes) into the staging area.
+ *
+ * Staging starts out as a copy of the active table, so a partial upload only changes the bytes sent.
+ * Returns false if the chunk runs off the end of the table.
+ */
+bool horizon_stage(horizon_table_t table, uint32_t offset, const uint8_t* data, uint32_t len) {
+    uint32_t size;
+    uint8_t* buf = staging_for(table, &size);
+
+    if (buf == NULL) return false;
+    if (offset > size || len > size - offset) return false;
+
+    if (staged_table != (int32_t) table) {
+        if (table == HORIZON_TABLE_MASK) {
+            memcpy(buf, mask, size);
+        } else {
+            memcpy(buf, refraction, size);
+        }
+        staged_table = table;
+    }
+
+    memcpy(buf + offset, data, len);
+    return true;
+}
+
+/* Save the staged table to flash and start using it. */
+bool horizon_commit(horizon_table_t table) {
+    uint32_t size;
+    uint8_t* buf = staging_for(table, &size);
+
+    if (buf == NULL) return false;
+    if (staged_table != (int32_t) table) return false;
+    if (!storage_writable()) return false;
+
+    storage_slot_t slot = (table == HORIZON_TABLE_MASK) ? STORAGE_SLOT_HORIZON_MASK : STORAGE_SLOT_REFRACTION;
+
+    /* The active table may live in the slot we're about to erase, run off the staged copy meanwhile */
+    if (table == HORIZON_TABLE_MASK) {
+        use_mask(staging.mask);
+    } else {
+        refraction = staging.refraction;
+    }
+
+    if (!storage_save(slot, buf, size)) {
+        horizon_init();
+        return false;
+    }
+
+    staged_table = -1;
+    horizon_init();
+    return true;
+}
+
+/* Forget any uploaded table and go back to the built-in default. False, with nothing changed, if
+ * flash can't be written now. */
+bool horizon_reset(horizon_table_t table) {
+    if (!storage_erase(table == HORIZON_TABLE_MASK ? STORAGE_SLOT_HORIZON_MASK : STORAGE_SLOT_REFRACTION)) {
+        return false;
+    }
+    if (staged_table == (int32_t) table) staged_table = -1;
+    horizon_init();
+    return true;
+}
@@ -0,0 +1,50 @@
+/*
+ * horizon.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef HORIZON_H_
+#define HORIZON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Site horizon mask and atmospheric refraction tables.
+ *
+ * Both are plain lookup tables so the az/el stage never evaluates a refraction formula or
+ * searches an obstruction list per tick:
+ *
+ * Horizon mask: minimum clear elevation for each azimuth bin, in units of HORIZON_MASK_UNIT_DEG.
+ *  Bin 0 covers azimuth [0, 5) degrees, bin 1 [5, 10), etc. (true north, clockwise).
+ *
+ * Refraction: refraction correction in arcseconds, sampled every REFRACTION_STEP_DEG
+ *  of true (geometric) elevation starting at REFRACTION_MIN_DEG. Linearly interpolated.
+ *
+ * Uploaded tables are kept in flash (see storage.h) and used in place from there.
+ */
+
+#define HORIZON_MASK_BINS       72
+#define HORIZON_MASK_UNIT_DEG   0.5f
+
+#define REFRACTION_TABLE_SIZE   185
+#define REFRACTION_MIN_DEG      (-2.0f)
+#define REFRACTION_STEP_DEG     0.5f
+
+typedef enum {
+    HORIZON_TABLE_MASK = 0,
+    HORIZON_TABLE_REFRACTION
+} horizon_table_t;
+
+void horizon_init(void);
+
+float horizon_mask_el(float az);
+bool horizon_is_clear(float az, float el);
+float horizon_refract(float el);
+
+bool horizon_stage(horizon_table_t table, uint32_t offset, const uint8_t* data, uint32_t len);
+bool horizon_commit(horizon_table_t table);
+bool horizon_reset(horizon_table_t table);
+
+#endif /* HORIZON_H_ */
@@ -0,0 +1,218 @@
+/*
+ * interlock.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "hal.h"
+#include "util.h"
+#include "clock.h"
+#include "setpoint.h"
+#include "horizon.h"
+#include "laser_control.h"
+#include "interlock.h"
+#include "trace.h"
+
+#define DEG2RAD (3.14159265f / 180.0f)
+
+#define MIN_EL          (INTERLOCK_MIN_EL_DEG * DEG2RAD)
+#define MASK_MARGIN     (INTERLOCK_MASK_MARGIN_DEG * DEG2RAD)
+#define MAX_ERROR_SQ    ((INTERLOCK_MAX_ERROR_DEG * DEG2RAD) * (INTERLOCK_MAX_ERROR_DEG * DEG2RAD))
+
+#define MAX_LATENCY_CYCLES  (INTERLOCK_MAX_LATENCY_US * (UTIL_CLOCK_HZ / 1000000))
+#define REARM_TICKS         (INTERLOCK_REARM_MS * SETPOINT_RATE_HZ / 1000)
+#define WATCHDOG_CYCLES     (INTERLOCK_WATCHDOG_MS * (UTIL_CLOCK_HZ / 1000))
+
+typedef struct {
+    bool used;
+    interlock_zone_t zone;
+} zone_slot_t;
+
+/* Exclusion zones, double buffered: the main loop edits the inactive set and flips 'active',
+ * so the ISR always sees a complete set. */
+static zone_slot_t zones[2][INTERLOCK_MAX_ZONES];
+static volatile uint32_t active = 0;
+
+static volatile bool armed = false;
+static volatile uint32_t latched = 0;       /* written by the ISR, cleared by arming */
+static volatile bool watchdog_tripped = false;
+static volatile bool clock_set = false;     /* clock_is_set(), as the main loop last saw it */
+
+static uint32_t clear_ticks = 0;
+
+/* Main loop watchdog state */
+static uint32_t last_ticks = 0;
+static uint64_t last_tick_seen = 0;
+
+/* Written by the ISR under a sequence count, both volatile so neither side's accesses to the
+ * status can move outside the count's */
+static volatile interlock_status_t status;
+static volatile uint32_t status_seq = 0;
+
+static bool in_zone(const interlock_zone_t* z, float az, float el) {
+    if (el < z->el_min || el > z->el_max) return false;
+
+    if (z->az_min <= z->az_max) {
+        return az >= z->az_min && az <= z->az_max;
+    } else {
+        return az >= z->az_min || az <= z->az_max;
+    }
+}
+
+static uint32_t check(const setpoint_t* sp, bool tracking, float az_err, float el_err) {
+    uint32_t reasons = 0;
+
+    if (!tracking || !sp->valid || sp->stale) {
+        /* nothing sensible to judge the rest against */
+        return INTERLOCK_NOT_TRACKING;
+    }
+
+    if (sp->el < MIN_EL) reasons |= INTERLOCK_MIN_EL;
+    if (!horizon_is_clear(sp->az, sp->el - MASK_MARGIN)) reasons |= INTERLOCK_HORIZON;
+
+    const zone_slot_t* set = zones[active];
+    for (uint32_t i = 0; i < INTERLOCK_MAX_ZONES; i++) {
+        if (set[i].used && in_zone(&set[i].zone, sp->az, sp->el)) {
+            reasons |= INTERLOCK_ZONE;
+            break;
+        }
+    }
+
+    /* azimuth error shrinks towards the zenith on the sky */
+    float az_sky = az_err * cosf(sp->el);
+    if (az_sky * az_sky + el_err * el_err > MAX_ERROR_SQ) reasons |= INTERLOCK_POINTING_ERROR;
+
+    return reasons;
+}
+
+void interlock_init(void) {
+    laser_off();
+
+    for (uint32_t i = 0; i < INTERLOCK_MAX_ZONES; i++) {
+        zones[0][i].used = false;
+        zones[1][i].used = false;
+    }
+
+    last_tick_seen = util_clock_cycles64();
+}
+
+/* Arm (or disarm) the laser. Arming clears latched faults; the laser still only comes on once the
+ * checks have passed for INTERLOCK_REARM_MS. Disarming turns it off immediately. */
+void interlock_arm(bool arm) {
+    bool irq = trace_lock();
+    if (arm) {
+        latched = 0;
+        watchdog_tripped = false;
+        armed = true;
+    } else {
+        armed = false;
+        laser_off();
+    }
+    trace_unlock(irq);
+}
+
+/* Set exclusion zone 'index', or clear it if zone is NULL. Main loop only. */
+bool interlock_set_zone(uint32_t index, const interlock_zone_t* zone) {
+    if (index >= INTERLOCK_MAX_ZONES) return false;
+
+    uint32_t next = active ^ 1;
+    for (uint32_t i = 0; i < INTERLOCK_MAX_ZONES; i++) {
+        zones[next][i] = zones[active][i];
+    }
+
+    if (zone) {
+        zones[next][index].zone = *zone;
+        zones[next][index].used = true;
+    } else {
+        zones[next][index].used = false;
+    }
+
+    /* with the tick held off, so the set is in force when this returns (the call also keeps the
+     * stores above ahead of the flip) */
+    bool irq = hal_irq_disable();
+    bool sync = trace_lock();
+    active = next;
+    trace_unlock(sync);
+    hal_irq_restore(irq);
+    return true;
+}
+
+/* Called from the control tick, first thing after the servo errors are known.
+ * tracking is false if the mount is disabled. */
+void interlock_tick(const setpoint_t* sp, bool tracking, float az_err, float el_err) {
+    uint32_t reasons = check(sp, tracking, az_err, el_err) | latched;
+    if (!armed) reasons |= INTERLOCK_DISARMED;
+    if (watchdog_tripped) reasons |= INTERLOCK_WATCHDOG;
+    if (!clock_set) reasons |= INTERLOCK_NO_CLOCK;
+
+    bool was_on = laser_is_on();
+
+    if (reasons) {
+        laser_off();
+        clear_ticks = 0;
+    } else if (clear_ticks < REARM_TICKS) {
+        clear_ticks++;
+    }
+
+    /* sp->t is the tick entry timestamp */
+    uint32_t latency = util_clock_cycles() - sp->t;
+
+    if (latency > MAX_LATENCY_CYCLES) {
+        laser_off();
+        latched |= INTERLOCK_LATENCY;
+        reasons |= INTERLOCK_LATENCY;
+        clear_ticks = 0;
+    } else if (!reasons && clear_ticks >= REARM_TICKS) {
+        laser_on();
+    }
+
+    status_seq++;
+    status.armed = armed;
+    status.laser_on = !reasons && clear_ticks >= REARM_TICKS;
+    status.reasons = reasons;
+    if (was_on && reasons) status.trips++;
+    if (latency > status.max_latency_cycles) status.max_latency_cycles = latency;
+    status_seq++;
+}
+
+/* Called from the main loop. Cuts the laser if the control tick has stopped. */
+void interlock_update(void) {
+    setpoint_stats_t stats;
+    setpoint_get_stats(&stats);
+
+    uint64_t now = util_clock_cycles64();
+
+    /* the tick only learns the clock is set through here, a sync point, so a replay has it
+     * change on the same tick */
+    if (!clock_set && clock_is_set()) {
+        bool irq = trace_lock();
+        clock_set = true;
+        trace_unlock(irq);
+    }
+
+    if (stats.ticks != last_ticks || stats.ticks == 0) {
+        /* (not started yet counts as alive) */
+        last_ticks = stats.ticks;
+        last_tick_seen = now;
+    } else if (now - last_tick_seen > WATCHDOG_CYCLES) {
+        bool irq = trace_lock();
+        watchdog_tripped = true;
+        laser_off();
+        trace_unlock(irq);
+    }
+}
+
+void interlock_get_status(interlock_status_t* out) {
+    bool irq = trace_lock();
+    uint32_t seq;
+    do {
+        seq = status_seq;
+        *out = status;
+    } while ((seq & 1) || seq != status_seq);
+    trace_unlock(irq);
+}
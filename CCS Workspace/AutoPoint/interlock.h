@@ -0,0 +1,77 @@
+/*
+ * interlock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef INTERLOCK_H_
+#define INTERLOCK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "setpoint.h"
+
+/* Laser safety interlock.
+ *
+ * Runs inside the control tick (see mount.c) and checks every setpoint before anything else
+ * happens in the tick. The laser is only on while it's armed and every check passes:
+ *
+ *  - the clock has been set, so the setpoint is where the target really is
+ *  - the mount is tracking a fresh setpoint
+ *  - the setpoint is above INTERLOCK_MIN_EL_DEG
+ *  - the setpoint clears the site horizon mask by INTERLOCK_MASK_MARGIN_DEG
+ *  - the setpoint is outside every exclusion zone (aircraft avoidance, uploaded over bluetooth)
+ *  - the servo error is under INTERLOCK_MAX_ERROR_DEG (on the sky)
+ *
+ * A failed check turns the laser off from the ISR with direct GPIO stores. The time from tick
+ * entry to that point is measured on every tick, and if it ever goes over INTERLOCK_MAX_LATENCY_US
+ * the interlock latches off until re-armed. So a hazard is cut within one tick period, plus tick
+ * jitter, plus the measured latency. interlock_update() in the main loop cuts the laser if the
+ * tick stops running altogether.
+ */
+
+#define INTERLOCK_MAX_ZONES         8
+
+#define INTERLOCK_MIN_EL_DEG        10.0f
+#define INTERLOCK_MASK_MARGIN_DEG   2.0f
+#define INTERLOCK_MAX_ERROR_DEG     0.5f
+
+#define INTERLOCK_MAX_LATENCY_US    50      /* tick entry to laser cut */
+#define INTERLOCK_REARM_MS          250     /* all clear this long before the laser comes back on */
+#define INTERLOCK_WATCHDOG_MS       10      /* longest gap between ticks before the main loop cuts */
+
+/* Reasons the laser is off */
+#define INTERLOCK_DISARMED          (1<<0)
+#define INTERLOCK_NOT_TRACKING      (1<<1)
+#define INTERLOCK_MIN_EL            (1<<2)
+#define INTERLOCK_HORIZON           (1<<3)
+#define INTERLOCK_ZONE              (1<<4)
+#define INTERLOCK_POINTING_ERROR    (1<<5)
+#define INTERLOCK_LATENCY           (1<<6)  /* latched */
+#define INTERLOCK_WATCHDOG          (1<<7)  /* latched */
+#define INTERLOCK_NO_CLOCK          (1<<8)  /* not set since a cold boot */
+
+/* Az/el box to keep the beam out of, radians. az_min > az_max means the box spans north. */
+typedef struct {
+    float az_min, az_max;
+    float el_min, el_max;
+} interlock_zone_t;
+
+typedef struct {
+    bool armed;
+    bool laser_on;
+    uint32_t reasons;               /* INTERLOCK_* bits holding the laser off, 0 if it's on */
+    uint32_t trips;                 /* times a check cut the laser while it was on */
+    uint32_t max_latency_cycles;    /* worst tick entry to cut decision, measured every tick */
+} interlock_status_t;
+
+void interlock_init(void);
+void interlock_arm(bool arm);
+bool interlock_set_zone(uint32_t index, const interlock_zone_t* zone);
+void interlock_tick(const setpoint_t* sp, bool tracking, float az_err, float el_err);
+void interlock_update(void);
+void interlock_get_status(interlock_status_t* out);
+
+#endif /* INTERLOCK_H_ */
@@ -5,24 +5,31 @@
  *      Author: james
  */
 
-#include "driverlib/gpio.h"
-#include "driverlib/sysctl.h"
-#include "inc/hw_memmap.h"
+#include <stdint.h>
 
+#include "hal.h"
 #include "laser_control.h"
 
+/* Laser switch and laser enable. Pin writes are a single store each, so turning the laser off
+ * is safe from any ISR. */
 void laser_init() {
-    /* laser switch, default to off */
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOB));
+    /* both default to off */
+    hal_pin_output(HAL_PIN_LASER_SWITCH, false);
+    hal_pin_output(HAL_PIN_LASER_ENABLE, false);
+}
 
-    GPIOPinTypeGPIOOutput(GPIO_PORTB_BASE, 1<<5);
-    GPIOPinWrite(GPIO_PORTB_BASE, 1<<5, 0<<5);
+/* Turn the laser on. Only the interlock (interlock.h) should call this. */
+void laser_on(void) {
+    hal_pin_write(HAL_PIN_LASER_ENABLE, true);
+    hal_pin_write(HAL_PIN_LASER_SWITCH, true);
+}
 
-    /* laser enable, default to off */
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOA));
+/* Turn the laser off, switch first. Callable from anywhere, including ISRs. */
+void laser_off(void) {
+    hal_pin_write(HAL_PIN_LASER_SWITCH, false);
+    hal_pin_write(HAL_PIN_LASER_ENABLE, false);
+}
 
-    GPIOPinTypeGPIOOutput(GPIO_PORTA_BASE, 1<<2);
-    GPIOPinWrite(GPIO_PORTA_BASE, 1<<2, 0<<2);
+bool laser_is_on(void) {
+    return hal_pin_read(HAL_PIN_LASER_SWITCH);
 }
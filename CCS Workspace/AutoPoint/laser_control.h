@@ -8,6 +8,11 @@
 #ifndef LASER_CONTROL_H_
 #define LASER_CONTROL_H_
 
+#include <stdbool.h>
+
 void laser_init(void);
+void laser_on(void);
+void laser_off(void);
+bool laser_is_on(void);
 
 #endif /* LASER_CONTROL_H_ */
@@ -0,0 +1,76 @@
+/*
+ * linktest.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util.h"
+#include "bluetooth.h"
+#include "frame.h"
+#include "protocol.h"
+
+#include "linktest.h"
+
+/* Downlink bytes still to send */
+static uint32_t tx_left = 0;
+static uint32_t tx_total = 0;
+static bool tx_end_pending = false;
+
+/* Uplink bytes counted, and when the first started and the last arrived */
+static uint32_t rx_bytes = 0;
+static uint64_t rx_first = 0;
+static uint64_t rx_last = 0;
+
+/* Start streaming 'bytes' of filler (rounded up to whole frames) */
+bool linktest_start_send(uint32_t bytes) {
+    if (tx_left > 0 || tx_end_pending) return false;
+    tx_left = (bytes + LINKTEST_FRAME_BYTES - 1) / LINKTEST_FRAME_BYTES * LINKTEST_FRAME_BYTES;
+    tx_total = tx_left;
+    tx_end_pending = true;
+    return true;
+}
+
+/* Called from the main loop. Tops up the TX buffer while a downlink test is running. */
+void linktest_update(void) {
+    uint8_t fill[LINKTEST_FRAME_BYTES - FRAME_OVERHEAD - 2];
+    uint8_t end[8];
+
+    while (tx_left > 0) {
+        /* counting bytes, so a dropped one shows up on the phone */
+        for (uint32_t i = 0; i < sizeof(fill); i++) fill[i] = (uint8_t) (i + 1);
+
+        if (!bluetooth_send_frame(PROTO_LINK_FILL | PROTO_REPLY, fill, sizeof(fill))) return;
+        tx_left -= LINKTEST_FRAME_BYTES;
+    }
+
+    if (tx_end_pending) {
+        le_put_u32(&end[0], tx_total);
+        le_put_u32(&end[4], bluetooth_get_baud());
+        if (bluetooth_send_frame(PROTO_LINK_SEND | PROTO_REPLY, end, sizeof(end))) tx_end_pending = false;
+    }
+}
+
+/* Count one uplink filler frame of len bytes on the wire. The first one's bytes are counted too,
+ * so the time runs from when it started coming in rather than when it was done. */
+void linktest_receive(uint32_t len) {
+    uint64_t now = util_clock_cycles64();
+    if (rx_bytes == 0) rx_first = now - (uint64_t) len * bluetooth_char_cycles();
+    rx_last = now;
+    rx_bytes += len;
+}
+
+/* Send the uplink count and restart it: bytes, us they took on the wire, baud */
+bool linktest_report(void) {
+    uint8_t buf[12];
+    uint32_t us = (uint32_t) ((rx_last - rx_first) / (UTIL_CLOCK_HZ / 1000000));
+
+    le_put_u32(&buf[0], rx_bytes);
+    le_put_u32(&buf[4], us);
+    le_put_u32(&buf[8], bluetooth_get_baud());
+    rx_bytes = 0;
+    return bluetooth_send_frame(PROTO_LINK_COUNT | PROTO_REPLY, buf, sizeof(buf));
+}
@@ -0,0 +1,32 @@
+/*
+ * linktest.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef LINKTEST_H_
+#define LINKTEST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Bluetooth link throughput test, driven from the phone (the PROTO_LINK_* messages).
+ *
+ * Downlink: the phone asks for a number of bytes, and we stream them back as LINKTEST_FRAME_BYTES
+ * byte filler frames from the main loop, as fast as the TX buffer takes them, then an end marker.
+ * The phone times them arriving.
+ *
+ * Uplink: the phone sends filler frames, which are only counted here. When it asks for the count
+ * it gets the bytes received and the time from the first to the last of them.
+ */
+
+/* on the wire, so the filler is this less the frame overhead */
+#define LINKTEST_FRAME_BYTES 64
+
+bool linktest_start_send(uint32_t bytes);
+void linktest_update(void);
+void linktest_receive(uint32_t len);
+bool linktest_report(void);
+
+#endif /* LINKTEST_H_ */
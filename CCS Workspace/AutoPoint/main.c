@@ -2,32 +2,44 @@
  * main.c
  */
 
-#include "driverlib/gpio.h"
-#include "driverlib/sysctl.h"
-#include "inc/hw_memmap.h"
-
+#include "hal.h"
+#include "util.h"
+#include "clock.h"
 #include "laser_control.h"
 #include "bluetooth.h"
+#include "pointing.h"
+#include "propagator.h"
+#include "setpoint.h"
+#include "mount.h"
+#include "interlock.h"
+#include "linktest.h"
+#include "telemetry.h"
+#include "trace.h"
 
 int main(void) {
-    /* set system clock to 80MHz with 16MHz external crystal */
-    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ | SYSCTL_OSC_MAIN);
+    /* system clock to 80MHz, or stop here */
+    hal_init();
 
-    /* make sure it actually happened */
-    uint32_t clock_freq = SysCtlClockGet();
-    if (clock_freq != 80000000) {
-        while(1);
-    }
+    /* with TRACE_ENABLE, record the session from here (see trace.h) */
+    trace_init();
 
     util_init();
+    clock_init();
     laser_init();
+    interlock_init();
     bluetooth_init();
+    pointing_init();
     propagator_init();
-
-    propagator_test();
+    mount_init();
+    setpoint_init();
 
     /* main loop */
     while(1) {
+        interlock_update();
+        propagator_update();
         bluetooth_handle_packets();
+        linktest_update();
+        telemetry_update();
+        hal_idle();
     }
 }
@@ -0,0 +1,168 @@
+/*
+ * mount.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hal.h"
+#include "util.h"
+#include "setpoint.h"
+#include "mount_control.h"
+#include "stepper.h"
+#include "interlock.h"
+#include "mount.h"
+#include "trace.h"
+
+#define PI 3.14159265f
+#define TWO_PI (2.0f * PI)
+
+#define AZ_RAD_PER_COUNT (TWO_PI / MOUNT_AZ_COUNTS_PER_REV)
+#define EL_RAD_PER_COUNT (TWO_PI / MOUNT_EL_COUNTS_PER_REV)
+
+static mount_pid_t az_pid;
+static mount_pid_t el_pid;
+
+static volatile bool enabled = false;
+
+/* Written by the ISR under a sequence count. Both volatile, so the compiler keeps the stores (and
+ * mount_get_status()'s copy) between the two count accesses. */
+static volatile mount_status_t status;
+static volatile uint32_t status_seq = 0;
+
+#ifndef MOUNT_USE_STEPPERS
+/* Shortest signed angle from a to b */
+static float wrap_pi(float d) {
+    while (d > PI) d -= TWO_PI;
+    while (d < -PI) d += TWO_PI;
+    return d;
+}
+#endif
+
+/* Servo step, called from the setpoint ISR at SETPOINT_RATE_HZ. The interlock sees the setpoint
+ * as it is, the drive a copy held inside the mount's elevation range. */
+static void mount_control_tick(const setpoint_t* sp) {
+    float az, el;
+    float az_err = 0.0f, el_err = 0.0f;
+    float az_duty = 0.0f, el_duty = 0.0f;
+    setpoint_t drive = *sp;
+
+    /* backstop for the propagator's parking: never drive into the elevation stops */
+    if (drive.el < MOUNT_MIN_EL) {
+        drive.el = MOUNT_MIN_EL;
+        drive.el_rate = 0.0f;
+    } else if (drive.el > MOUNT_MAX_EL) {
+        drive.el = MOUNT_MAX_EL;
+        drive.el_rate = 0.0f;
+    }
+
+#ifdef MOUNT_USE_STEPPERS
+    stepper_error(&drive, enabled, &az, &el, &az_err, &el_err);
+
+    /* safety first, before spending any time on the motion profiles */
+    interlock_tick(sp, enabled, az_err, el_err);
+
+    stepper_tick(&drive, enabled, az_err, el_err);
+#else
+    const float dt = 1.0f / SETPOINT_RATE_HZ;
+
+    az = trace_encoder(HAL_AXIS_AZ, hal_encoder_get(HAL_AXIS_AZ)) * AZ_RAD_PER_COUNT;
+    el = trace_encoder(HAL_AXIS_EL, hal_encoder_get(HAL_AXIS_EL)) * EL_RAD_PER_COUNT;
+
+    if (enabled && drive.valid) {
+        /* encoder azimuth is multi-turn, take the short way round to the setpoint */
+        az_err = wrap_pi(drive.az - az);
+        el_err = drive.el - el;
+    }
+
+    /* safety first, before spending any time on the servo */
+    interlock_tick(sp, enabled, az_err, el_err);
+
+    if (enabled && drive.valid) {
+        az_duty = mount_pid_update(&az_pid, az_err, drive.az_rate, dt);
+        el_duty = mount_pid_update(&el_pid, el_err, drive.el_rate, dt);
+    } else {
+        mount_pid_reset(&az_pid);
+        mount_pid_reset(&el_pid);
+    }
+
+    hal_motor_drive(HAL_AXIS_AZ, az_duty);
+    hal_motor_drive(HAL_AXIS_EL, el_duty);
+#endif
+
+    status_seq++;
+    status.az = az;
+    status.el = el;
+    status.az_err = az_err;
+    status.el_err = el_err;
+    status.az_duty = az_duty;
+    status.el_duty = el_duty;
+    status.enabled = enabled;
+    status_seq++;
+}
+
+/* Bring up encoders and motor drive, and hook the servo loop into the setpoint tick.
+ * Call before setpoint_init(). Motors stay off until mount_enable(true).
+ */
+void mount_init(void) {
+    mount_pid_init(&az_pid, &mount_default_gains);
+    mount_pid_init(&el_pid, &mount_default_gains);
+
+#ifdef MOUNT_USE_STEPPERS
+    stepper_init();
+#else
+    hal_encoder_init();
+    hal_motor_init(MOUNT_PWM_HZ);
+#endif
+
+    setpoint_set_consumer(mount_control_tick);
+}
+
+void mount_enable(bool enable) {
+    bool irq = trace_lock();
+    enabled = enable;
+    trace_unlock(irq);
+}
+
+/* Tell the mount where it's currently pointing (radians), e.g. after parking or sighting a star */
+void mount_sync(float az, float el) {
+#ifdef MOUNT_USE_STEPPERS
+    stepper_sync(az, el);
+#else
+    bool irq = hal_irq_disable();
+    bool sync = trace_lock();
+    hal_encoder_set(HAL_AXIS_AZ, (int32_t) (az / AZ_RAD_PER_COUNT));
+    hal_encoder_set(HAL_AXIS_EL, (int32_t) (el / EL_RAD_PER_COUNT));
+    trace_unlock(sync);
+    hal_irq_restore(irq);
+#endif
+}
+
+/* Swap in new gains. The ISR picks them up on its next tick, with a clean controller state.
+ * Interrupts are off while the controller is rewritten, so no tick sees it half done. */
+void mount_set_gains(mount_axis_t axis, const mount_pid_gains_t* gains) {
+    bool irq = hal_irq_disable();
+    bool sync = trace_lock();
+
+    if (axis == MOUNT_AXIS_AZ) {
+        mount_pid_init(&az_pid, gains);
+    } else {
+        mount_pid_init(&el_pid, gains);
+    }
+
+    trace_unlock(sync);
+    hal_irq_restore(irq);
+}
+
+void mount_get_status(mount_status_t* out) {
+    bool irq = trace_lock();
+    uint32_t seq;
+    do {
+        seq = status_seq;
+        *out = status;
+    } while ((seq & 1) || seq != status_seq);
+    trace_unlock(irq);
+}
@@ -0,0 +1,61 @@
+/*
+ * mount.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef MOUNT_H_
+#define MOUNT_H_
+
+#include <stdbool.h>
+
+#include "mount_control.h"
+
+/* Two-axis alt-az mount: brushed DC motors on PWM, quadrature encoders on QEI.
+ *
+ * Azimuth:   QEI0 PhA/PhB on PD6/PD7, H-bridge IN1/IN2 on PB6/PB7 (M0PWM0/M0PWM1)
+ * Elevation: QEI1 PhA/PhB on PC5/PC6, H-bridge IN1/IN2 on PD0/PD1 (M1PWM0/M1PWM1)
+ *
+ * Build with MOUNT_USE_STEPPERS defined for a stepper motor mount instead (see stepper.h); the
+ * encoders and H-bridges are then unused and positions are open loop step counts.
+ *
+ * The servo loop runs in the setpoint tick (see setpoint.h), so it's at SETPOINT_RATE_HZ.
+ * Encoders are zeroed at power up, so the mount must be parked at az 0 / el 0 (or synced with
+ * mount_sync()) before tracking.
+ */
+
+/* Encoder counts per output shaft revolution (4x quadrature decoding, after gearing) */
+#define MOUNT_AZ_COUNTS_PER_REV 200000
+#define MOUNT_EL_COUNTS_PER_REV 200000
+
+#define MOUNT_PWM_HZ 20000
+
+/* Axis limits the pass planner works to (see pass_plan.h). Set MOUNT_MAX_EL to pi for a mount
+ * whose elevation axis can carry on past the zenith. */
+#define MOUNT_MAX_AZ_RATE   0.4f            /* rad/s */
+#define MOUNT_MAX_EL        1.57079633f     /* rad */
+
+/* Lowest elevation the mount is ever driven to, clear of the elevation stop. While the target is
+ * below it the propagator parks the mount here instead (see propagator.c). */
+#define MOUNT_MIN_EL        0.0f            /* rad */
+
+typedef enum {
+    MOUNT_AXIS_AZ = 0,
+    MOUNT_AXIS_EL
+} mount_axis_t;
+
+typedef struct {
+    float az, el;           /* encoder position, radians */
+    float az_err, el_err;   /* setpoint - position, radians */
+    float az_duty, el_duty; /* drive output, -1 to 1 */
+    bool enabled;
+} mount_status_t;
+
+void mount_init(void);
+void mount_enable(bool enable);
+void mount_sync(float az, float el);
+void mount_set_gains(mount_axis_t axis, const mount_pid_gains_t* gains);
+void mount_get_status(mount_status_t* out);
+
+#endif /* MOUNT_H_ */
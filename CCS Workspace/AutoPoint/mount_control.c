@@ -0,0 +1,95 @@
+/*
+ * mount_control.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <math.h>
+
+#include "mount_control.h"
+
+/* Starting point gains, need tuning on the real mount. host/servo_bench runs them against the
+ * plant below. */
+const mount_pid_gains_t mount_default_gains = {
+    .kp = 20.0f,
+    .ki = 40.0f,
+    .kd = 0.2f,
+    .kff = 2.0f,
+    .d_alpha = 0.2f,
+    .out_limit = 0.95f,
+};
+
+static float clamp(float x, float limit) {
+    if (x > limit) return limit;
+    if (x < -limit) return -limit;
+    return x;
+}
+
+void mount_pid_init(mount_pid_t* pid, const mount_pid_gains_t* gains) {
+    pid->g = *gains;
+    mount_pid_reset(pid);
+}
+
+/* Clear the controller state, e.g. after the axis was disabled or the target jumped */
+void mount_pid_reset(mount_pid_t* pid) {
+    pid->integ = 0.0f;
+    pid->prev_err = 0.0f;
+    pid->d_filt = 0.0f;
+    pid->primed = 0;
+}
+
+/* One controller step.
+ *
+ * err: setpoint - position, radians
+ * sp_rate: setpoint rate, rad/s (feed-forward, this does most of the work while tracking)
+ * dt: seconds since the last step
+ *
+ * Returns the drive duty, -out_limit to out_limit.
+ */
+float mount_pid_update(mount_pid_t* pid, float err, float sp_rate, float dt) {
+    const mount_pid_gains_t* g = &pid->g;
+
+    /* filtered derivative of the error, skipped on the first step so we don't kick */
+    if (pid->primed) {
+        float d = (err - pid->prev_err) / dt;
+        pid->d_filt += g->d_alpha * (d - pid->d_filt);
+    }
+    pid->prev_err = err;
+    pid->primed = 1;
+
+    float unsat = g->kff * sp_rate + g->kp * err + g->ki * pid->integ + g->kd * pid->d_filt;
+    float out = clamp(unsat, g->out_limit);
+
+    /* anti-windup: only integrate if that doesn't push further into saturation */
+    if (out == unsat || (unsat > 0) != (err > 0)) {
+        pid->integ += err * dt;
+    }
+
+    return out;
+}
+
+/* Advance the simulated plant by dt seconds with the given drive duty (-1 to 1). */
+void mount_plant_step(mount_plant_t* p, float duty, float dt) {
+    /* linear motor curve: torque falls off with speed, reaching zero at the no load rate */
+    float torque = p->stall_torque * (duty - p->rate / p->no_load_rate);
+
+    /* coulomb friction opposes motion, or holds the axis if the drive can't overcome it */
+    if (p->rate != 0.0f) {
+        torque -= p->rate > 0 ? p->friction : -p->friction;
+    } else if (fabsf(torque) <= p->friction) {
+        torque = 0.0f;
+    } else {
+        torque -= torque > 0 ? p->friction : -p->friction;
+    }
+
+    float new_rate = p->rate + torque / p->inertia * dt;
+
+    /* friction can stop the axis but not reverse it */
+    if (p->rate != 0.0f && (new_rate > 0) != (p->rate > 0) && fabsf(duty * p->stall_torque) <= p->friction) {
+        new_rate = 0.0f;
+    }
+
+    p->pos += 0.5f * (p->rate + new_rate) * dt;
+    p->rate = new_rate;
+}
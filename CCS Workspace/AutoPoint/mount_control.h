@@ -0,0 +1,56 @@
+/*
+ * mount_control.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef MOUNT_CONTROL_H_
+#define MOUNT_CONTROL_H_
+
+/* Per-axis mount servo math: PID with velocity feed-forward, plus a simple simulated plant.
+ *
+ * Nothing in here touches hardware, so it builds and runs on a PC as-is. mount.c wires it up to
+ * QEI / PWM and the setpoint tick; host/servo_bench puts the default gains through a step and a
+ * tracking ramp against the plant.
+ */
+
+typedef struct {
+    float kp;           /* duty per radian of error */
+    float ki;           /* duty per radian-second */
+    float kd;           /* duty per rad/s of error rate */
+    float kff;          /* duty per rad/s of setpoint rate */
+    float d_alpha;      /* derivative low-pass, 0..1 (1 = unfiltered) */
+    float out_limit;    /* output clamp, duty fraction 0..1 */
+} mount_pid_gains_t;
+
+typedef struct {
+    mount_pid_gains_t g;
+    float integ;
+    float prev_err;
+    float d_filt;
+    int primed;
+} mount_pid_t;
+
+extern const mount_pid_gains_t mount_default_gains;
+
+void mount_pid_init(mount_pid_t* pid, const mount_pid_gains_t* gains);
+void mount_pid_reset(mount_pid_t* pid);
+float mount_pid_update(mount_pid_t* pid, float err, float sp_rate, float dt);
+
+/* Brushed DC motor + geared axis, referred to the output shaft.
+ *
+ * Torque ~ duty * stall torque, minus back-EMF and viscous friction, plus coulomb friction.
+ */
+typedef struct {
+    float inertia;      /* kg m^2 */
+    float stall_torque; /* N m at full duty, zero speed */
+    float no_load_rate; /* rad/s at full duty, no load */
+    float friction;     /* coulomb friction torque, N m */
+    float pos;          /* rad */
+    float rate;         /* rad/s */
+} mount_plant_t;
+
+void mount_plant_step(mount_plant_t* plant, float duty, float dt);
+
+#endif /* MOUNT_CONTROL_H_ */
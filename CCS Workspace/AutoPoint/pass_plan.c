@@ -0,0 +1,370 @@
+/*
+ * pass_plan.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pass_plan.h"
+
+#define PI 3.14159265f
+#define TWO_PI (2.0f * PI)
+
+/* Coarse step while looking for the start of the next pass, minutes */
+#define SEARCH_STEP_MIN 0.5f
+
+#define STEP_MIN (PASS_PLAN_STEP_S / 60.0f)
+
+/* How far past the shortest feasible keyhole window to keep looking for a better one, in steps */
+#define FIT_EXTRA_STEPS 60
+
+/* Sampled pass, quantized to keep it to 4 bytes a sample:
+ * az in units of 2pi / 65536 (~20 arcsec), el in units of pi / 32768 (~20 arcsec) */
+static uint16_t samp_az[PASS_PLAN_MAX_SAMPLES];
+static int16_t samp_el[PASS_PLAN_MAX_SAMPLES];
+static uint32_t samp_count;
+
+static float wrap_pi(float a) {
+    while (a > PI) a -= TWO_PI;
+    while (a < -PI) a += TWO_PI;
+    return a;
+}
+
+static float wrap_2pi(float a) {
+    while (a >= TWO_PI) a -= TWO_PI;
+    while (a < 0.0f) a += TWO_PI;
+    return a;
+}
+
+static float az_at(uint32_t i) {
+    return samp_az[i] * (TWO_PI / 65536.0f);
+}
+
+static float el_at(uint32_t i) {
+    return samp_el[i] * (PI / 32768.0f);
+}
+
+static void store(uint32_t i, float az, float el) {
+    samp_az[i] = (uint16_t) (int32_t) (wrap_2pi(az) * (65536.0f / TWO_PI));
+    samp_el[i] = (int16_t) (el * (32768.0f / PI));
+}
+
+/* Angle between two az/el directions. Elevations past 90 degrees are fine (cos goes negative). */
+static float separation(float az1, float el1, float az2, float el2) {
+    float d = sinf(el1) * sinf(el2) + cosf(el1) * cosf(el2) * cosf(az1 - az2);
+    if (d > 1.0f) d = 1.0f;
+    if (d < -1.0f) d = -1.0f;
+    return acosf(d);
+}
+
+/* Map the target position to mount az/el following the plan.
+ *
+ * az, el: in: target position, out: mount position (radians). Outside any keyhole window this
+ * is the target itself (flipped over the top after an over-the-top window).
+ */
+void pass_plan_apply(const pass_plan_t* plan, float tsince, float max_el, float* az, float* el) {
+    if (!plan->valid || plan->mode == PASS_PLAN_NONE) return;
+    if (tsince < plan->win_start) return;
+
+    if (tsince > plan->win_end) {
+        if (plan->mode == PASS_PLAN_OVER_THE_TOP) {
+            *az = wrap_2pi(*az + PI);
+            *el = PI - *el;
+            if (*el > max_el) *el = max_el;
+        }
+        return;
+    }
+
+    /* inside the window: azimuth on the ramp, elevation the closest point to the target in the
+     * vertical plane at that azimuth (past 90 degrees if the azimuth is more than 90 off) */
+    float s = (tsince - plan->win_start) / (plan->win_end - plan->win_start);
+    float mount_az = plan->win_az + s * plan->win_az_delta;
+    float mount_el = atan2f(sinf(*el), cosf(*el) * cosf(*az - mount_az));
+
+    if (mount_el > max_el) mount_el = max_el;
+
+    *az = wrap_2pi(mount_az);
+    *el = mount_el;
+}
+
+/* A plan in the making (pass_plan_start() / pass_plan_step()). One step is one sample of the
+ * target or SIM_CHUNK samples of a candidate's simulation. */
+#define SIM_CHUNK 32
+
+typedef enum {
+    JOB_SEARCH = 0,     /* coarse search for the target coming up */
+    JOB_SAMPLE,         /* fine sampling from AOS to LOS */
+    JOB_FIT,            /* simulating candidate windows */
+    JOB_DONE
+} job_phase_t;
+
+static struct {
+    job_phase_t phase;
+    float from, end;            /* search span, minutes since TLE epoch */
+    float max_az_rate, max_el;
+    float t;                    /* where the fine sampling starts */
+    uint32_t i;                 /* coarse, then fine step */
+    float pending_from;         /* the pass can't start before this */
+
+    pass_plan_t base;           /* the sampled pass, before any strategy */
+    pass_plan_t cand;           /* candidate being simulated */
+    pass_plan_t best;           /* best candidate so far for this strategy */
+    pass_plan_t flip;           /* the flip plan, while over the top is tried */
+    bool have_best;
+
+    uint32_t first, last;       /* samples where the target is too fast to follow */
+    uint32_t a, b;              /* candidate window */
+    float swing;                /* unwrapped target azimuth change across it */
+    uint32_t extra;             /* windows tried past the shortest feasible one */
+
+    uint32_t sim_i;             /* simulation of cand: next sample */
+    float sim_az, sim_el;       /* and the mount position at the one before */
+} job;
+
+/* Run the candidate plan over up to SIM_CHUNK more samples of the pass, recording its peak rates
+ * and pointing error. Returns true once it's been over the whole pass. */
+static bool simulate(pass_plan_t* plan, float max_el) {
+    if (job.sim_i == 0) {
+        plan->peak_az_rate = 0.0f;
+        plan->peak_el_rate = 0.0f;
+        plan->peak_error = 0.0f;
+    }
+
+    uint32_t end = job.sim_i + SIM_CHUNK;
+    if (end > samp_count) end = samp_count;
+
+    for (uint32_t i = job.sim_i; i < end; i++) {
+        float tgt_az = az_at(i);
+        float tgt_el = el_at(i);
+        float az = tgt_az;
+        float el = tgt_el;
+
+        pass_plan_apply(plan, plan->aos + i * STEP_MIN, max_el, &az, &el);
+
+        float err = separation(az, el, tgt_az, tgt_el);
+        if (err > plan->peak_error) plan->peak_error = err;
+
+        if (i > 0) {
+            float az_rate = fabsf(wrap_pi(az - job.sim_az)) / PASS_PLAN_STEP_S;
+            float el_rate = fabsf(el - job.sim_el) / PASS_PLAN_STEP_S;
+            if (az_rate > plan->peak_az_rate) plan->peak_az_rate = az_rate;
+            if (el_rate > plan->peak_el_rate) plan->peak_el_rate = el_rate;
+        }
+
+        job.sim_az = az;
+        job.sim_el = el;
+    }
+
+    job.sim_i = end;
+    return end == samp_count;
+}
+
+/* Put the keyhole window on samples [a, b]: a straight azimuth ramp from the target azimuth at a
+ * to the target azimuth at b (plus pi if flipping over the top). swing is the unwrapped target
+ * azimuth change from a to b. */
+static void set_window(pass_plan_t* plan, uint32_t a, uint32_t b, float swing) {
+    plan->win_start = plan->aos + a * STEP_MIN;
+    plan->win_end = plan->aos + b * STEP_MIN;
+    plan->win_az = az_at(a);
+    plan->win_az_delta = (plan->mode == PASS_PLAN_OVER_THE_TOP) ? wrap_pi(swing + PI) : swing;
+}
+
+/* Widen the window by one sample at each end (where possible). Returns false if it already covers the pass. */
+static bool grow(uint32_t* a, uint32_t* b, float* swing) {
+    if (*a == 0 && *b == samp_count - 1) return false;
+
+    if (*a > 0) {
+        *swing += wrap_pi(az_at(*a) - az_at(*a - 1));
+        (*a)--;
+    }
+    if (*b < samp_count - 1) {
+        *swing += wrap_pi(az_at(*b + 1) - az_at(*b));
+        (*b)++;
+    }
+    return true;
+}
+
+/* Start fitting the keyhole window for mode, from the samples where the target is too fast to
+ * follow directly (or just simulate the pass as it is, for PASS_PLAN_NONE).
+ *
+ * First grow the window until the ramp across it is within the azimuth rate limit. A longer
+ * window than that can still lower the pointing error (the ramp matches the target's S-shaped
+ * azimuth swing better), so fit_next() keeps growing it for a while and keeps the best one. */
+static void fit_begin(pass_plan_mode_t mode) {
+    job.cand = job.base;
+    job.cand.mode = mode;
+    job.have_best = false;
+    job.extra = 0;
+    job.sim_i = 0;
+
+    if (mode == PASS_PLAN_NONE) return;
+
+    job.a = job.first;
+    job.b = job.last;
+    job.swing = 0.0f;
+    for (uint32_t i = job.a; i < job.b; i++) {
+        job.swing += wrap_pi(az_at(i + 1) - az_at(i));
+    }
+
+    while (true) {
+        set_window(&job.cand, job.a, job.b, job.swing);
+        if (fabsf(job.cand.win_az_delta) <= job.max_az_rate * (job.b - job.a) * PASS_PLAN_STEP_S) break;
+        if (!grow(&job.a, &job.b, &job.swing)) break; /* covers the whole pass, best we can do */
+    }
+}
+
+/* The candidate's been simulated: keep it if it's the best yet and move on to the next window,
+ * or the next strategy. Returns true when there's nothing left to try, with the plan in *out. */
+static bool fit_next(pass_plan_t* out) {
+    if (!job.have_best || job.cand.peak_error < job.best.peak_error) job.best = job.cand;
+    job.have_best = true;
+
+    if (job.cand.mode != PASS_PLAN_NONE && job.extra < FIT_EXTRA_STEPS &&
+        grow(&job.a, &job.b, &job.swing)) {
+        job.extra++;
+        set_window(&job.cand, job.a, job.b, job.swing);
+        job.sim_i = 0;
+        return false;
+    }
+
+    /* try both strategies, keep the one that stays closest to the target */
+    if (job.best.mode == PASS_PLAN_FLIP && job.max_el > PI / 2) {
+        job.flip = job.best;
+        fit_begin(PASS_PLAN_OVER_THE_TOP);
+        return false;
+    }
+    if (job.best.mode == PASS_PLAN_OVER_THE_TOP && job.flip.peak_error <= job.best.peak_error) {
+        *out = job.flip;
+    } else {
+        *out = job.best;
+    }
+    return true;
+}
+
+/* The pass is sampled: find where tracking the target directly exceeds the azimuth rate limit */
+static void sampled(void) {
+    job.base.los = job.base.aos + (samp_count - 1) * STEP_MIN;
+    job.base.valid = true;
+    job.base.raw_peak_az_rate = 0.0f;
+    job.first = samp_count;
+    job.last = 0;
+
+    for (uint32_t i = 0; i + 1 < samp_count; i++) {
+        float rate = fabsf(wrap_pi(az_at(i + 1) - az_at(i))) / PASS_PLAN_STEP_S;
+        if (rate > job.base.raw_peak_az_rate) job.base.raw_peak_az_rate = rate;
+        if (rate > job.max_az_rate) {
+            if (i < job.first) job.first = i;
+            job.last = i + 1;
+        }
+    }
+
+    fit_begin(job.first == samp_count ? PASS_PLAN_NONE : PASS_PLAN_FLIP);
+    job.phase = JOB_FIT;
+}
+
+/* Give up on a pass: none in the span, or the propagation failed. The caller looks again after
+ * plan->los, the end of the span. */
+static bool no_pass(pass_plan_t* out) {
+    *out = job.base;
+    out->valid = false;
+    out->mode = PASS_PLAN_NONE;
+    out->los = job.end;
+    job.phase = JOB_DONE;
+    return true;
+}
+
+/* Start planning the next pass starting at or after tsince_from (minutes since TLE epoch, looking
+ * at most search_minutes ahead), for a mount with the given azimuth rate limit (rad/s) and
+ * elevation limit (radians, pi/2 for no over-the-top). The work is done by pass_plan_step(). */
+void pass_plan_start(float tsince_from, float search_minutes, float max_az_rate, float max_el) {
+    job.phase = JOB_SEARCH;
+    job.from = tsince_from;
+    job.end = tsince_from + search_minutes;
+    job.max_az_rate = max_az_rate;
+    job.max_el = max_el;
+    job.i = 0;
+    job.pending_from = tsince_from;
+
+    job.base.valid = false;
+    job.base.mode = PASS_PLAN_NONE;
+    job.base.los = job.end;
+}
+
+/* One step of the plan pass_plan_start() began: a target sample or a slice of simulation. Returns
+ * true when the plan is made, with it in *plan (plan->valid false if there's no pass in the search
+ * span; plan->los is then the end of the span so the caller knows when to look again). *plan
+ * isn't touched before that. */
+bool pass_plan_step(pass_plan_t* plan, pass_plan_sampler_t sample, void* ctx) {
+    float az, el;
+
+    switch (job.phase) {
+    case JOB_SEARCH:
+        /* coarse search for the target coming up, then back up one step for the fine sampling.
+         * Steps are counted from the start rather than added up: years from the TLE epoch (an
+         * unset clock), a float minute count has no half minutes left to add. */
+        job.t = job.from + job.i * SEARCH_STEP_MIN;
+        if (job.t > job.end) return no_pass(plan);
+        if (!sample(ctx, job.t, &az, &el)) return no_pass(plan);
+
+        if (el > 0.0f) {
+            if (job.i > 0) job.t -= SEARCH_STEP_MIN;
+            job.i = 0;
+            samp_count = 0;
+            job.phase = JOB_SAMPLE;
+        } else {
+            /* the fine sampling starts no earlier than here */
+            job.pending_from = job.t;
+            job.i++;
+        }
+        return false;
+
+    case JOB_SAMPLE: {
+        /* fine sample from AOS to LOS, counted from the start like the search */
+        float t = job.t + job.i++ * STEP_MIN;
+        if (!sample(ctx, t, &az, &el)) return no_pass(plan);
+
+        if (el > 0.0f) {
+            if (samp_count == 0) job.base.aos = job.pending_from = t;
+            store(samp_count++, az, el);
+        } else if (samp_count > 0) {
+            if (samp_count < 2) return no_pass(plan);
+            sampled();
+            return false;
+        } else if (t > job.end) {
+            /* only ever up for a moment, between two fine samples */
+            return no_pass(plan);
+        }
+
+        if (samp_count == PASS_PLAN_MAX_SAMPLES) sampled();
+        return false;
+    }
+
+    case JOB_FIT:
+        if (!simulate(&job.cand, job.max_el)) return false;
+        if (!fit_next(plan)) return false;
+        job.phase = JOB_DONE;
+        return true;
+
+    default:
+        return true;
+    }
+}
+
+/* While a plan is being made: nothing before this (minutes since TLE epoch) can be in the pass
+ * being planned, so the target can be tracked directly up to here. */
+float pass_plan_pending_from(void) {
+    return job.pending_from;
+}
+
+/* Make the whole plan in one go (pass_plan_start(), then pass_plan_step() until it's done).
+ * Returns plan->valid. */
+bool pass_plan_compute(pass_plan_t* plan, pass_plan_sampler_t sample, void* ctx,
+                       float tsince_from, float search_minutes, float max_az_rate, float max_el) {
+    pass_plan_start(tsince_from, search_minutes, max_az_rate, max_el);
+    while (!pass_plan_step(plan, sample, ctx));
+    return plan->valid;
+}
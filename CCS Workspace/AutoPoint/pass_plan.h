@@ -0,0 +1,76 @@
+/*
+ * pass_plan.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef PASS_PLAN_H_
+#define PASS_PLAN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Keyhole (zenith pass) planner for the alt-az mount.
+ *
+ * A pass that culminates near the zenith needs an azimuth rate that blows up as 1 / zenith distance.
+ * Ahead of each pass the planner samples the whole pass once, finds the stretch where the
+ * azimuth rate exceeds what the mount can do, and picks a strategy for it:
+ *
+ *  PASS_PLAN_FLIP:         start the 180 degree azimuth swing early and spread it over a window
+ *                          around culmination at a rate the mount can follow
+ *  PASS_PLAN_OVER_THE_TOP: keep the azimuth roughly where it is and carry elevation past 90 degrees
+ *                          (only if the mount's elevation range allows it)
+ *
+ * Inside the window the azimuth follows a straight ramp and the elevation is the closest point to
+ * the target in the vertical plane at that azimuth. Both strategies are simulated over the sampled
+ * pass, and the one with the lower worst-case pointing error wins.
+ *
+ * Planning a pass takes a few hundred target samples to find it, up to PASS_PLAN_MAX_SAMPLES more
+ * over it and a simulation of the sampled pass per candidate window, which is far too long to
+ * hold up the main loop for. So it's done in steps: pass_plan_start(), then pass_plan_step() as
+ * often as the caller can spare the time, each one a single target sample or a short slice of
+ * simulation. pass_plan_compute() does the lot in one go, for the host.
+ *
+ * The live control path only calls pass_plan_apply(), which is a couple of comparisons and one
+ * projection per propagated state. Nothing in here touches hardware.
+ */
+
+#define PASS_PLAN_STEP_S        1.0f    /* sampling interval over the pass */
+#define PASS_PLAN_MAX_SAMPLES   1024    /* longest pass we can plan, in steps */
+
+typedef enum {
+    PASS_PLAN_NONE = 0,         /* no keyhole, track the target directly */
+    PASS_PLAN_FLIP,
+    PASS_PLAN_OVER_THE_TOP
+} pass_plan_mode_t;
+
+typedef struct {
+    bool valid;
+    pass_plan_mode_t mode;
+
+    float aos, los;             /* pass start / end, minutes since TLE epoch */
+    float win_start, win_end;   /* keyhole window, minutes since TLE epoch */
+    float win_az;               /* mount azimuth at win_start, radians */
+    float win_az_delta;         /* azimuth change over the window, radians */
+
+    /* simulated over the sampled pass */
+    float raw_peak_az_rate;     /* rad/s, tracking the target directly */
+    float peak_az_rate;         /* rad/s, following the plan */
+    float peak_el_rate;         /* rad/s, following the plan */
+    float peak_error;           /* rad, worst angular distance between plan and target */
+} pass_plan_t;
+
+/* Samples the target's (true, refracted) az/el at tsince minutes. Returns false on propagation error. */
+typedef bool (*pass_plan_sampler_t)(void* ctx, float tsince, float* az, float* el);
+
+void pass_plan_start(float tsince_from, float search_minutes, float max_az_rate, float max_el);
+bool pass_plan_step(pass_plan_t* plan, pass_plan_sampler_t sample, void* ctx);
+float pass_plan_pending_from(void);
+
+bool pass_plan_compute(pass_plan_t* plan, pass_plan_sampler_t sample, void* ctx,
+                       float tsince_from, float search_minutes, float max_az_rate, float max_el);
+
+void pass_plan_apply(const pass_plan_t* plan, float tsince, float max_el, float* az, float* el);
+
+#endif /* PASS_PLAN_H_ */
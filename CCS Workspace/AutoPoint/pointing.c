@@ -0,0 +1,142 @@
+/*
+ * pointing.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "storage.h"
+#include "horizon.h"
+#include "pointing_model.h"
+#include "pointing.h"
+
+#define PI 3.14159265f
+
+/* WGS84 ellipsoid, km */
+#define WGS84_A     6378.137f
+#define WGS84_E2    0.00669437999f
+
+/* Earth rotation rate, rad/s */
+#define EARTH_OMEGA 7.292115e-5f
+
+/* Observing site, geodetic. Persisted in flash, set over bluetooth. */
+typedef struct {
+    float lat;  /* radians, north positive */
+    float lon;  /* radians, east positive */
+    float alt;  /* km above the ellipsoid */
+} site_t;
+
+static site_t site = { 0.0f, 0.0f, 0.0f };
+
+/* Everything the per-tick conversion needs that only depends on the site */
+static float site_ecef[3];
+static float sin_lat, cos_lat, sin_lon, cos_lon;
+
+static void site_precompute(void) {
+    sin_lat = sinf(site.lat);
+    cos_lat = cosf(site.lat);
+    sin_lon = sinf(site.lon);
+    cos_lon = cosf(site.lon);
+
+    float n = WGS84_A / sqrtf(1.0f - WGS84_E2 * sin_lat * sin_lat);
+    site_ecef[0] = (n + site.alt) * cos_lat * cos_lon;
+    site_ecef[1] = (n + site.alt) * cos_lat * sin_lon;
+    site_ecef[2] = (n * (1.0f - WGS84_E2) + site.alt) * sin_lat;
+}
+
+void pointing_init(void) {
+    horizon_init();
+    pointing_model_init();
+
+    const site_t* stored = (const site_t*) storage_get(STORAGE_SLOT_SITE, sizeof(site_t));
+    if (stored) site = *stored;
+
+    site_precompute();
+}
+
+/* Set the observing site (radians, radians, km) and save it to flash. False, with nothing changed,
+ * if flash can't be written now (see storage.h). */
+bool pointing_set_site(float lat, float lon, float alt) {
+    if (lat < -PI / 2 || lat > PI / 2) return false;
+    if (lon < -PI || lon > 2 * PI) return false;
+    if (!storage_writable()) return false;
+
+    site.lat = lat;
+    site.lon = lon;
+    site.alt = alt;
+    site_precompute();
+
+    return storage_save(STORAGE_SLOT_SITE, &site, sizeof(site));
+}
+
+/* Convert a TEME position (km) and velocity (km/s) to topocentric az/el and az/el rates
+ * for the current site.
+ *
+ * sin_g, cos_g: of greenwich mean sidereal time at the position's epoch (see sidereal.h)
+ *
+ * Polar motion and the TEME/PEF distinction are ignored (sub-arcsecond at our ranges).
+ * Refraction and the horizon mask are applied from the precomputed tables in horizon.c, then the
+ * mount pointing model (pointing_model.c) turns the apparent position into mount coordinates.
+ */
+void pointing_teme_to_azel(const float r[3], const float v[3], float sin_g, float cos_g, pointing_t* out) {
+    /* TEME -> ECEF (rotate by GMST about z) */
+    float x =  cos_g * r[0] + sin_g * r[1];
+    float y = -sin_g * r[0] + cos_g * r[1];
+
+    /* velocity picks up the frame rotation: v_ecef = R v_teme - omega x r_ecef */
+    float vx =  cos_g * v[0] + sin_g * v[1] + EARTH_OMEGA * y;
+    float vy = -sin_g * v[0] + cos_g * v[1] - EARTH_OMEGA * x;
+    float vz =  v[2];
+
+    /* relative to the site */
+    float dx = x - site_ecef[0];
+    float dy = y - site_ecef[1];
+    float dz = r[2] - site_ecef[2];
+
+    /* ECEF -> local east / north / up */
+    float e = -sin_lon * dx + cos_lon * dy;
+    float n = -sin_lat * cos_lon * dx - sin_lat * sin_lon * dy + cos_lat * dz;
+    float u =  cos_lat * cos_lon * dx + cos_lat * sin_lon * dy + sin_lat * dz;
+
+    float ve = -sin_lon * vx + cos_lon * vy;
+    float vn = -sin_lat * cos_lon * vx - sin_lat * sin_lon * vy + cos_lat * vz;
+    float vu =  cos_lat * cos_lon * vx + cos_lat * sin_lon * vy + sin_lat * vz;
+
+    float horiz2 = e * e + n * n;
+    float horiz = sqrtf(horiz2);
+    float range2 = horiz2 + u * u;
+    float range = sqrtf(range2);
+
+    float az = atan2f(e, n);
+    if (az < 0.0f) az += 2 * PI;
+    float el = horizon_refract(atan2f(u, horiz));
+
+    out->range = range;
+    out->clear = horizon_is_clear(az, el);
+
+    /* Mount model, evaluated from the direction cosines we already have */
+    float d_az = 0.0f, d_el = 0.0f;
+    if (horiz > 1e-3f) {
+        pointing_model_apply(e / horiz, n / horiz, u / range, horiz / range, &d_az, &d_el);
+    }
+
+    az += d_az;
+    if (az < 0.0f) az += 2 * PI;
+    if (az >= 2 * PI) az -= 2 * PI;
+
+    out->az = az;
+    out->el = el + d_el;
+
+    /* d/dt of atan2(e, n) and atan2(u, horiz). Undefined straight overhead, just report 0 there. */
+    if (horiz > 1e-3f) {
+        out->az_rate = (n * ve - e * vn) / horiz2;
+        out->el_rate = (vu * horiz2 - u * (e * ve + n * vn)) / (horiz * range2);
+    } else {
+        out->az_rate = 0.0f;
+        out->el_rate = 0.0f;
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ * pointing.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef POINTING_H_
+#define POINTING_H_
+
+#include <stdbool.h>
+
+/* Az/el stage: turns a propagated TEME position into where the mount should point. */
+
+typedef struct {
+    float az;       /* mount azimuth, radians, 0 to 2pi clockwise from true north */
+    float el;       /* mount elevation (refracted, pointing model applied), radians */
+    float az_rate;  /* rad/s */
+    float el_rate;  /* rad/s, geometric (refraction rate ignored) */
+    float range;    /* slant range, km */
+    bool clear;     /* line of sight clears the site horizon mask (judged before the pointing model) */
+} pointing_t;
+
+void pointing_init(void);
+bool pointing_set_site(float lat, float lon, float alt);
+void pointing_teme_to_azel(const float r[3], const float v[3], float sin_g, float cos_g, pointing_t* out);
+
+#endif /* POINTING_H_ */
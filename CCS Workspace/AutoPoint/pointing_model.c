@@ -0,0 +1,58 @@
+/*
+ * pointing_model.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "storage.h"
+#include "pointing_model.h"
+
+/* Keep sec / tan finite near the zenith, where the mount can't follow anyway (~89.4 deg) */
+#define MIN_COS_EL 0.01f
+
+static float terms[PM_TERM_COUNT];
+
+/* Load the uploaded model out of flash, or run with no corrections */
+void pointing_model_init(void) {
+    const float* stored = (const float*) storage_get(STORAGE_SLOT_POINTING_MODEL, sizeof(terms));
+
+    if (stored) {
+        memcpy(terms, stored, sizeof(terms));
+    } else {
+        memset(terms, 0, sizeof(terms));
+    }
+}
+
+/* Replace the model and save it to flash. False, with nothing changed, if flash can't be written
+ * now (see storage.h). */
+bool pointing_model_set(const float new_terms[PM_TERM_COUNT]) {
+    if (!storage_writable()) return false;
+    memcpy(terms, new_terms, sizeof(terms));
+    return storage_save(STORAGE_SLOT_POINTING_MODEL, terms, sizeof(terms));
+}
+
+/* Evaluate the model at the target position, given as sin/cos of az and el.
+ * Outputs the corrections (radians) to add to the target az/el.
+ */
+void pointing_model_apply(float sin_az, float cos_az, float sin_el, float cos_el, float* d_az, float* d_el) {
+    if (cos_el < MIN_COS_EL) cos_el = MIN_COS_EL;
+
+    float sec_el = 1.0f / cos_el;
+    float tan_el = sin_el * sec_el;
+
+    *d_az = -terms[PM_IA]
+            - terms[PM_CA] * sec_el
+            - tan_el * (terms[PM_NPAE] + terms[PM_AN] * sin_az + terms[PM_AW] * cos_az)
+            + terms[PM_ACEC] * cos_az
+            + terms[PM_ACES] * sin_az;
+
+    *d_el = terms[PM_IE]
+            - terms[PM_AN] * cos_az
+            + terms[PM_AW] * sin_az
+            + (terms[PM_TF] + terms[PM_ECEC]) * cos_el
+            + terms[PM_ECES] * sin_el;
+}
@@ -0,0 +1,45 @@
+/*
+ * pointing_model.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef POINTING_MODEL_H_
+#define POINTING_MODEL_H_
+
+#include <stdbool.h>
+
+/* Mount pointing model: TPOINT-style alt-az terms, fitted off-device (host/pm_fit) from star or
+ * satellite sightings and uploaded. Angles in radians. TF and ECEC are the same function of
+ * elevation, so a fit can't separate them; pm_fit puts their sum in TF.
+ *
+ * Applied as mount = target + correction:
+ *
+ *  dAz = -IA - CA sec(E) - NPAE tan(E) - AN sin(A) tan(E) - AW cos(A) tan(E) + ACEC cos(A) + ACES sin(A)
+ *  dEl =  IE - AN cos(A) + AW sin(A) + TF cos(E) + ECEC cos(E) + ECES sin(E)
+ *
+ * Every term is a product of sin/cos of the target az/el the az/el stage already has, so applying
+ * the model is a handful of multiply-adds with no trig and no iteration.
+ */
+
+typedef enum {
+    PM_IA = 0,  /* azimuth index error */
+    PM_IE,      /* elevation index error */
+    PM_NPAE,    /* az/el axis non-perpendicularity */
+    PM_CA,      /* beam / elevation axis non-perpendicularity (collimation) */
+    PM_AN,      /* azimuth axis tilt, north */
+    PM_AW,      /* azimuth axis tilt, west */
+    PM_TF,      /* tube flexure */
+    PM_ACEC,    /* azimuth encoder centering, cos */
+    PM_ACES,    /* azimuth encoder centering, sin */
+    PM_ECEC,    /* elevation encoder centering, cos */
+    PM_ECES,    /* elevation encoder centering, sin */
+    PM_TERM_COUNT
+} pointing_model_term_t;
+
+void pointing_model_init(void);
+bool pointing_model_set(const float terms[PM_TERM_COUNT]);
+void pointing_model_apply(float sin_az, float cos_az, float sin_el, float cos_el, float* d_az, float* d_el);
+
+#endif /* POINTING_MODEL_H_ */
@@ -5,66 +5,236 @@
  *      Author: james
  */
 
+#include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
 
 #include "util.h"
 #include "clock.h"
+#include "sidereal.h"
 #include "sgp4_wrapper.h"
+#include "pointing.h"
+#include "setpoint.h"
+#include "mount.h"
+#include "pass_plan.h"
+#include "catalog.h"
 
 #include "propagator.h"
 
-char TLE_LINE1[130] = "1 25544U 98067A   17360.63489756  .00001290  00000-0  26644-4 0  9993";
-char TLE_LINE2[130] = "2 25544  51.6415 158.9361 0002587 294.1321 164.6117 15.54215205 91681";
-
-/* Run the sgp4 lib in "catalog" mode, where it takes normal TLEs */
-const char typerun = 'c';
+/* Propagated states are pushed to the setpoint generator this far apart, and the first one
+ * this far ahead of now (so the ISR never starts on an empty queue). */
+#define KNOT_INTERVAL_CYCLES    (UTIL_CLOCK_HZ / 4)
+#define KNOT_LEAD_CYCLES        (UTIL_CLOCK_HZ / 2)
+
+/* How far ahead to look for the next pass, minutes */
+#define PASS_SEARCH_MINUTES     120.0f
+
+/* Main loop time given to keyhole planning per call, so bluetooth RX (~90 ms to fill its buffer at
+ * 115200) and the knot queue (KNOT_LEAD_CYCLES) never wait on it. A slice overruns this by at most
+ * one pass_plan_step(): one propagation, or a short slice of simulation. */
+#define PLAN_BUDGET_CYCLES      (UTIL_CLOCK_HZ / 100)
+
+/* Time step for differencing knot rates through a keyhole plan, minutes */
+#define PLAN_RATE_DT            (0.1f / 60.0f)
+
+/* The satellite being tracked: our own copy of its catalog entry (sgp4 writes to the satrec as it
+ * goes, and the catalog can be replaced under us by an upload), and which revision of it that is.
+ * The epoch is kept at full precision (satrec's float jdsatepoch is only good to ~0.25 day). */
+static elsetrec current_sat;
+static clock_time_t sat_epoch;
+static uint32_t target_norad;
+static uint32_t target_revision;
+
+/* Keyhole plan for the current (or next) pass. While the next one is being made (planning), plan
+ * isn't valid and knots track the target directly, up to where that pass could start. */
+static pass_plan_t plan;
+static bool plan_ready;
+static bool planning;
+static float plan_from;
+
+/* GMST at the knots, stepped along with them */
+static sidereal_t knot_gmst;
+
+/* Where the mount waits while the target is down: the azimuth it comes up at on the planned pass
+ * (park_ready), or wherever the last knot left it. */
+static float park_az;
+static bool park_ready;
+static float last_az;
+
+static void load_target(const catalog_entry_t* e) {
+    current_sat = e->satrec;
+    sat_epoch = e->epoch;
+    target_norad = e->elements.norad;
+    target_revision = e->revision;
+    plan_ready = false;
+    planning = false;
+    park_ready = false;
+}
 
-/* Doesn't matter, since we're not in manual input mode */
-const char typeinput = 'm';
+void propagator_init() {
+    catalog_init();
+    load_target(catalog_get(0));
+    sidereal_init(&knot_gmst, KNOT_INTERVAL_CYCLES);
+}
 
-/* 'a' for AFSPC, 'i' for "improved" */
-const char opsmode = 'i';
+/* Track another satellite from the catalog, starting over from a fresh knot queue.
+ * False if it isn't in there (yet). */
+bool propagator_select(uint32_t norad) {
+    const catalog_entry_t* e = catalog_find(norad);
+    if (e == NULL) return false;
 
-/* WGS72 or WGS84 mode. WGS84, since we're using this stuff with GPS data. */
-const gravconsttype whichconst = wgs84;
+    load_target(e);
+    setpoint_flush();
+    return true;
+}
 
-elsetrec current_sat;
+static float tsince_at(uint64_t t) {
+    return clock_tsince(&sat_epoch, t);
+}
 
-void propagator_init() {
+/* Propagate satrec to tsince (minutes from TLE epoch) and run the az/el stage on the result,
+ * given sin/cos of GMST at that time */
+static bool propagator_propagate(elsetrec *satrec, float tsince, float sin_g, float cos_g, pointing_t* out) {
 
-    uint32_t start = util_clock_us();
+    /* sgp4_wrapper takes time, in minutes, from satellite TLE epoch (stored in satrec as a jd float)*/
+    float r[3];
+    float v[3];
+    if (!sgp4_wrapper(whichconst, satrec, tsince, r, v)) return false;
 
-    float a, b, c;
-    twoline2rv_wrapper(TLE_LINE1, TLE_LINE2, typerun, typeinput, opsmode, whichconst, &a, &b, &c, &current_sat);
+    /* on to the az/el stage */
+    pointing_teme_to_azel(r, v, sin_g, cos_g, out);
+    return true;
+}
 
-    uint32_t init_end = util_clock_us();
+/* The planner samples arbitrary times, so GMST is evaluated directly */
+static bool plan_sample(void* ctx, float tsince, float* az, float* el) {
+    float d = sat_epoch.frac + tsince * (1.0f / 1440.0f);
+    float whole = floorf(d);
+    clock_time_t t;
+    t.day = sat_epoch.day + (int32_t) whole;
+    t.frac = d - whole;
+
+    float sin_g, cos_g;
+    sidereal_eval(&t, &sin_g, &cos_g);
+
+    pointing_t target;
+    if (!propagator_propagate((elsetrec*) ctx, tsince, sin_g, cos_g, &target)) return false;
+    *az = target.az;
+    *el = target.el;
+    return true;
+}
 
-    float r[3];
-    float v[3];
-    sgp4_wrapper(whichconst, &current_sat, 1.0, r, v);
+/* Run a propagated state through the keyhole plan. Inside and after the keyhole window the
+ * mount no longer follows the target directly, so the rates come from differencing the plan
+ * (with the target carried forward on its own rates) instead. */
+static void plan_knot(float tsince, const pointing_t* target, setpoint_knot_t* knot) {
+    knot->az = target->az;
+    knot->el = target->el;
+    knot->az_rate = target->az_rate;
+    knot->el_rate = target->el_rate;
 
-    uint32_t prop_end = util_clock_us();
+    if (!plan.valid || plan.mode == PASS_PLAN_NONE || tsince < plan.win_start) return;
 
-    uint32_t parse_time = init_end - start;
-    uint32_t prop_time = prop_end - init_end;
+    float dt = PLAN_RATE_DT * 60.0f;
+    float az2 = target->az + target->az_rate * dt;
+    float el2 = target->el + target->el_rate * dt;
 
-    return;
-}
+    pass_plan_apply(&plan, tsince, MOUNT_MAX_EL, &knot->az, &knot->el);
+    pass_plan_apply(&plan, tsince + PLAN_RATE_DT, MOUNT_MAX_EL, &az2, &el2);
 
-void propagator_propagate(elsetrec *satrec) {
+    float daz = az2 - knot->az;
+    if (daz > 3.14159265f) daz -= 2 * 3.14159265f;
+    if (daz < -3.14159265f) daz += 2 * 3.14159265f;
 
-    float jd_epoch = satrec->jdsatepoch;
+    knot->az_rate = daz / dt;
+    knot->el_rate = (el2 - knot->el) / dt;
+}
 
-    float jd_test = clock_set_utc(0,0,0,0,0,0,0);
+/* The target is below MOUNT_MIN_EL: park there, at the azimuth the planned pass rises at, or hold
+ * the azimuth until a pass is planned */
+static void park_knot(float tsince, setpoint_knot_t* knot) {
+    if (!planning && plan.valid && tsince < plan.aos && !park_ready) {
+        float el;
+        park_ready = plan_sample(&current_sat, plan.aos, &park_az, &el);
+    }
+
+    knot->az = (!planning && plan.valid && tsince < plan.aos && park_ready) ? park_az : last_az;
+    knot->el = MOUNT_MIN_EL;
+    knot->az_rate = 0.0f;
+    knot->el_rate = 0.0f;
+}
 
-    /* sgp4_wrapper takes time, in minutes, from satellite TLE epoch (stored in satrec as a jd float)*/
-    float r[3];
-    float v[3];
-    float tsince = 0;
-    sgp4_wrapper(whichconst, satrec, tsince, r, v);
+/* Work on the plan being made until it's done or the slice that started at start is used up */
+static void plan_work(uint64_t start) {
+    while (planning) {
+        if (pass_plan_step(&plan, plan_sample, &current_sat)) {
+            planning = false;
+        } else if (util_clock_cycles64() - start >= PLAN_BUDGET_CYCLES) {
+            break;
+        }
+    }
 }
 
-void propagator_test() {
-    propagator_propagate(&current_sat);
+/* Called from the main loop. Keeps the setpoint generator's knot queue topped up. */
+void propagator_update(void) {
+    uint64_t now = util_clock_cycles64();
+    uint64_t t;
+    uint32_t last;
+
+    /* after a cold boot the clock reads a placeholder until it's set, and the target's position
+     * then is nonsense: leave the queue empty, so the mount holds still, until there's a time */
+    if (!clock_is_set()) return;
+
+    /* newer elements for what we're tracking came in: carry on from them (the knots already
+     * queued are close enough to stand) */
+    const catalog_entry_t* e = catalog_find(target_norad);
+    if (e != NULL && e->revision != target_revision) load_target(e);
+
+    if (!setpoint_last_knot_time(&last) || (int32_t) (last - (uint32_t) now) < 0) {
+        /* empty, or we fell so far behind the whole queue is in the past: start over */
+        setpoint_flush();
+        t = now + KNOT_LEAD_CYCLES;
+    } else {
+        /* knots carry the low 32 bits of the counter, and are always within a few seconds of now */
+        t = now + (int32_t) (last - (uint32_t) now) + KNOT_INTERVAL_CYCLES;
+    }
+
+    plan_work(now);
+
+    while (setpoint_queue_space() > 0) {
+        float tsince = tsince_at(t);
+
+        /* done with that pass (or the search span came up empty), or the clock was set back:
+         * plan the next one */
+        if (tsince < plan_from || (!planning && (!plan_ready || tsince > plan.los))) {
+            pass_plan_start(tsince, PASS_SEARCH_MINUTES, MOUNT_MAX_AZ_RATE, MOUNT_MAX_EL);
+            plan.valid = false;
+            plan_ready = true;
+            planning = true;
+            plan_from = tsince;
+            park_ready = false;
+            plan_work(now);
+        }
+
+        /* this knot could be in the pass still being planned: it'll have to wait. Only holds the
+         * queue up if the target is already up (a fresh target or a clock change mid-pass). */
+        if (planning && tsince >= pass_plan_pending_from()) return;
+
+        sidereal_at(&knot_gmst, t);
+
+        pointing_t target;
+        if (!propagator_propagate(&current_sat, tsince, knot_gmst.sin_g, knot_gmst.cos_g, &target)) return;
+
+        setpoint_knot_t knot;
+        knot.t = (uint32_t) t;
+        if (target.el < MOUNT_MIN_EL) {
+            park_knot(tsince, &knot);
+        } else {
+            plan_knot(tsince, &target, &knot);
+        }
+        last_az = knot.az;
+        setpoint_push(&knot);
+
+        t += KNOT_INTERVAL_CYCLES;
+    }
 }
@@ -8,6 +8,11 @@
 #ifndef PROPAGATOR_H_
 #define PROPAGATOR_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
 void propagator_init(void);
+void propagator_update(void);
+bool propagator_select(uint32_t norad);
 
 #endif /* PROPAGATOR_H_ */
@@ -0,0 +1,130 @@
+/*
+ * protocol.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+/* Bluetooth message types, shared with the host tools and the phone (Protocol.java). Framing is
+ * in frame.h. All fields little-endian, floats IEEE single, sizes in bytes.
+ *
+ * Replies carry the request type with PROTO_REPLY set. Requests that only change state get no
+ * reply; a bad one (wrong length, rejected value, bad CRC) is just counted. So is anything that
+ * writes flash (Site Set, Horizon Table Commit / Reset, Pointing Model) while the mount is
+ * enabled or the laser armed, see storage.h.
+ *
+ * Time Sync Request (phone's send time, unix microseconds; see timesync.h)
+ *  -> u32 seq, i64 t1                                                      (12)
+ *  <- u32 seq, i64 t1, i64 t2, i64 t3                                      (28)
+ *
+ * Site Set (degrees, degrees east, meters above the WGS84 ellipsoid)
+ *  -> f32 lat, f32 lon, f32 alt                                            (12)
+ *
+ * Horizon Table Upload (table: 'M' = horizon mask, 'R' = refraction)
+ *  -> u8 table, u16 offset, u8 data[]                                      (3 + n)
+ *
+ * Horizon Table Commit (save the uploaded table to flash and start using it) / Reset (go back
+ * to the built-in table)
+ *  -> u8 table                                                             (1)
+ *
+ * Mount Gains (axis 'A' / 'E'; duty per rad, rad s, rad/s, rad/s of setpoint rate)
+ *  -> u8 axis, f32 kp, f32 ki, f32 kd, f32 kff                             (17)
+ *
+ * Mount Enable / Laser Arm (0 = off, 1 = on)
+ *  -> u8 enable                                                            (1)
+ *
+ * Pointing Model (PM_TERM_COUNT terms in arcseconds, in pointing_model.h order)
+ *  -> f32 terms[11]                                                        (44)
+ *
+ * Exclusion Zone (degrees; el_max <= el_min clears the zone, see interlock.h)
+ *  -> u8 zone, f32 az_min, f32 az_max, f32 el_min, f32 el_max              (17)
+ *
+ * Interlock Status
+ *  ->                                                                      (0)
+ *  <- u8 armed, u8 laser on, u32 reasons, u32 trips, u32 max latency ns,
+ *     u32 worst case cut time ns                                           (18)
+ *
+ * Time Sync Apply (step the clock by offset, microseconds), acknowledged with the drift estimate
+ * and how long until the next sync is due
+ *  -> i64 offset, u32 uncertainty                                          (12)
+ *  <- i64 offset, u32 uncertainty, i32 drift ppb, u32 next sync s          (20)
+ *
+ * Link Test (see linktest.h)
+ *  Send, answered with LINK_FILL replies carrying that much filler, then the total
+ *  -> u32 bytes                                                            (4)
+ *  <- u32 bytes, u32 baud                                                  (8)
+ *  Fill, only counted
+ *  -> filler                                                               (n)
+ *  Count of filler received since the last count
+ *  ->                                                                      (0)
+ *  <- u32 bytes, u32 us from the first starting to the last, u32 baud       (12)
+ *
+ * Packet Stats (for one request type: how many came in, how many were rejected, and the mean and
+ * worst time to handle one)
+ *  -> u8 type                                                              (1)
+ *  <- u8 type, u32 count, u32 errors, u32 mean ns, u32 max ns              (17)
+ *
+ * Catalog Upload (TLE text, streamed in windowed chunks; see catalog.h)
+ *  Begin. flags: 0x01 merge into the catalog rather than replace it, 0x02 the chunks carry delta
+ *  records rather than TLE text (always a merge). No flags byte is a plain replace. Answered with
+ *  the window (chunks in flight), the largest chunk and how many sets the catalog holds
+ *  -> u8 flags                                                             (0 / 1)
+ *  <- u8 window, u8 chunk max, u16 capacity                                (4)
+ *  Chunk, acknowledged every few chunks and on a gap or repeat. status: 0 = have everything
+ *  before next seq, 1 = upload finished, 2 = missing next seq, resend from there
+ *  -> u16 seq, u8 data[]                                                   (2 + n)
+ *  <- u16 next seq, u16 sets loaded, u16 sets skipped, u8 status           (7)
+ *  End, after chunks [0, chunks)
+ *  -> u16 chunks                                                           (2)
+ *  <- u16 next seq, u16 sets loaded, u16 sets skipped, u8 status           (7)
+ *
+ * Catalog Select (start tracking a satellite in the catalog)
+ *  -> u32 norad                                                            (4)
+ *
+ * Telemetry (see telemetry.h). Start the stream at up to max Hz, 0 stops it
+ *  -> u16 max Hz                                                           (2)
+ *  Frames follow as replies until it's stopped; v is a varint, z a zigzag varint. Fixed header
+ *  <- u16 seq, u8 flags, u8 samples, i64 t0 unix us                        (12 + n)
+ *  then timing: v rate Hz, v dropped samples, v setpoint underruns, v setpoint max jitter ns,
+ *     v setpoint max ISR ns, v stepper max jitter ns, v stepper max ISR ns, v interlock max
+ *     latency ns
+ *  then if flags & 0x01, status: v syncs, v since last sync s, v sync uncertainty us,
+ *     z clock drift ppb, v drift sigma ppb, v baud, v TX writes refused, v RX frames lost,
+ *     v RN42 power-up to ready us (0 until it's ready)
+ *  then the samples. Each is v us since the previous (not on the first), z az, z el, z az error,
+ *     z el error (urad), z az duty, z el duty (1e-4), v state ^ previous state. Fields after the
+ *     first sample are the change from the previous. state = armed | laser on << 1 |
+ *     mount enabled << 2 | interlock reasons << 3
+ */
+
+#define PROTO_REPLY             0x80
+
+#define PROTO_TIME_REQUEST      0x01
+#define PROTO_SITE              0x02
+#define PROTO_TABLE_UPLOAD      0x03
+#define PROTO_TABLE_COMMIT      0x04
+#define PROTO_TABLE_RESET       0x05
+#define PROTO_GAINS             0x06
+#define PROTO_MOUNT_ENABLE      0x07
+#define PROTO_POINTING_MODEL    0x08
+#define PROTO_ZONE              0x09
+#define PROTO_LASER_ARM         0x0A
+#define PROTO_INTERLOCK_STATUS  0x0B
+#define PROTO_TIME_APPLY        0x0C
+#define PROTO_LINK_SEND         0x0D
+#define PROTO_LINK_FILL         0x0E
+#define PROTO_LINK_COUNT        0x0F
+#define PROTO_PACKET_STATS      0x10
+#define PROTO_CATALOG_BEGIN     0x11
+#define PROTO_CATALOG_CHUNK     0x12
+#define PROTO_CATALOG_END       0x13
+#define PROTO_CATALOG_SELECT    0x14
+#define PROTO_TELEMETRY         0x15
+
+/* One past the highest request type */
+#define PROTO_TYPE_COUNT        0x16
+
+#endif /* PROTOCOL_H_ */
@@ -0,0 +1,156 @@
+/*
+ * ring.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef RING_H_
+#define RING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Single producer, single consumer byte ring. Header only.
+ *
+ * One side writes (say the main loop) and the other reads (an ISR, or a DMA channel through one),
+ * with no locks: head is only ever written by the producer and tail by the consumer. Both count
+ * up forever and are masked on use, so the size has to be a power of two, all of it is usable,
+ * and head - tail is always the fill level, even across the 2^32 wrap.
+ *
+ * Data is moved in contiguous spans: ring_write() / ring_read() copy in at most two memcpys, and
+ * ring_write_span() / ring_read_span() hand out the run up to the end of the buffer in place,
+ * for a DMA transfer or a parser, to be committed with ring_commit() / ring_consume().
+ *
+ * RING_BARRIER() sits between touching the data and publishing the index that hands it over, and
+ * between reading the other side's index and touching the data behind it. On the M4 that's a
+ * dmb, which also keeps the uDMA controller from seeing the index before the data. Built on a
+ * host (see host/), it's a full fence, so the same code runs between two threads.
+ *
+ * The producer keeps the high water mark, and counts writes that didn't fit (which write
+ * nothing) in overflows.
+ */
+
+#if defined(__TI_ARM__) || defined(__TI_COMPILER_VERSION__)
+#define RING_BARRIER() __asm(" dmb")
+#elif defined(__GNUC__)
+#define RING_BARRIER() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#error "RING_BARRIER() needs defining for this compiler"
+#endif
+
+typedef struct {
+    uint8_t* buf;
+    uint32_t mask;              /* size - 1 */
+    volatile uint32_t head;     /* producer only */
+    volatile uint32_t tail;     /* consumer only */
+    uint32_t high_water;        /* producer only */
+    uint32_t overflows;         /* producer only */
+} ring_t;
+
+/* size must be a power of two. Returns false if it isn't. */
+static inline bool ring_init(ring_t* r, uint8_t* buf, uint32_t size) {
+    if (size == 0 || (size & (size - 1)) != 0) return false;
+    r->buf = buf;
+    r->mask = size - 1;
+    r->head = 0;
+    r->tail = 0;
+    r->high_water = 0;
+    r->overflows = 0;
+    return true;
+}
+
+static inline uint32_t ring_size(const ring_t* r) {
+    return r->mask + 1;
+}
+
+/* Either side. From the producer it's a lower bound, from the consumer an upper one. */
+static inline uint32_t ring_used(const ring_t* r) {
+    return r->head - r->tail;
+}
+
+static inline uint32_t ring_free(const ring_t* r) {
+    return ring_size(r) - ring_used(r);
+}
+
+/* Producer: publish n bytes already put in place (through ring_write_span()) */
+static inline void ring_commit(ring_t* r, uint32_t n) {
+    RING_BARRIER();
+    uint32_t head = r->head + n;
+    r->head = head;
+
+    uint32_t used = head - r->tail;
+    if (used > r->high_water) r->high_water = used;
+}
+
+/* Producer: contiguous free space at the head, up to the end of the buffer */
+static inline uint32_t ring_write_span(ring_t* r, uint8_t** span) {
+    uint32_t head = r->head;
+    uint32_t free = ring_size(r) - (head - r->tail);
+    uint32_t at = head & r->mask;
+    uint32_t run = ring_size(r) - at;
+
+    RING_BARRIER();
+    *span = &r->buf[at];
+    return run < free ? run : free;
+}
+
+/* Producer: all len bytes, or nothing (counted as an overflow) */
+static inline bool ring_write(ring_t* r, const void* data, uint32_t len) {
+    const uint8_t* src = (const uint8_t*) data;
+    uint32_t head = r->head;
+
+    if (len > ring_size(r) - (head - r->tail)) {
+        r->overflows++;
+        return false;
+    }
+    RING_BARRIER();
+
+    uint32_t at = head & r->mask;
+    uint32_t first = ring_size(r) - at;
+    if (first > len) first = len;
+
+    memcpy(&r->buf[at], src, first);
+    memcpy(r->buf, src + first, len - first);
+    ring_commit(r, len);
+    return true;
+}
+
+/* Consumer: contiguous data at the tail, up to the end of the buffer */
+static inline uint32_t ring_read_span(ring_t* r, const uint8_t** span) {
+    uint32_t tail = r->tail;
+    uint32_t used = r->head - tail;
+    uint32_t at = tail & r->mask;
+    uint32_t run = ring_size(r) - at;
+
+    RING_BARRIER();
+    *span = &r->buf[at];
+    return run < used ? run : used;
+}
+
+/* Consumer: hand n bytes back to the producer */
+static inline void ring_consume(ring_t* r, uint32_t n) {
+    RING_BARRIER();
+    r->tail += n;
+}
+
+/* Consumer: up to max bytes. Returns how many. */
+static inline uint32_t ring_read(ring_t* r, void* out, uint32_t max) {
+    uint8_t* dst = (uint8_t*) out;
+    const uint8_t* span;
+    uint32_t n = 0;
+
+    /* at most two spans: up to the end of the buffer, then from the start */
+    for (uint32_t i = 0; i < 2 && n < max; i++) {
+        uint32_t run = ring_read_span(r, &span);
+        if (run == 0) break;
+        if (run > max - n) run = max - n;
+        memcpy(&dst[n], span, run);
+        ring_consume(r, run);
+        n += run;
+    }
+    return n;
+}
+
+#endif /* RING_H_ */
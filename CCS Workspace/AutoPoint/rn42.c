@@ -0,0 +1,281 @@
+/*
+ * rn42.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "util.h"
+#include "bluetooth.h"
+#include "bluetooth_uart.h"
+
+#include "rn42.h"
+
+/* Settings we want in the module: G<key> reads one back, S<key>,<value> writes it */
+typedef struct {
+    char key;
+    const char* value;
+} rn42_setting_t;
+
+static const rn42_setting_t settings[] = {
+    { 'P', "69420" },                               /* security PIN */
+    { 'Y', "0010" },                                /* full power */
+    { '~', "0" },                                   /* serial port profile */
+    { 'N', "laser" },                               /* name */
+    { 'E', "0000110100001000800000805F9B34FB" },    /* SPP UUID, for android */
+};
+
+#define SETTING_COUNT (sizeof(settings) / sizeof(settings[0]))
+
+#define MS_CYCLES(ms) ((uint64_t) (ms) * (UTIL_CLOCK_HZ / 1000))
+
+static rn42_state_t state;
+static uint32_t setting;        /* being read or written */
+static uint32_t stale;          /* bitmask of settings that need writing */
+static bool written;            /* settings written (and module rebooted) this bring-up */
+static bool fallback;           /* the fast baud didn't work, stay at the boot baud */
+static uint32_t tries;          /* sends of the current command */
+static uint32_t attempts;       /* bring-ups since the last rest */
+static uint64_t deadline;       /* for whatever the current state is waiting on */
+static uint64_t boot_deadline;
+static uint64_t start_cycles;
+static uint32_t boot_us;
+
+static void enter(rn42_state_t next, uint64_t wait_cycles) {
+    state = next;
+    tries = 0;
+    deadline = util_clock_cycles64() + wait_cycles;
+}
+
+/* Send the command for the current state (again), and restart its response timeout */
+static void send_command(void) {
+    char buf[48];
+    const rn42_setting_t* s = &settings[setting];
+
+    switch (state) {
+    case RN42_STATE_QUERY:
+        snprintf(buf, sizeof(buf), "G%c\r\n", s->key);
+        break;
+    case RN42_STATE_CONFIGURE:
+        snprintf(buf, sizeof(buf), "S%c,%s\r\n", s->key, s->value);
+        break;
+    case RN42_STATE_BAUD:
+        /* N: no parity. Takes effect straight away and drops out of command mode. */
+        snprintf(buf, sizeof(buf), "U,%luK,N\r\n", (unsigned long) (BLUETOOTH_BAUD_FAST / 1000));
+        break;
+    case RN42_STATE_LEAVE:
+        strcpy(buf, "---\r\n");
+        break;
+    default:
+        return;
+    }
+
+    tries++;
+    deadline = util_clock_cycles64() + MS_CYCLES(state == RN42_STATE_BAUD ? RN42_BAUD_MS : RN42_TIMEOUT_MS);
+    bluetooth_send(buf);
+}
+
+/* Reset the module, which brings it back up at the boot baud. It's held in reset first, and
+ * whatever was queued for it dropped: a wedged module can hold CTS, and won't want it anyway. */
+static void reset(void) {
+    bluetooth_uart_pin_reset(true);
+    bluetooth_uart_tx_discard();
+    bluetooth_set_baud(BLUETOOTH_BAUD_BOOT);
+    enter(RN42_STATE_RESET, MS_CYCLES(RN42_RESET_MS));
+}
+
+static void restart(void) {
+    if (++attempts >= RN42_MAX_ATTEMPTS) {
+        attempts = 0;
+        written = false;
+        fallback = false;
+        enter(RN42_STATE_REST, MS_CYCLES(RN42_REST_MS));
+        return;
+    }
+
+    reset();
+}
+
+/* Out of command mode at whatever baud we ended up on */
+static void leave(void) {
+    enter(RN42_STATE_LEAVE, 0);
+    send_command();
+}
+
+static void ready(void) {
+    boot_us = (uint32_t) ((util_clock_cycles64() - start_cycles) / (UTIL_CLOCK_HZ / 1000000));
+    attempts = 0;
+    state = RN42_STATE_READY;
+}
+
+/* Move on to the next stale setting, or on from configuring if there are none left. Writes only
+ * take effect after a reboot, after which everything is read back again. Settings still stale
+ * after that (one that reads back differently than it's written, say) are left alone. */
+static void next_stale(void) {
+    while (!written && setting < SETTING_COUNT && !(stale & (1u << setting))) setting++;
+
+    if (!written && setting < SETTING_COUNT) {
+        enter(RN42_STATE_CONFIGURE, 0);
+        send_command();
+    } else if (!written && stale) {
+        written = true;
+        bluetooth_uart_pin_reset(true);
+        enter(RN42_STATE_REBOOT, MS_CYCLES(RN42_RESET_MS));
+    } else if (!fallback) {
+        enter(RN42_STATE_BAUD, 0);
+        send_command();
+    } else {
+        leave();
+    }
+}
+
+/* Begin bring-up. Called once from bluetooth_init(), after the pins are set up. */
+void rn42_start(void) {
+    start_cycles = util_clock_cycles64();
+    attempts = 0;
+    written = false;
+    fallback = false;
+
+    /* hold the module at a known baud, and reset it */
+    bluetooth_uart_pin_force_baud(true);
+    bluetooth_uart_pin_reset(true);
+    enter(RN42_STATE_RESET, MS_CYCLES(RN42_RESET_MS));
+}
+
+/* Whether the line ends in word. A phone that connects while we're still in command mode gets its
+ * frames glued onto the front of whatever line comes next, so status words only have to end it. */
+static bool ends_with(const char* line, uint32_t len, const char* word) {
+    uint32_t n = strlen(word);
+    return len >= n && strncmp(&line[len - n], word, n) == 0;
+}
+
+/* One line from the module, with the line ending still on */
+void rn42_line(const char* line, uint32_t len) {
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) len--;
+
+    switch (state) {
+    case RN42_STATE_BOOT:
+        if (ends_with(line, len, "CMD")) {
+            setting = 0;
+            stale = 0;
+            enter(RN42_STATE_QUERY, 0);
+            send_command();
+        }
+        break;
+
+    case RN42_STATE_QUERY:
+        if (strlen(settings[setting].value) != len || strncmp(line, settings[setting].value, len) != 0) {
+            stale |= 1u << setting;
+        }
+        if (++setting < SETTING_COUNT) {
+            tries = 0;
+            send_command();
+        } else {
+            setting = 0;
+            next_stale();
+        }
+        break;
+
+    case RN42_STATE_CONFIGURE:
+        if (ends_with(line, len, "AOK")) {
+            setting++;
+            next_stale();
+        }
+        break;
+
+    case RN42_STATE_VERIFY:
+        if (ends_with(line, len, "CMD")) leave();
+        break;
+
+    case RN42_STATE_LEAVE:
+        if (ends_with(line, len, "END")) ready();
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Called from the main loop. Responses are handled first (rn42_line(), via
+ * bluetooth_handle_packets()), so a slow pass through the loop never reads as a timeout. */
+void rn42_update(void) {
+    uint64_t now = util_clock_cycles64();
+    if (state == RN42_STATE_READY || now < deadline) return;
+
+    switch (state) {
+    case RN42_STATE_RESET:
+        bluetooth_uart_pin_reset(false);
+        state = RN42_STATE_BOOT;
+        boot_deadline = now + MS_CYCLES(RN42_BOOT_MS);
+        deadline = now;
+        break;
+
+    case RN42_STATE_BAUD:
+        /* whatever it said back, it said it at the old baud */
+        bluetooth_set_baud(BLUETOOTH_BAUD_FAST);
+        state = RN42_STATE_VERIFY;
+        boot_deadline = now + MS_CYCLES(RN42_VERIFY_MS);
+        deadline = now;
+        break;
+
+    case RN42_STATE_VERIFY:
+        if (now >= boot_deadline) {
+            fallback = true;
+            reset();
+            break;
+        }
+        /* fall through */
+    case RN42_STATE_BOOT:
+        if (now >= boot_deadline) {
+            restart();
+        } else {
+            /* no line ending: the module wants "$$$" on its own */
+            bluetooth_send("$$$");
+            deadline = now + MS_CYCLES(RN42_CMD_RETRY_MS);
+        }
+        break;
+
+    case RN42_STATE_QUERY:
+    case RN42_STATE_CONFIGURE:
+    case RN42_STATE_LEAVE:
+        if (tries >= RN42_RETRIES) {
+            restart();
+        } else {
+            send_command();
+        }
+        break;
+
+    case RN42_STATE_REBOOT:
+        /* and back round to read the new settings back */
+        bluetooth_uart_pin_reset(false);
+        state = RN42_STATE_BOOT;
+        boot_deadline = now + MS_CYCLES(RN42_BOOT_MS);
+        deadline = now;
+        break;
+
+    case RN42_STATE_REST:
+        reset();
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool rn42_is_ready(void) {
+    return state == RN42_STATE_READY;
+}
+
+rn42_state_t rn42_get_state(void) {
+    return state;
+}
+
+/* Microseconds from rn42_start() to ready, 0 if not there yet */
+uint32_t rn42_boot_us(void) {
+    return state == RN42_STATE_READY ? boot_us : 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * rn42.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef RN42_H_
+#define RN42_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* RN42 bluetooth module bring-up.
+ *
+ * A state machine polled from the main loop (through bluetooth_handle_packets()), so it runs
+ * alongside the rest of init instead of blocking it for seconds:
+ *
+ *  reset -> "$$$" until the module answers CMD -> read back each setting -> write the ones
+ *  that differ and reboot (once) if there were any -> switch to BLUETOOTH_BAUD_FAST ->
+ *  "$$$" again at the new baud to check it took -> leave command mode
+ *
+ * The baud switch uses the module's temporary "U" command, so its stored baud (and the 9.6K_BAUD
+ * strap) keep it coming up at BLUETOOTH_BAUD_BOOT after any reset. If the check at the new baud
+ * fails, the module is reset and the link stays at BLUETOOTH_BAUD_BOOT.
+ *
+ * Every command has a response timeout and a few retries. Anything that can't be recovered by
+ * retrying starts over from reset, and after RN42_MAX_ATTEMPTS of those it rests for a while
+ * before trying again. Until it's ready, lines from the module come here instead of the packet
+ * handler.
+ */
+
+#define RN42_RESET_MS       5       /* ~RESET low time */
+#define RN42_CMD_RETRY_MS   250     /* "$$$" resend interval while the module boots */
+#define RN42_BOOT_MS        3000    /* give up on CMD after this and reset again */
+#define RN42_BAUD_MS        100     /* for the module to switch baud after "U" */
+#define RN42_VERIFY_MS      1000    /* give up on CMD at the new baud after this */
+#define RN42_TIMEOUT_MS     500     /* per command response */
+#define RN42_RETRIES        3       /* per command, before starting over */
+#define RN42_MAX_ATTEMPTS   3       /* full bring-ups before resting */
+#define RN42_REST_MS        10000
+
+typedef enum {
+    RN42_STATE_RESET = 0,
+    RN42_STATE_BOOT,
+    RN42_STATE_QUERY,
+    RN42_STATE_CONFIGURE,
+    RN42_STATE_REBOOT,
+    RN42_STATE_BAUD,
+    RN42_STATE_VERIFY,
+    RN42_STATE_LEAVE,
+    RN42_STATE_REST,
+    RN42_STATE_READY
+} rn42_state_t;
+
+void rn42_start(void);
+void rn42_update(void);
+void rn42_line(const char* line, uint32_t len);
+
+bool rn42_is_ready(void);
+rn42_state_t rn42_get_state(void);
+uint32_t rn42_boot_us(void);
+
+#endif /* RN42_H_ */
@@ -0,0 +1,222 @@
+/*
+ * setpoint.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hal.h"
+#include "util.h"
+#include "setpoint.h"
+#include "trace.h"
+
+#define PI 3.14159265f
+#define TWO_PI (2.0f * PI)
+
+#define QUEUE_MASK (SETPOINT_QUEUE_SIZE - 1)
+
+#define TICK_CYCLES (UTIL_CLOCK_HZ / SETPOINT_RATE_HZ)
+
+/* The setpoint/control tick must preempt the bluetooth UART ISR. Only step generation
+ * (stepper.c) is allowed to preempt it. */
+#define SETPOINT_INT_PRIORITY 0x20
+
+/* Knot queue. Main loop writes at head, ISR consumes at tail. The main loop side is all
+ * trace_lock()ed, so a replay sees the tick land the same side of every access. */
+static setpoint_knot_t knots[SETPOINT_QUEUE_SIZE];
+static volatile uint32_t knot_head = 0;
+static volatile uint32_t knot_tail = 0;
+
+static volatile bool flush_pending = false;
+static volatile uint32_t flush_to = 0;
+
+/* Latest setpoint, guarded by a sequence count so the main loop can read it without masking the ISR.
+ * Both volatile, so the compiler keeps the copy between the two reads of the count. A single core
+ * needs no more than that: the ISR runs to completion in between main loop instructions. */
+static volatile setpoint_t current;
+static volatile uint32_t current_seq = 0;
+
+static setpoint_stats_t stats;
+static uint32_t last_entry = 0;
+
+static setpoint_consumer_t consumer = 0;
+
+static float wrap_2pi(float a) {
+    if (a >= TWO_PI) a -= TWO_PI;
+    if (a < 0.0f) a += TWO_PI;
+    return a;
+}
+
+/* Shortest signed difference b - a between two azimuths */
+static float az_diff(float a, float b) {
+    float d = b - a;
+    if (d > PI) d -= TWO_PI;
+    if (d < -PI) d += TWO_PI;
+    return d;
+}
+
+/* Cubic hermite between k0 and k1 at normalized time s (0..1), knot spacing h seconds.
+ * p1 is given relative to p0 so azimuth can be interpolated across north. */
+static void hermite(float p0, float m0, float p1, float m1, float h, float s, float* p, float* rate) {
+    float s2 = s * s;
+    float s3 = s2 * s;
+
+    float h00 = 2 * s3 - 3 * s2 + 1;
+    float h10 = s3 - 2 * s2 + s;
+    float h01 = -2 * s3 + 3 * s2;
+    float h11 = s3 - s2;
+
+    *p = h00 * p0 + h10 * h * m0 + h01 * p1 + h11 * h * m1;
+    *rate = (6 * s2 - 6 * s) / h * (p0 - p1) + (3 * s2 - 4 * s + 1) * m0 + (3 * s2 - 2 * s) * m1;
+}
+
+static void setpoint_compute(uint32_t now, setpoint_t* sp) {
+    uint32_t tail = knot_tail;
+    uint32_t head = knot_head;
+
+    /* Advance so knots[tail] is the last knot at or before now */
+    while (head - tail >= 2 && (int32_t) (now - knots[(tail + 1) & QUEUE_MASK].t) >= 0) {
+        tail++;
+    }
+    knot_tail = tail;
+
+    sp->t = now;
+
+    if (head == tail) {
+        /* nothing to track */
+        sp->valid = false;
+        sp->stale = true;
+        return;
+    }
+
+    const setpoint_knot_t* k0 = &knots[tail & QUEUE_MASK];
+    float dt = (int32_t) (now - k0->t) * (1.0f / UTIL_CLOCK_HZ);
+
+    sp->valid = true;
+
+    if (head - tail >= 2 && dt >= 0.0f) {
+        const setpoint_knot_t* k1 = &knots[(tail + 1) & QUEUE_MASK];
+        float h = (int32_t) (k1->t - k0->t) * (1.0f / UTIL_CLOCK_HZ);
+        float s = dt / h;
+        float daz;
+
+        hermite(0.0f, k0->az_rate, az_diff(k0->az, k1->az), k1->az_rate, h, s, &daz, &sp->az_rate);
+        hermite(k0->el, k0->el_rate, k1->el, k1->el_rate, h, s, &sp->el, &sp->el_rate);
+        sp->az = wrap_2pi(k0->az + daz);
+        sp->stale = false;
+    } else {
+        /* Before the first knot (holding for the pass to start) or past the last one (main loop fell
+         * behind). Either way, extrapolate along the knot's rates. */
+        sp->az = wrap_2pi(k0->az + k0->az_rate * dt);
+        sp->el = k0->el + k0->el_rate * dt;
+        sp->az_rate = k0->az_rate;
+        sp->el_rate = k0->el_rate;
+        sp->stale = dt > 0.0f;
+        if (sp->stale) stats.underruns++;
+    }
+}
+
+static void setpoint_isr(void) {
+    trace_isr(HAL_TIMER_SETPOINT);
+
+    uint32_t entry = util_clock_cycles();
+    hal_timer_ack(HAL_TIMER_SETPOINT);
+
+    /* tick-to-tick jitter */
+    if (stats.ticks > 0) {
+        int32_t err = (int32_t) (entry - last_entry) - TICK_CYCLES;
+        uint32_t jitter = err < 0 ? -err : err;
+        if (jitter > stats.max_jitter_cycles) stats.max_jitter_cycles = jitter;
+    }
+    last_entry = entry;
+    stats.ticks++;
+
+    if (flush_pending) {
+        knot_tail = flush_to;
+        flush_pending = false;
+    }
+
+    setpoint_t sp;
+    setpoint_compute(entry, &sp);
+
+    current_seq++;
+    current = sp;
+    current_seq++;
+
+    if (consumer) consumer(&sp);
+
+    uint32_t elapsed = util_clock_cycles() - entry;
+    if (elapsed > stats.max_isr_cycles) stats.max_isr_cycles = elapsed;
+}
+
+/* Start the fixed rate setpoint tick. */
+void setpoint_init(void) {
+    hal_timer_init(HAL_TIMER_SETPOINT, setpoint_isr, SETPOINT_INT_PRIORITY);
+    hal_timer_set_period(HAL_TIMER_SETPOINT, TICK_CYCLES);
+    hal_timer_start(HAL_TIMER_SETPOINT);
+}
+
+/* Register the function called with each new setpoint. Runs in ISR context, keep it short. */
+void setpoint_set_consumer(setpoint_consumer_t fn) {
+    consumer = fn;
+}
+
+/* Queue a propagated state. Knots must be pushed in time order. Returns false if the queue is full. */
+bool setpoint_push(const setpoint_knot_t* knot) {
+    bool irq = trace_lock();
+    uint32_t head = knot_head;
+    bool room = head - knot_tail < SETPOINT_QUEUE_SIZE;
+
+    if (room) {
+        knots[head & QUEUE_MASK] = *knot;
+        knot_head = head + 1;
+    }
+    trace_unlock(irq);
+    return room;
+}
+
+uint32_t setpoint_queue_space(void) {
+    bool irq = trace_lock();
+    uint32_t space = SETPOINT_QUEUE_SIZE - (knot_head - knot_tail);
+    trace_unlock(irq);
+    return space;
+}
+
+/* Timestamp of the most recently pushed knot, so the main loop knows where to propagate next.
+ * Returns false if the queue is empty. */
+bool setpoint_last_knot_time(uint32_t* t) {
+    bool irq = trace_lock();
+    uint32_t head = knot_head;
+    bool any = head != knot_tail;
+
+    if (any) *t = knots[(head - 1) & QUEUE_MASK].t;
+    trace_unlock(irq);
+    return any;
+}
+
+/* Drop all queued knots, e.g. when switching targets. Takes effect on the next tick. */
+void setpoint_flush(void) {
+    bool irq = trace_lock();
+    flush_to = knot_head;
+    flush_pending = true;
+    trace_unlock(irq);
+}
+
+void setpoint_get(setpoint_t* out) {
+    bool irq = trace_lock();
+    uint32_t seq;
+    do {
+        seq = current_seq;
+        *out = current;
+    } while ((seq & 1) || seq != current_seq);
+    trace_unlock(irq);
+}
+
+void setpoint_get_stats(setpoint_stats_t* out) {
+    bool irq = trace_lock();
+    *out = stats;
+    trace_unlock(irq);
+}
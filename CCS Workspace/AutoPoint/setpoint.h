@@ -0,0 +1,62 @@
+/*
+ * setpoint.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef SETPOINT_H_
+#define SETPOINT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* High-rate pointing setpoint generator.
+ *
+ * The main loop propagates the satellite a little way into the future and pushes the resulting
+ * az/el states ("knots") into a short queue. A timer ISR running at SETPOINT_RATE_HZ interpolates
+ * between knots (cubic hermite, using the az/el rates) and hands each setpoint to the consumer,
+ * i.e. the mount controller. No SGP4 work ever happens in the ISR.
+ */
+
+#define SETPOINT_RATE_HZ        1000
+#define SETPOINT_QUEUE_SIZE     8       /* power of two */
+
+/* Propagated state at one instant, produced by the main loop */
+typedef struct {
+    uint32_t t;         /* util_clock_cycles() timestamp the state is valid at */
+    float az, el;       /* radians */
+    float az_rate;      /* rad/s */
+    float el_rate;      /* rad/s */
+} setpoint_knot_t;
+
+/* Interpolated target, produced by the ISR */
+typedef struct {
+    uint32_t t;
+    float az, el;
+    float az_rate, el_rate;
+    bool valid;         /* false until the queue has been primed */
+    bool stale;         /* ran off the end of the queue, extrapolating from the last knot */
+} setpoint_t;
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t underruns;
+    uint32_t max_jitter_cycles;     /* worst ISR entry lateness vs the ideal tick */
+    uint32_t max_isr_cycles;        /* worst time spent in the ISR, consumer included */
+} setpoint_stats_t;
+
+typedef void (*setpoint_consumer_t)(const setpoint_t* sp);
+
+void setpoint_init(void);
+void setpoint_set_consumer(setpoint_consumer_t consumer);
+
+bool setpoint_push(const setpoint_knot_t* knot);
+uint32_t setpoint_queue_space(void);
+bool setpoint_last_knot_time(uint32_t* t);
+void setpoint_flush(void);
+
+void setpoint_get(setpoint_t* out);
+void setpoint_get_stats(setpoint_stats_t* out);
+
+#endif /* SETPOINT_H_ */
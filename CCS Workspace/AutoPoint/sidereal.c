@@ -0,0 +1,84 @@
+/*
+ * sidereal.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util.h"
+#include "clock.h"
+
+#include "sidereal.h"
+
+#define PI 3.14159265f
+
+/* GMST in turns = GMST_J2000 + GMST_RATE * (days since 2000-01-01 12:00 UT1), plus a small T^2
+ * term. From gstime(): 67310.54841 s at J2000 and (876600 h + 8640184.812866 s) per century. */
+#define GMST_J2000_Q64      0xc7704c26611c4ad1ull   /* turns, 2^-64 units */
+#define GMST_RATE_FRAC_Q64  0x00b36e7f1eff03acull   /* GMST_RATE - 1, turns/day, 2^-64 units */
+#define GMST_RATE           1.00273790935f          /* turns/day */
+#define GMST_T2_TURNS       (0.093104f / 86400.0f)  /* turns/century^2 */
+
+/* GMST at t as a fraction of a turn, 2^-64 units */
+static uint64_t gmst_q64(const clock_time_t* t) {
+    /* whole days: the integer part of the rate contributes whole turns, so only the fractional
+     * part matters, and the multiply wrapping mod 2^64 is exactly mod one turn */
+    uint64_t turns = GMST_J2000_Q64 + (uint64_t) (int64_t) t->day * GMST_RATE_FRAC_Q64;
+
+    /* day 0 starts half a day before J2000 */
+    float frac = t->frac - 0.5f;
+    float cent = ((float) t->day + frac) * (1.0f / 36525.0f);
+    float part = frac * GMST_RATE + GMST_T2_TURNS * cent * cent;
+
+    return turns + ((uint64_t) (int64_t) (part * 4294967296.0f) << 32);
+}
+
+/* sin/cos of GMST at t, evaluated directly */
+void sidereal_eval(const clock_time_t* t, float* sin_g, float* cos_g) {
+    /* top 32 bits are ~0.3 mas, more than a float angle can hold anyway */
+    float gmst = (float) (uint32_t) (gmst_q64(t) >> 32) * (2 * PI / 4294967296.0f);
+    *sin_g = sinf(gmst);
+    *cos_g = cosf(gmst);
+}
+
+void sidereal_init(sidereal_t* s, uint32_t step_cycles) {
+    float angle = 2 * PI * GMST_RATE / TCONV_SEC_PER_DAY * ((float) step_cycles / UTIL_CLOCK_HZ);
+
+    s->step = step_cycles;
+    s->sin_step = sinf(angle);
+    s->cos_step = cosf(angle);
+    s->valid = false;
+}
+
+static void anchor(sidereal_t* s, uint64_t cycles) {
+    clock_time_t t;
+    clock_at(cycles, &t);
+    sidereal_eval(&t, &s->sin_g, &s->cos_g);
+
+    s->t = cycles;
+    s->steps = 0;
+    s->clock_gen = clock_generation();
+    s->valid = true;
+}
+
+/* Move the tracker to 'cycles'. One step past the last call is a rotation; anything else
+ * (first call, a jump, the clock being set) re-anchors. */
+void sidereal_at(sidereal_t* s, uint64_t cycles) {
+    if (!s->valid || cycles != s->t + s->step
+        || s->steps >= SIDEREAL_REANCHOR_STEPS || s->clock_gen != clock_generation()) {
+        anchor(s, cycles);
+        return;
+    }
+
+    float sin_g = s->sin_g * s->cos_step + s->cos_g * s->sin_step;
+    float cos_g = s->cos_g * s->cos_step - s->sin_g * s->sin_step;
+
+    s->sin_g = sin_g;
+    s->cos_g = cos_g;
+    s->t = cycles;
+    s->steps++;
+}
@@ -0,0 +1,49 @@
+/*
+ * sidereal.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef SIDEREAL_H_
+#define SIDEREAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clock.h"
+
+/* Greenwich mean sidereal time, for the TEME -> ECEF rotation.
+ *
+ * gstime() takes a float JD, which only resolves ~0.25 day at current dates, and evaluates a
+ * cubic plus an fmodf on it. Instead GMST (IAU 1982, as SGP4 uses) is evaluated from a
+ * clock_time_t as a fixed point fraction of a turn: the whole days go through a 64-bit integer
+ * multiply that wraps mod one turn for free, and only the fraction of the day is float.
+ *
+ * For a regular series of times (the propagator's knots), a sidereal_t tracker does that
+ * once as an anchor and then steps sin/cos of GMST forward by a fixed rotation (four multiplies
+ * per step), re-anchoring every SIDEREAL_REANCHOR_STEPS steps or whenever the clock is set.
+ *
+ * UT1 - UTC (under 0.9 s) is ignored.
+ */
+
+/* Steps between exact evaluations. Rounding in the recurrence stays well under an arcsecond. */
+#define SIDEREAL_REANCHOR_STEPS 120
+
+typedef struct {
+    float sin_g, cos_g;         /* sin/cos of GMST at t */
+
+    uint64_t t;                 /* cycle count of the current value */
+    uint32_t step;              /* cycles per step */
+    float sin_step, cos_step;   /* rotation per step */
+    uint32_t steps;             /* since the last anchor */
+    uint32_t clock_gen;         /* clock_generation() at the last anchor */
+    bool valid;
+} sidereal_t;
+
+void sidereal_eval(const clock_time_t* t, float* sin_g, float* cos_g);
+
+void sidereal_init(sidereal_t* s, uint32_t step_cycles);
+void sidereal_at(sidereal_t* s, uint64_t cycles);
+
+#endif /* SIDEREAL_H_ */
@@ -0,0 +1,229 @@
+/*
+ * stepper.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hal.h"
+#include "util.h"
+#include "setpoint.h"
+#include "stepper_profile.h"
+#include "stepper.h"
+#include "trace.h"
+
+#define PI 3.14159265f
+#define TWO_PI (2.0f * PI)
+
+/* Step ISRs preempt everything, including the setpoint tick */
+#define STEPPER_INT_PRIORITY 0x00
+
+/* Shortest half period (STEP high or low time) we'll program */
+#define MIN_HALF_PERIOD (UTIL_CLOCK_HZ / (2 * STEPPER_MAX_STEP_HZ))
+
+/* Below this many steps/s just stop the axis rather than program huge intervals */
+#define MIN_STEP_HZ 0.5f
+
+typedef struct {
+    hal_timer_t timer;
+    hal_pin_t step_pin;
+    hal_pin_t dir_pin;
+    float rad_per_step;
+
+    stepper_profile_t profile;
+
+    volatile int32_t pos;           /* steps, counted on each rising STEP edge */
+    volatile int32_t dir;           /* +1 / -1 */
+    volatile bool running;
+    volatile bool step_high;
+    volatile uint32_t half_period;  /* currently programmed, cycles */
+    uint32_t last_entry;
+    uint32_t last_half_period;
+} stepper_axis_t;
+
+static stepper_axis_t az_axis = {
+    .timer = HAL_TIMER_AZ_STEP,
+    .step_pin = HAL_PIN_AZ_STEP,
+    .dir_pin = HAL_PIN_AZ_DIR,
+    .rad_per_step = TWO_PI / STEPPER_AZ_STEPS_PER_REV,
+    .dir = 1,
+};
+
+static stepper_axis_t el_axis = {
+    .timer = HAL_TIMER_EL_STEP,
+    .step_pin = HAL_PIN_EL_STEP,
+    .dir_pin = HAL_PIN_EL_DIR,
+    .rad_per_step = TWO_PI / STEPPER_EL_STEPS_PER_REV,
+    .dir = 1,
+};
+
+/* Motion limits, need tuning for the real motors */
+static const stepper_profile_t default_profile = {
+    .max_rate = 0.8f,
+    .max_accel = 2.0f,
+    .max_jerk = 20.0f,
+    .tau = 0.05f,
+};
+
+static stepper_stats_t stats;
+
+/* Shared by both step ISRs. The STEP pin write is one store (no read-modify-write) to keep the
+ * ISR as short as possible. */
+static void step_isr(stepper_axis_t* axis) {
+    trace_isr(axis->timer);
+
+    uint32_t entry = util_clock_cycles();
+    hal_timer_ack(axis->timer);
+
+    /* timing jitter: deviation of this edge from the interval we programmed for it
+     * (skipped across rate changes, where the interval legitimately differs) */
+    if (axis->last_half_period == axis->half_period) {
+        int32_t err = (int32_t) (entry - axis->last_entry) - (int32_t) axis->last_half_period;
+        uint32_t jitter = err < 0 ? -err : err;
+        if (jitter > stats.max_jitter_cycles) stats.max_jitter_cycles = jitter;
+    }
+    axis->last_entry = entry;
+    axis->last_half_period = axis->half_period;
+
+    if (axis->step_high) {
+        hal_pin_write(axis->step_pin, false);
+        axis->step_high = false;
+    } else {
+        hal_pin_write(axis->step_pin, true);
+        axis->step_high = true;
+        axis->pos += axis->dir;
+        stats.steps++;
+    }
+
+    uint32_t elapsed = util_clock_cycles() - entry;
+    if (elapsed > stats.max_isr_cycles) {
+        stats.max_isr_cycles = elapsed;
+        /* both axes could need servicing back to back on every half step */
+        stats.step_hz_ceiling = UTIL_CLOCK_HZ / (4 * elapsed);
+    }
+}
+
+static void az_step_isr(void) {
+    step_isr(&az_axis);
+}
+
+static void el_step_isr(void) {
+    step_isr(&el_axis);
+}
+
+/* Program an axis for a new rate (rad/s) */
+static void axis_set_rate(stepper_axis_t* axis, float rate) {
+    float step_hz = rate / axis->rad_per_step;
+    int32_t dir = step_hz < 0 ? -1 : 1;
+    if (step_hz < 0) step_hz = -step_hz;
+
+    if (step_hz < MIN_STEP_HZ) {
+        if (axis->running) {
+            hal_timer_stop(axis->timer);
+            axis->running = false;
+        }
+        return;
+    }
+
+    uint32_t half_period = (uint32_t) (UTIL_CLOCK_HZ / (2.0f * step_hz));
+    if (half_period < MIN_HALF_PERIOD) half_period = MIN_HALF_PERIOD;
+
+    if (dir != axis->dir) {
+        /* direction only changes while STEP is low, and the driver gets at least a half
+         * period of setup time before the next rising edge */
+        hal_timer_mask(axis->timer, true);
+        if (axis->step_high) {
+            hal_pin_write(axis->step_pin, false);
+            axis->step_high = false;
+        }
+        hal_pin_write(axis->dir_pin, dir > 0);
+        axis->dir = dir;
+        hal_timer_mask(axis->timer, false);
+    }
+
+    axis->half_period = half_period;
+
+    /* while running this takes effect at the next timeout, so the edge in flight isn't cut short */
+    hal_timer_set_period(axis->timer, half_period);
+
+    if (!axis->running) {
+        axis->last_half_period = half_period;
+        axis->last_entry = util_clock_cycles();
+        axis->running = true;
+        hal_timer_start(axis->timer);
+    }
+}
+
+static void axis_init(stepper_axis_t* axis, hal_isr_t isr) {
+    axis->profile = default_profile;
+
+    hal_pin_output(axis->step_pin, false);
+    hal_pin_output(axis->dir_pin, true);
+
+    hal_timer_init(axis->timer, isr, STEPPER_INT_PRIORITY);
+}
+
+void stepper_init(void) {
+    axis_init(&az_axis, az_step_isr);
+    axis_init(&el_axis, el_step_isr);
+}
+
+/* Shortest signed angle */
+static float wrap_pi(float d) {
+    while (d > PI) d -= TWO_PI;
+    while (d < -PI) d += TWO_PI;
+    return d;
+}
+
+/* First half of the setpoint tick: the commanded position and the remaining error of each axis
+ * (radians), so the interlock can look at them before any steps are programmed. */
+void stepper_error(const setpoint_t* sp, bool enabled, float* az, float* el, float* az_err, float* el_err) {
+    *az = az_axis.pos * az_axis.rad_per_step;
+    *el = el_axis.pos * el_axis.rad_per_step;
+    *az_err = 0.0f;
+    *el_err = 0.0f;
+
+    if (enabled && sp->valid) {
+        *az_err = wrap_pi(sp->az - *az);
+        *el_err = sp->el - *el;
+    }
+}
+
+/* Second half: motion profile step on those errors */
+void stepper_tick(const setpoint_t* sp, bool enabled, float az_err, float el_err) {
+    const float dt = 1.0f / SETPOINT_RATE_HZ;
+
+    if (!enabled || !sp->valid) {
+        stepper_profile_reset(&az_axis.profile);
+        stepper_profile_reset(&el_axis.profile);
+        axis_set_rate(&az_axis, 0.0f);
+        axis_set_rate(&el_axis, 0.0f);
+        return;
+    }
+
+    axis_set_rate(&az_axis, stepper_profile_update(&az_axis.profile, az_err, sp->az_rate, dt));
+    axis_set_rate(&el_axis, stepper_profile_update(&el_axis.profile, el_err, sp->el_rate, dt));
+}
+
+/* Tell the steppers where the mount is pointing (radians). With interrupts off, so a step in
+ * between can't be lost. */
+void stepper_sync(float az, float el) {
+    int32_t az_pos = (int32_t) (az / az_axis.rad_per_step);
+    int32_t el_pos = (int32_t) (el / el_axis.rad_per_step);
+
+    bool irq = hal_irq_disable();
+    bool sync = trace_lock();
+    az_axis.pos = az_pos;
+    el_axis.pos = el_pos;
+    trace_unlock(sync);
+    hal_irq_restore(irq);
+}
+
+void stepper_get_stats(stepper_stats_t* out) {
+    bool irq = trace_lock();
+    *out = stats;
+    trace_unlock(irq);
+}
@@ -0,0 +1,46 @@
+/*
+ * stepper.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef STEPPER_H_
+#define STEPPER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "setpoint.h"
+
+/* Step/direction drive for a stepper motor mount (build with MOUNT_USE_STEPPERS).
+ *
+ * Azimuth:   STEP PD2, DIR PD3, step timing on TIMER2A
+ * Elevation: STEP PE1, DIR PE2, step timing on TIMER3A
+ *
+ * The setpoint tick runs the motion profile (stepper_profile.h) and reprograms each axis timer
+ * with the new step interval. The timer ISRs only toggle the STEP pin and count steps, so step
+ * timing doesn't depend on anything else the CPU is doing.
+ */
+
+/* Microsteps per output shaft revolution (after gearing) */
+#define STEPPER_AZ_STEPS_PER_REV 160000
+#define STEPPER_EL_STEPS_PER_REV 160000
+
+/* Fastest step rate we'll ever program, steps/s. Keep below the measured ceiling (see stats). */
+#define STEPPER_MAX_STEP_HZ 100000
+
+typedef struct {
+    uint32_t steps;                 /* total steps issued, both axes */
+    uint32_t max_jitter_cycles;     /* worst step edge deviation from the programmed interval */
+    uint32_t max_isr_cycles;        /* worst time in a step ISR */
+    uint32_t step_hz_ceiling;       /* fastest step rate the ISR could sustain on both axes at once */
+} stepper_stats_t;
+
+void stepper_init(void);
+void stepper_error(const setpoint_t* sp, bool enabled, float* az, float* el, float* az_err, float* el_err);
+void stepper_tick(const setpoint_t* sp, bool enabled, float az_err, float el_err);
+void stepper_sync(float az, float el);
+void stepper_get_stats(stepper_stats_t* out);
+
+#endif /* STEPPER_H_ */
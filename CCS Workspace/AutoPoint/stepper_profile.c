@@ -0,0 +1,76 @@
+/*
+ * stepper_profile.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <math.h>
+
+#include "stepper_profile.h"
+
+static float clamp(float x, float limit) {
+    if (x > limit) return limit;
+    if (x < -limit) return -limit;
+    return x;
+}
+
+void stepper_profile_reset(stepper_profile_t* p) {
+    p->rate = 0.0f;
+    p->accel = 0.0f;
+}
+
+/* One profile step.
+ *
+ * err: setpoint - commanded position, radians
+ * sp_rate: setpoint rate, rad/s
+ * dt: seconds since the last step
+ *
+ * Returns the new commanded rate, rad/s.
+ */
+float stepper_profile_update(stepper_profile_t* p, float err, float sp_rate, float dt) {
+    /* Rate we'd like to be at: follow the setpoint, plus close the error. Far from the target
+     * that's the fastest rate we can still brake from in time, close in it tapers off linearly
+     * so we don't chatter around zero error.
+     *
+     * Braking distance from rate v is v^2 / 2a, plus v a / 2j while the deceleration ramps in
+     * on an S-curve. Solve that for v. */
+    float abs_err = fabsf(err);
+    float closing = abs_err / p->tau;
+    float braking;
+
+    if (p->max_jerk <= 0.0f) {
+        braking = sqrtf(2.0f * p->max_accel * abs_err);
+    } else {
+        float b = p->max_accel * p->max_accel / p->max_jerk;
+        braking = 0.5f * (sqrtf(b * b + 8.0f * p->max_accel * abs_err) - b);
+    }
+    float correction = closing < braking ? closing : braking;
+
+    float target = clamp(sp_rate + (err > 0 ? correction : -correction), p->max_rate);
+    float dv = target - p->rate;
+
+    if (p->max_jerk <= 0.0f) {
+        /* trapezoidal: bang-bang acceleration */
+        p->rate += clamp(dv, p->max_accel * dt);
+        p->accel = 0.0f;
+    } else {
+        /* S-curve: pick the acceleration that lets us ramp it back to zero right as we reach the
+         * target rate, then slew toward it at the jerk limit */
+        float accel_target = sqrtf(2.0f * p->max_jerk * fabsf(dv));
+        accel_target = clamp(dv > 0 ? accel_target : -accel_target, p->max_accel);
+
+        p->accel += clamp(accel_target - p->accel, p->max_jerk * dt);
+
+        float step = p->accel * dt;
+        if (fabsf(step) > fabsf(dv) && (step > 0) == (dv > 0)) {
+            /* would overshoot the target rate this tick, land on it */
+            step = dv;
+            p->accel = 0.0f;
+        }
+        p->rate += step;
+    }
+
+    p->rate = clamp(p->rate, p->max_rate);
+    return p->rate;
+}
@@ -0,0 +1,34 @@
+/*
+ * stepper_profile.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef STEPPER_PROFILE_H_
+#define STEPPER_PROFILE_H_
+
+/* Velocity profile follower for an open-loop (stepper) axis.
+ *
+ * Each control tick takes the remaining position error and the setpoint rate and produces the
+ * commanded axis rate, respecting rate, acceleration and (optionally) jerk limits:
+ *  max_jerk == 0: trapezoidal profile, acceleration steps between +/- max_accel
+ *  max_jerk > 0:  S-curve profile, acceleration itself ramps at max_jerk
+ *
+ * Pure math, no hardware, so it runs on a PC as-is.
+ */
+
+typedef struct {
+    float max_rate;     /* rad/s */
+    float max_accel;    /* rad/s^2 */
+    float max_jerk;     /* rad/s^3, 0 for trapezoidal */
+    float tau;          /* s, time constant for closing small errors */
+
+    float rate;         /* commanded rate, rad/s */
+    float accel;        /* commanded acceleration, rad/s^2 (S-curve only) */
+} stepper_profile_t;
+
+void stepper_profile_reset(stepper_profile_t* p);
+float stepper_profile_update(stepper_profile_t* p, float err, float sp_rate, float dt);
+
+#endif /* STEPPER_PROFILE_H_ */
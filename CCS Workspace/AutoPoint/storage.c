@@ -0,0 +1,110 @@
+/*
+ * storage.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "driverlib/sw_crc.h"
+
+#include "hal.h"
+#include "mount.h"
+#include "interlock.h"
+#include "storage.h"
+
+#define STORAGE_MAGIC 0x41505354 /* "APST" */
+
+/* Record layout at the start of each slot. Payload follows immediately after. */
+typedef struct {
+    uint32_t magic;
+    uint32_t len;
+    uint32_t crc;
+    uint32_t reserved;
+} storage_header_t;
+
+static uint32_t slot_address(storage_slot_t slot) {
+    return STORAGE_BASE + (uint32_t)slot * STORAGE_SLOT_SIZE;
+}
+
+/* Returns a pointer to the payload of the record in the given slot, straight out of flash,
+ * or NULL if the slot doesn't hold a valid record of exactly len bytes.
+ *
+ * Flash is memory mapped, so callers can use the returned table in place without copying it to RAM.
+ */
+const void* storage_get(storage_slot_t slot, uint32_t len) {
+    if (slot >= STORAGE_SLOT_COUNT) return NULL;
+
+    const storage_header_t* hdr = (const storage_header_t*) hal_flash_map(slot_address(slot));
+    const uint8_t* payload = (const uint8_t*) (hdr + 1);
+
+    if (hdr->magic != STORAGE_MAGIC) return NULL;
+    if (hdr->len != len) return NULL;
+    if (Crc32(0xFFFFFFFF, payload, len) != hdr->crc) return NULL;
+
+    return payload;
+}
+
+/* Whether flash can be written now: not while the mount could be moving or the laser could fire,
+ * since neither the control tick nor the interlock runs until the write is done */
+bool storage_writable(void) {
+    mount_status_t m;
+    interlock_status_t il;
+
+    mount_get_status(&m);
+    interlock_get_status(&il);
+    return !m.enabled && !il.armed;
+}
+
+/* Erase the slot and write a new record into it. Blocks for the erase + program time (~ms).
+ * Returns false if the payload doesn't fit, flash isn't writable now (storage_writable()) or the
+ * flash controller reports an error.
+ */
+bool storage_save(storage_slot_t slot, const void* data, uint32_t len) {
+    if (slot >= STORAGE_SLOT_COUNT) return false;
+    if (!storage_writable()) return false;
+    if (len > STORAGE_MAX_PAYLOAD) return false;
+
+    uint32_t addr = slot_address(slot);
+
+    if (!hal_flash_erase(addr)) return false;
+
+    storage_header_t hdr;
+    hdr.magic = STORAGE_MAGIC;
+    hdr.len = len;
+    hdr.crc = Crc32(0xFFFFFFFF, (const uint8_t*) data, len);
+    hdr.reserved = 0;
+
+    /* Programming wants word-aligned sources in multiples of 4 bytes, so bounce the
+     * payload through a small aligned buffer. */
+    uint32_t words[16];
+    const uint8_t* src = (const uint8_t*) data;
+    uint32_t dst = addr + sizeof(hdr);
+    uint32_t remaining = len;
+
+    while (remaining > 0) {
+        uint32_t chunk = remaining < sizeof(words) ? remaining : sizeof(words);
+        memset(words, 0xFF, sizeof(words));
+        memcpy(words, src, chunk);
+
+        if (!hal_flash_program(words, dst, (chunk + 3) & ~3u)) return false;
+
+        src += chunk;
+        dst += chunk;
+        remaining -= chunk;
+    }
+
+    /* Header goes last, so a reset halfway through leaves the slot invalid rather than corrupt */
+    if (!hal_flash_program((const uint32_t*) &hdr, addr, sizeof(hdr))) return false;
+
+    return storage_get(slot, len) != NULL;
+}
+
+bool storage_erase(storage_slot_t slot) {
+    if (slot >= STORAGE_SLOT_COUNT) return false;
+    if (!storage_writable()) return false;
+    return hal_flash_erase(slot_address(slot));
+}
@@ -0,0 +1,44 @@
+/*
+ * storage.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef STORAGE_H_
+#define STORAGE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Persistent parameter storage in the top of on-chip flash.
+ *
+ * The linker command file keeps the last STORAGE_SLOT_COUNT KB of flash free for us.
+ * Each slot is one 1 KB erase block holding a single record (header + payload), so
+ * saving one table never disturbs another.
+ *
+ * Erasing and programming stall instruction fetch from flash for milliseconds, interrupts and
+ * all, so the control tick and the interlock stop with them. Writes are refused while the mount
+ * is enabled or the laser armed (storage_writable()).
+ */
+
+#define STORAGE_BASE        0x0003E000
+#define STORAGE_SLOT_SIZE   1024
+#define STORAGE_SLOT_COUNT  8
+
+typedef enum {
+    STORAGE_SLOT_SITE = 0,
+    STORAGE_SLOT_HORIZON_MASK,
+    STORAGE_SLOT_REFRACTION,
+    STORAGE_SLOT_POINTING_MODEL
+} storage_slot_t;
+
+/* Largest payload that fits in a slot after the record header */
+#define STORAGE_MAX_PAYLOAD (STORAGE_SLOT_SIZE - 16)
+
+const void* storage_get(storage_slot_t slot, uint32_t len);
+bool storage_writable(void);
+bool storage_save(storage_slot_t slot, const void* data, uint32_t len);
+bool storage_erase(storage_slot_t slot);
+
+#endif /* STORAGE_H_ */
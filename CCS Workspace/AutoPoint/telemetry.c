@@ -0,0 +1,231 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util.h"
+#include "clock.h"
+#include "mount.h"
+#include "stepper.h"
+#include "setpoint.h"
+#include "interlock.h"
+#include "timesync.h"
+#include "rn42.h"
+#include "bluetooth.h"
+#include "frame.h"
+#include "protocol.h"
+
+#include "telemetry.h"
+
+#define FLAG_STATUS     0x01
+
+/* az, el, az_err, el_err, az_duty, el_duty */
+#define FIELD_COUNT     6
+
+/* dt, the fields and the state word, 5 bytes each at worst */
+#define SAMPLE_MAX      ((FIELD_COUNT + 2) * 5)
+
+#define CYCLES_PER_US   (UTIL_CLOCK_HZ / 1000000)
+
+/* 0 when off */
+static uint32_t max_hz = 0;
+static uint32_t rate_hz = 0;
+static uint64_t next_sample = 0;
+
+/* Frame being filled */
+static uint8_t frame[FRAME_MAX_PAYLOAD];
+static uint32_t frame_len = 0;
+static uint32_t frame_samples = 0;
+static uint64_t frame_start = 0;
+static uint16_t seq = 0;
+
+/* Previous sample in the frame, the deltas are against it */
+static int32_t prev[FIELD_COUNT];
+static uint32_t prev_state = 0;
+static uint64_t prev_cycles = 0;
+
+static uint32_t dropped = 0;
+static uint64_t last_status = 0;
+
+static uint8_t* put_varint(uint8_t* p, uint32_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t) (v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t) v;
+    return p;
+}
+
+static uint8_t* put_zigzag(uint8_t* p, int32_t v) {
+    return put_varint(p, ((uint32_t) v << 1) ^ (uint32_t) (v >> 31));
+}
+
+static int32_t quantise(float x, float scale) {
+    float v = x * scale;
+    return (int32_t) (v < 0.0f ? v - 0.5f : v + 0.5f);
+}
+
+/* Start the 'max_hz' stream (clamped to TELEMETRY_MAX_HZ), or stop it with 0. The rate starts at
+ * the top and comes down if the link can't take it. */
+bool telemetry_configure(uint32_t hz) {
+    if (hz > TELEMETRY_MAX_HZ) hz = TELEMETRY_MAX_HZ;
+
+    max_hz = hz;
+    rate_hz = hz;
+    frame_samples = 0;
+    next_sample = util_clock_cycles64();
+    last_status = next_sample - (uint64_t) TELEMETRY_STATUS_MS * (UTIL_CLOCK_HZ / 1000);
+    return true;
+}
+
+/* Fixed header (the flags and sample count are filled in when it's sent), timing stats, then the
+ * status block if one is due */
+static void frame_begin(uint64_t now) {
+    setpoint_stats_t sp;
+    stepper_stats_t st;
+    interlock_status_t il;
+    uint8_t* p = frame;
+    uint8_t flags = 0;
+
+    setpoint_get_stats(&sp);
+    stepper_get_stats(&st);
+    interlock_get_status(&il);
+
+    le_put_u16(&p[0], seq);
+    le_put_i64(&p[4], clock_unix_us(now));
+    p += 12;
+
+    p = put_varint(p, rate_hz);
+    p = put_varint(p, dropped);
+    p = put_varint(p, sp.underruns);
+    p = put_varint(p, util_cycles_ns(sp.max_jitter_cycles));
+    p = put_varint(p, util_cycles_ns(sp.max_isr_cycles));
+    p = put_varint(p, util_cycles_ns(st.max_jitter_cycles));
+    p = put_varint(p, util_cycles_ns(st.max_isr_cycles));
+    p = put_varint(p, util_cycles_ns(il.max_latency_cycles));
+
+    if (now - last_status >= (uint64_t) TELEMETRY_STATUS_MS * (UTIL_CLOCK_HZ / 1000)) {
+        timesync_status_t ts;
+        bluetooth_stats_t bs;
+        float ppm, sigma;
+
+        timesync_get_status(&ts);
+        bluetooth_get_stats(&bs);
+        clock_get_drift(&ppm, &sigma);
+
+        uint32_t age = ts.syncs ? (uint32_t) ((now - ts.last_sync_cycles) / UTIL_CLOCK_HZ) : 0;
+
+        p = put_varint(p, ts.syncs);
+        p = put_varint(p, age);
+        p = put_varint(p, ts.uncertainty_us);
+        p = put_zigzag(p, quantise(ppm, 1000.0f));
+        p = put_varint(p, (uint32_t) quantise(sigma, 1000.0f));
+        p = put_varint(p, bluetooth_get_baud());
+        p = put_varint(p, bs.tx_overflows);
+        p = put_varint(p, bs.rx_overruns + bs.rx_dropped);
+        p = put_varint(p, rn42_boot_us());
+
+        flags |= FLAG_STATUS;
+        last_status = now;
+    }
+
+    frame[2] = flags;
+    frame_len = (uint32_t) (p - frame);
+    frame_start = now;
+
+    for (uint32_t i = 0; i < FIELD_COUNT; i++) prev[i] = 0;
+    prev_state = 0;
+    prev_cycles = now;
+}
+
+static void sample(uint64_t now) {
+    mount_status_t ms;
+    interlock_status_t il;
+    int32_t q[FIELD_COUNT];
+
+    mount_get_status(&ms);
+    interlock_get_status(&il);
+
+    if (frame_samples == 0) frame_begin(now);
+
+    q[0] = quantise(ms.az, TELEMETRY_ANGLE_SCALE);
+    q[1] = quantise(ms.el, TELEMETRY_ANGLE_SCALE);
+    q[2] = quantise(ms.az_err, TELEMETRY_ANGLE_SCALE);
+    q[3] = quantise(ms.el_err, TELEMETRY_ANGLE_SCALE);
+    q[4] = quantise(ms.az_duty, TELEMETRY_DUTY_SCALE);
+    q[5] = quantise(ms.el_duty, TELEMETRY_DUTY_SCALE);
+
+    uint32_t state = (uint32_t) il.armed | (uint32_t) il.laser_on << 1 | (uint32_t) ms.enabled << 2
+                     | il.reasons << 3;
+
+    uint8_t* p = &frame[frame_len];
+
+    /* the first sample is at the frame time */
+    if (frame_samples > 0) p = put_varint(p, (uint32_t) ((now - prev_cycles) / CYCLES_PER_US));
+
+    for (uint32_t i = 0; i < FIELD_COUNT; i++) {
+        p = put_zigzag(p, (int32_t) ((uint32_t) q[i] - (uint32_t) prev[i]));
+        prev[i] = q[i];
+    }
+
+    /* changed bits, usually none */
+    p = put_varint(p, state ^ prev_state);
+    prev_state = state;
+    prev_cycles = now;
+
+    frame_len = (uint32_t) (p - frame);
+    frame_samples++;
+}
+
+/* Send the open frame and adjust the rate to how that went */
+static void flush(void) {
+    frame[3] = (uint8_t) frame_samples;
+
+    bool sent = bluetooth_tx_pending() < TELEMETRY_TX_BUSY
+                && bluetooth_send_frame(PROTO_TELEMETRY | PROTO_REPLY, frame, frame_len);
+
+    if (sent) {
+        /* what a sample costs on the wire, header and framing included, against our share of
+         * the link (10 bits a byte) */
+        uint32_t per_sample = (frame_encoded_len(frame_len) + frame_samples - 1) / frame_samples;
+        uint32_t ceiling = bluetooth_get_baud() / 10 / TELEMETRY_LINK_SHARE / per_sample;
+
+        rate_hz += TELEMETRY_STEP_HZ;
+        if (rate_hz > ceiling) rate_hz = ceiling;
+        if (rate_hz > max_hz) rate_hz = max_hz;
+    } else {
+        dropped += frame_samples;
+        rate_hz /= 2;
+    }
+    if (rate_hz < TELEMETRY_MIN_HZ) rate_hz = TELEMETRY_MIN_HZ;
+
+    /* a gap in seq on the phone is a dropped frame */
+    seq++;
+    frame_samples = 0;
+}
+
+/* Called from the main loop. Takes a sample when one is due and sends the frame when it's full
+ * or old enough. */
+void telemetry_update(void) {
+    if (max_hz == 0 || !rn42_is_ready()) return;
+
+    uint64_t now = util_clock_cycles64();
+
+    if (frame_samples > 0 && now - frame_start >= (uint64_t) TELEMETRY_BATCH_MS * (UTIL_CLOCK_HZ / 1000)) {
+        flush();
+    }
+
+    if (now < next_sample) return;
+
+    /* a stall (flash erase, blocking baud change) skips samples rather than bunching them up */
+    uint64_t period = UTIL_CLOCK_HZ / rate_hz;
+    next_sample = now - next_sample < period ? next_sample + period : now + period;
+
+    sample(now);
+    if (frame_len + SAMPLE_MAX > FRAME_MAX_PAYLOAD) flush();
+}
@@ -0,0 +1,44 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Tracking telemetry, streamed to the phone once it asks for it (PROTO_TELEMETRY).
+ *
+ * The main loop samples the mount (encoder position, tracking error, drive duty) and the laser
+ * interlock state. Samples are quantised to integers and packed into the open frame as they're
+ * taken: the first sample of a frame as is, the rest as zigzag varint deltas from the one before,
+ * so a steady track costs a byte or two per field. A frame goes out when it's full or its oldest
+ * sample is TELEMETRY_BATCH_MS old. Every frame leads with the worst case timing stats, and
+ * about once every TELEMETRY_STATUS_MS with a clock / link status block as well.
+ *
+ * The sample rate adapts to the link: it creeps up by TELEMETRY_STEP_HZ per frame sent, up to
+ * what fits in 1/TELEMETRY_LINK_SHARE of the baud at the measured bytes per sample, and halves
+ * whenever a frame has to be dropped because the TX buffer is busy with something else (a
+ * catalog upload, a link test). Dropped samples are counted in the stream. Layout in protocol.h.
+ */
+
+#define TELEMETRY_MAX_HZ        200
+#define TELEMETRY_MIN_HZ        1
+#define TELEMETRY_STEP_HZ       2
+#define TELEMETRY_BATCH_MS      100
+#define TELEMETRY_STATUS_MS     1000
+#define TELEMETRY_LINK_SHARE    2
+#define TELEMETRY_TX_BUSY       256     /* bytes already queued that hold a frame back */
+
+/* Quantisation of the sample fields */
+#define TELEMETRY_ANGLE_SCALE   1e6f    /* microradians */
+#define TELEMETRY_DUTY_SCALE    1e4f
+
+bool telemetry_configure(uint32_t max_hz);
+void telemetry_update(void);
+
+#endif /* TELEMETRY_H_ */
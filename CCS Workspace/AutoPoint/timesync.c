@@ -0,0 +1,71 @@
+/*
+ * timesync.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "util.h"
+#include "clock.h"
+#include "bluetooth.h"
+#include "frame.h"
+#include "protocol.h"
+#include "timesync.h"
+
+static timesync_status_t status;
+
+/* Answer a sync request. rx_cycles is when its last byte arrived, rx_len its length on the wire.
+ *
+ * Reply: seq, t1, t2, t3 (see protocol.h). It's fixed length, so we know when it'll be done
+ * sending before filling in t3. */
+bool timesync_request(uint32_t seq, int64_t t1, uint64_t rx_cycles, uint32_t rx_len) {
+    uint8_t buf[28];
+
+    if (rx_cycles == 0) return false;
+
+    /* the phone stamped t1 before the request went over the air, so backdate t2 from the last
+     * byte to the first */
+    int64_t t2 = clock_unix_us(rx_cycles - (uint64_t) rx_len * bluetooth_char_cycles());
+
+    /* and the phone stamps t4 when it has the whole reply, after whatever's queued ahead of it */
+    uint32_t len = frame_encoded_len(sizeof(buf));
+    uint64_t done = util_clock_cycles64() + (uint64_t) (bluetooth_tx_pending() + len) * bluetooth_char_cycles();
+    int64_t t3 = clock_unix_us(done);
+
+    le_put_u32(&buf[0], seq);
+    le_put_i64(&buf[4], t1);
+    le_put_i64(&buf[12], t2);
+    le_put_i64(&buf[20], t3);
+
+    return bluetooth_send_frame(PROTO_TIME_REQUEST | PROTO_REPLY, buf, sizeof(buf));
+}
+
+/* Step the clock by the offset the phone settled on (which also refines the drift estimate), and
+ * acknowledge it with the current drift and when the phone should sync again:
+ * offset, uncertainty, drift ppb, next sync s */
+bool timesync_apply(int64_t offset_us, uint32_t uncertainty_us) {
+    uint8_t buf[20];
+    float drift, sigma;
+
+    clock_discipline(offset_us, uncertainty_us);
+    clock_get_drift(&drift, &sigma);
+
+    status.syncs++;
+    status.last_offset_us = offset_us;
+    status.uncertainty_us = uncertainty_us;
+    status.last_sync_cycles = util_clock_cycles64();
+
+    le_put_i64(&buf[0], offset_us);
+    le_put_u32(&buf[8], uncertainty_us);
+    le_put_u32(&buf[12], (uint32_t) (int32_t) (drift * 1000.0f));
+    le_put_u32(&buf[16], clock_next_sync_s());
+
+    return bluetooth_send_frame(PROTO_TIME_APPLY | PROTO_REPLY, buf, sizeof(buf));
+}
+
+void timesync_get_status(timesync_status_t* out) {
+    *out = status;
+}
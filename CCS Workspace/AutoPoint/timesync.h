@@ -0,0 +1,47 @@
+/*
+ * timesync.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef TIMESYNC_H_
+#define TIMESYNC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Bluetooth time sync, NTP style.
+ *
+ * The phone sends a request stamped with its send time t1. We answer with t2 (when the request
+ * started arriving) and t3 (when our answer will have finished going out), both in unix
+ * microseconds on our clock. The phone stamps t4 on receipt, giving for each exchange
+ *
+ *  offset = ((t1 - t2) + (t4 - t3)) / 2
+ *  delay  = (t4 - t1) - (t3 - t2)
+ *
+ * offset is how far our clock is behind the phone's, so it's what gets added to ours (the
+ * opposite sign to NTP's, which is the server's clock relative to the client's). It runs a burst
+ * of exchanges, keeps the one with the smallest delay (the RN42's buffering adds tens of ms of
+ * one-sided latency to most of them), and sends back that offset with delay / 2 as the
+ * uncertainty, which we step the clock by.
+ *
+ * Each applied offset also feeds the clock's drift estimate (clock_discipline()), and the
+ * acknowledgement tells the phone how long it can leave it before the next sync.
+ *
+ * t2 / t3 are corrected for UART serialization time at the link baud, so that what's left of the
+ * path delay is the radio link, which is roughly symmetric.
+ */
+
+typedef struct {
+    uint32_t syncs;             /* offsets applied since power up */
+    int64_t last_offset_us;     /* last step applied */
+    uint32_t uncertainty_us;    /* +- on the last sync */
+    uint64_t last_sync_cycles;  /* util_clock_cycles64() of the last sync */
+} timesync_status_t;
+
+bool timesync_request(uint32_t seq, int64_t t1, uint64_t rx_cycles, uint32_t rx_len);
+bool timesync_apply(int64_t offset_us, uint32_t uncertainty_us);
+void timesync_get_status(timesync_status_t* out);
+
+#endif /* TIMESYNC_H_ */
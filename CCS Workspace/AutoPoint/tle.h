@@ -0,0 +1,51 @@
+/*
+ * tle.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef TLE_H_
+#define TLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "clock.h"
+#include "sgp4_wrapper.h"
+
+/* Two line element sets, held as the integers the TLE actually carries.
+ *
+ * Every field is kept in the TLE's own fixed point units, so a set can be stored, compared and
+ * have deltas applied to it exactly, and the phone and the laser always agree on what a set is.
+ * Floats only appear when a set goes through sgp4init.
+ */
+
+#define TLE_LINE_LEN        69
+
+/* Angles, 1e-4 degree, wrap at this */
+#define TLE_DEG_FULL        3600000
+
+typedef struct {
+    uint32_t norad;
+    int32_t epoch_day;      /* days since 2000-01-01 (timeconv.h) */
+    uint32_t epoch_frac;    /* 1e-8 day */
+    int32_t ndot;           /* first derivative of mean motion / 2, 1e-8 rev/day^2 */
+    int32_t nddot_m;        /* second derivative / 6, mantissa 1e-5 rev/day^3 ... */
+    int32_t nddot_e;        /* ... times 10^nddot_e */
+    int32_t bstar_m;        /* drag term, mantissa 1e-5 per earth radius ... */
+    int32_t bstar_e;        /* ... times 10^bstar_e */
+    uint32_t inclo;         /* 1e-4 degree */
+    uint32_t nodeo;         /* 1e-4 degree */
+    uint32_t ecco;          /* 1e-7 */
+    uint32_t argpo;         /* 1e-4 degree */
+    uint32_t mo;            /* 1e-4 degree */
+    uint32_t no;            /* 1e-8 rev/day */
+} tle_elements_t;
+
+bool tle_parse(const char* line1, const char* line2, tle_elements_t* out);
+bool tle_valid(const tle_elements_t* el);
+bool tle_init_satrec(const tle_elements_t* el, gravconsttype whichconst, char opsmode, elsetrec* satrec);
+void tle_epoch(const tle_elements_t* el, clock_time_t* out);
+
+#endif /* TLE_H_ */
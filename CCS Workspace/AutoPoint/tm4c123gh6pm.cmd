@@ -10,7 +10,9 @@
 
 MEMORY
 {
-    FLASH (RX) : origin = 0x00000000, length = 0x00040000
+    FLASH (RX) : origin = 0x00000000, length = 0x0003E000
+    /* Last 8 KB reserved for persistent parameter storage, see storage.h */
+    STORAGE (R) : origin = 0x0003E000, length = 0x00002000
     SRAM (RWX) : origin = 0x20000000, length = 0x00008000
 }
 
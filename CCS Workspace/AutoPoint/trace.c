@@ -0,0 +1,298 @@
+/*
+ * trace.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "hal.h"
+#include "trace.h"
+
+#ifdef TRACE_ENABLE
+
+/* Tag byte, and the value's other 60 bits as a varint, and a second varint */
+#define MAX_RECORD 20
+
+trace_buffer_t trace;
+
+static bool recording = false;
+static bool held = false;
+
+static const trace_replay_t* replay = 0;
+static const uint8_t* replay_data;
+static uint32_t replay_len;
+static uint32_t replay_at;
+
+/* Recording and replay keep the same running state to take deltas against */
+static uint32_t records = 0;
+static uint64_t last_time = 0;
+static uint32_t last_rx = 0;
+static uint32_t last_stamp = 0;
+static int32_t last_count[HAL_AXIS_COUNT];
+
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+static uint8_t* put_varint(uint8_t* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t) (v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t) v;
+    return p;
+}
+
+static uint8_t* put_tag(uint8_t* p, trace_kind_t kind, uint64_t v) {
+    uint8_t tag = (uint8_t) (kind | (v & 0xF) << 3);
+    v >>= 4;
+    if (v == 0) {
+        *p++ = tag;
+        return p;
+    }
+    *p++ = tag | 0x80;
+    return put_varint(p, v);
+}
+
+/* Append the record in rec[0..end), then extra bytes from absolute position from in a ring of
+ * size. Recording stops at the first record that doesn't fit. Interrupts off. */
+static void append(const uint8_t* rec, const uint8_t* end, const uint8_t* ring, uint32_t size,
+                   uint32_t from, uint32_t extra) {
+    uint32_t n = (uint32_t) (end - rec);
+
+    if (trace.len + n + extra > TRACE_BUFF_SIZE) {
+        trace.full = 1;
+        recording = false;
+        return;
+    }
+
+    memcpy(&trace.data[trace.len], rec, n);
+    for (uint32_t i = 0; i < extra; i++) trace.data[trace.len + n + i] = ring[(from + i) % size];
+    trace.len += n + extra;
+    records++;
+}
+
+/* A record with just a value */
+static void record(trace_kind_t kind, uint64_t v) {
+    uint8_t rec[MAX_RECORD];
+    append(rec, put_tag(rec, kind, v), 0, 1, 0, 0);
+}
+
+static bool get_varint(uint64_t* v) {
+    uint32_t shift = 0;
+    *v = 0;
+    while (replay_at < replay_len && shift < 64) {
+        uint8_t b = replay_data[replay_at++];
+        *v |= (uint64_t) (b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+        shift += 7;
+    }
+    return false;
+}
+
+/* Replay: run the records the firmware doesn't ask for up to the next one, which has to be of
+ * kind. Returns its value. */
+static uint64_t take(trace_kind_t kind) {
+    for (;;) {
+        uint32_t start = replay_at;
+        if (start >= replay_len) replay->end(start, false);
+
+        uint8_t tag = replay_data[replay_at++];
+        trace_kind_t k = (trace_kind_t) (tag & 7);
+        uint64_t v = (tag >> 3) & 0xF;
+        uint64_t hi = 0, v2 = 0;
+
+        /* a record cut off at the end is the end */
+        if ((tag & 0x80) && !get_varint(&hi)) replay->end(start, false);
+        if (k == TRACE_RX_STAMP && !get_varint(&v2)) replay->end(start, false);
+        v |= hi << 4;
+        records++;
+
+        switch (k) {
+        case TRACE_ISR:
+            replay->isr((uint32_t) v);
+            break;
+        case TRACE_RX_STAMP:
+            last_stamp += (uint32_t) v;
+            replay->rx_stamp(last_stamp, last_time + (uint64_t) unzigzag(v2));
+            break;
+        case TRACE_TX_DONE:
+            replay->tx_done((uint32_t) v);
+            break;
+        default:
+            if (k != kind) replay->end(start, true);
+            return v;
+        }
+    }
+}
+
+/* Start recording. Called first thing after hal_init(), before anything reads the clock. */
+void trace_init(void) {
+    /* a hosted replay is set up before the firmware starts */
+    if (replay) return;
+
+    trace.magic = TRACE_MAGIC;
+    trace.len = 0;
+    trace.full = 0;
+    recording = true;
+}
+
+/* Hosted build: feed the firmware from a trace rather than the simulation, from reset */
+void trace_replay(const uint8_t* data, uint32_t len, const trace_replay_t* ops) {
+    replay = ops;
+    replay_data = data;
+    replay_len = len;
+    replay_at = 0;
+    recording = false;
+}
+
+/* Hosted build: the simulation looking at firmware state between passes, which isn't part of the
+ * session. Hooks pass straight through while held. */
+void trace_hold(bool hold) {
+    held = hold;
+}
+
+void trace_get_stats(trace_stats_t* out) {
+    out->bytes = replay ? replay_at : trace.len;
+    out->records = records;
+    out->cycles = last_time;
+    out->full = trace.full != 0;
+}
+
+/* A time base read */
+uint64_t trace_time(uint64_t cycles) {
+    if (held) return cycles;
+    if (replay) {
+        last_time += (uint64_t) unzigzag(take(TRACE_TIME));
+        return last_time;
+    }
+
+    bool irq = hal_irq_disable();
+    if (recording) {
+        record(TRACE_TIME, zigzag((int64_t) (cycles - last_time)));
+        last_time = cycles;
+    }
+    hal_irq_restore(irq);
+    return cycles;
+}
+
+/* First thing in a timer ISR. Replay runs the ISR itself, so it's only recorded. */
+void trace_isr(uint32_t source) {
+    if (held || replay) return;
+
+    bool irq = hal_irq_disable();
+    if (recording) record(TRACE_ISR, source);
+    hal_irq_restore(irq);
+}
+
+/* The RX byte count, with the bytes since the last look in buff (a ring of size). Replay puts the
+ * recorded bytes back where they were. If they lapped the ring only the last size were there. */
+uint32_t trace_rx(uint32_t written, uint8_t* buff, uint32_t size) {
+    if (held) return written;
+    if (replay) {
+        uint32_t n = (uint32_t) take(TRACE_RX);
+        uint32_t copy = n < size ? n : size;
+
+        written = last_rx + n;
+        if (replay_len - replay_at < copy) replay->end(replay_at, false);
+        for (uint32_t i = 0; i < copy; i++) {
+            buff[(written - copy + i) % size] = replay_data[replay_at++];
+        }
+        last_rx = written;
+        return written;
+    }
+
+    bool irq = hal_irq_disable();
+    if (recording) {
+        uint8_t rec[MAX_RECORD];
+        uint32_t n = written - last_rx;
+        uint32_t copy = n < size ? n : size;
+        append(rec, put_tag(rec, TRACE_RX, n), buff, size, written - copy, copy);
+        last_rx = written;
+    }
+    hal_irq_restore(irq);
+    return written;
+}
+
+/* The UART side stamping a delimiter (bluetooth_rx_stamp()) */
+void trace_rx_stamp(uint32_t pos, uint64_t cycles) {
+    if (held || replay) return;
+
+    bool irq = hal_irq_disable();
+    if (recording) {
+        uint8_t rec[MAX_RECORD];
+        uint8_t* p = put_tag(rec, TRACE_RX_STAMP, pos - last_stamp);
+        p = put_varint(p, zigzag((int64_t) (cycles - last_time)));
+        append(rec, p, 0, 1, 0, 0);
+        last_stamp = pos;
+    }
+    hal_irq_restore(irq);
+}
+
+/* The UART side taking len bytes off the TX ring (bluetooth_tx_done()) */
+void trace_tx_done(uint32_t len) {
+    if (held || replay) return;
+
+    bool irq = hal_irq_disable();
+    if (recording) record(TRACE_TX_DONE, len);
+    hal_irq_restore(irq);
+}
+
+/* Any other value the hardware hands the firmware */
+uint32_t trace_value(uint32_t value) {
+    if (held) return value;
+    if (replay) return (uint32_t) take(TRACE_VALUE);
+
+    bool irq = hal_irq_disable();
+    if (recording) record(TRACE_VALUE, value);
+    hal_irq_restore(irq);
+    return value;
+}
+
+/* An encoder read (axis is a hal_axis_t) */
+int32_t trace_encoder(uint32_t axis, int32_t count) {
+    if (held) return count;
+    if (replay) {
+        uint64_t v = take(TRACE_ENCODER);
+        if ((v & 1) != axis) replay->end(replay_at, true);
+        last_count[axis] += (int32_t) unzigzag(v >> 1);
+        return last_count[axis];
+    }
+
+    bool irq = hal_irq_disable();
+    if (recording) {
+        record(TRACE_ENCODER, zigzag((int64_t) count - last_count[axis]) << 1 | axis);
+        last_count[axis] = count;
+    }
+    hal_irq_restore(irq);
+    return count;
+}
+
+/* Around a main loop access to state an ISR shares: interrupts stay off until trace_unlock(), so
+ * they happened either before the sync point or after the access, and replay runs them the same
+ * side of it. Nests. */
+bool trace_lock(void) {
+    bool irq = hal_irq_disable();
+
+    if (held) return irq;
+    if (replay) {
+        take(TRACE_SYNC);
+    } else if (recording) {
+        record(TRACE_SYNC, 0);
+    }
+    return irq;
+}
+
+void trace_unlock(bool irq) {
+    hal_irq_restore(irq);
+}
+
+#endif /* TRACE_ENABLE */
@@ -0,0 +1,120 @@
+/*
+ * trace.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Record and replay of everything the firmware takes in from outside, so a session from the field
+ * can be run again, exactly, in the hosted build (host/autopoint --replay).
+ *
+ * Build with TRACE_ENABLE defined to have it. Without, the hooks below do nothing and cost
+ * nothing. With, trace_init() records from reset into `trace` in RAM until it fills (the start
+ * of a session is what replay needs). Save it from the debugger, the whole struct, header first,
+ * and that file is what --replay takes.
+ *
+ * Records are a tag byte (kind in the low 3 bits, 4 bits of value, continuation) and the rest of
+ * the value as a varint, mostly deltas against the previous record of the kind. In order:
+ *  - every util_clock_cycles() / util_clock_cycles64() read (2 bytes, typically)
+ *  - the RX byte count bluetooth.c sees each time it looks, and the bytes new since last time
+ *  - delimiter stamps and TX progress from the UART side
+ *  - the few other values read off the hardware: TX pending, encoder counts, the RTC at boot
+ *  - timer interrupt entries
+ *  - sync points, where the main loop touches state an ISR shares (trace_lock())
+ *
+ * Replay hands the recorded values back in place of the hardware's, and runs each interrupt at the
+ * next record after its own. All the main loop can see of an interrupt is through those records,
+ * shared state included (that's what the sync points are for, they hold interrupts off across
+ * the access), so each one lands where it did as far as the firmware can tell. A replay that
+ * asks for something different from what comes next in the trace has gone out of step, and stops.
+ * Without TRACE_ENABLE trace_lock() is nothing at all, so an access that has to be atomic against
+ * an ISR takes hal_irq_disable() itself, with the sync point inside.
+ *
+ * Not in the trace: flash, which replay loads from a file, and float maths. A PC follows the same
+ * IEEE rules but has its own libm, so a board trace can go out of step where a result lands an
+ * ulp either side of a branch. A trace from the hosted build replays exactly.
+ */
+
+typedef enum {
+    TRACE_TIME = 0,     /* time base read: zigzag delta from the last one */
+    TRACE_ISR,          /* timer interrupt entry: hal_timer_t */
+    TRACE_RX,           /* RX bytes written: count since the last one, then the bytes */
+    TRACE_RX_STAMP,     /* delimiter arrival: position delta, then zigzag delta of the time */
+    TRACE_TX_DONE,      /* bytes the UART side took off the TX ring */
+    TRACE_VALUE,        /* any other value read off the hardware, as is */
+    TRACE_ENCODER,      /* encoder read: zigzag delta from the axis's last, then the axis bit */
+    TRACE_SYNC          /* main loop access to state an ISR shares */
+} trace_kind_t;
+
+/* Replay calls these for records the firmware doesn't ask for: an interrupt, or the UART side's
+ * doing. end() is for the end of the trace (offset == length) or where replay went out of step,
+ * and doesn't return. */
+typedef struct {
+    void (*isr)(uint32_t source);
+    void (*rx_stamp)(uint32_t pos, uint64_t cycles);
+    void (*tx_done)(uint32_t len);
+    void (*end)(uint32_t offset, bool diverged);
+} trace_replay_t;
+
+typedef struct {
+    uint32_t bytes;
+    uint32_t records;
+    uint64_t cycles;    /* last time read */
+    bool full;
+} trace_stats_t;
+
+#ifdef TRACE_ENABLE
+
+#ifndef TRACE_BUFF_SIZE
+#define TRACE_BUFF_SIZE 8192
+#endif
+
+#define TRACE_MAGIC 0x52545041 /* "APTR" */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t len;       /* bytes of data used */
+    uint32_t full;      /* recording stopped for want of room */
+    uint32_t reserved;
+    uint8_t data[TRACE_BUFF_SIZE];
+} trace_buffer_t;
+
+extern trace_buffer_t trace;
+
+void trace_init(void);
+void trace_replay(const uint8_t* data, uint32_t len, const trace_replay_t* ops);
+void trace_hold(bool hold);
+void trace_get_stats(trace_stats_t* out);
+
+uint64_t trace_time(uint64_t cycles);
+void trace_isr(uint32_t source);
+uint32_t trace_rx(uint32_t written, uint8_t* buff, uint32_t size);
+void trace_rx_stamp(uint32_t pos, uint64_t cycles);
+void trace_tx_done(uint32_t len);
+uint32_t trace_value(uint32_t value);
+int32_t trace_encoder(uint32_t axis, int32_t count);
+bool trace_lock(void);
+void trace_unlock(bool irq);
+
+#else
+
+static inline void trace_init(void) {}
+static inline uint64_t trace_time(uint64_t cycles) { return cycles; }
+static inline void trace_isr(uint32_t source) { (void) source; }
+static inline uint32_t trace_rx(uint32_t written, uint8_t* buff, uint32_t size) { (void) buff; (void) size; return written; }
+static inline void trace_rx_stamp(uint32_t pos, uint64_t cycles) { (void) pos; (void) cycles; }
+static inline void trace_tx_done(uint32_t len) { (void) len; }
+static inline uint32_t trace_value(uint32_t value) { return value; }
+static inline int32_t trace_encoder(uint32_t axis, int32_t count) { (void) axis; return count; }
+static inline bool trace_lock(void) { return false; }
+static inline void trace_unlock(bool irq) { (void) irq; }
+
+#endif
+
+#endif /* TRACE_H_ */
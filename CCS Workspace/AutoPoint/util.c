@@ -8,40 +8,54 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-#include "inc/hw_memmap.h"
-#include "driverlib/sysctl.h"
-#include "driverlib/gpio.h"
-#include "driverlib/pin_map.h"
-#include "driverlib/timer.h"
-
+#include "hal.h"
 #include "util.h"
+#include "trace.h"
 
 /* Initialize the util module.
  *
- * Sets up TIMER0 to count system clock cycles (ideally 80MHz)
- * in full width (32-bit) mode.
+ * Starts the HAL's cycle counter, system clock cycles (ideally 80MHz) in 64 bits. At 80MHz that
+ * takes ~7000 years to wrap, so it's our monotonic time base for everything: profiling,
+ * scheduling and the UTC clock.
  */
 void util_init(void) {
+    hal_timebase_init();
+}
+
+/* Low 32 bits of the cycle counter. One register read, so this is the one to use in ISRs
+ * for short intervals (wraps every ~53 s, take differences as uint32_t). */
+uint32_t util_clock_cycles(void) {
+#ifdef TRACE_ENABLE
+    /* one traced read for both widths, so replay hands back the same low word */
+    return (uint32_t) util_clock_cycles64();
+#else
+    return hal_cycles();
+#endif
+}
 
-    /* Initialize the cycle (TIMER0) counter, straight off the system clock */
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
-    TimerConfigure(TIMER0_BASE, TIMER_CFG_PERIODIC_UP);
-    TimerClockSourceSet(TIMER0_BASE, TIMER_CLOCK_SYSTEM);
-    TimerEnable(TIMER0_BASE, TIMER_A);
+/* Full 64-bit cycle count since util_init(). Lock-free and safe from any context. */
+uint64_t util_clock_cycles64(void) {
+    return trace_time(hal_cycles64());
 }
 
-uint32_t debug_clock_cycles(void){
-    return TimerValueGet(TIMER0_BASE, TIMER_A);
+uint64_t util_clock_us64(void) {
+    return util_clock_cycles64() / (UTIL_CLOCK_HZ / 1000000);
 }
 
+/* Microseconds, truncated to 32 bits (wraps every ~71 minutes, take differences as uint32_t) */
 uint32_t util_clock_us(void) {
-    return (TimerValueGet(TIMER0_BASE, TIMER_A) / 80); //divide 80 MHz timer by 80 to get 1 MHz
+    return (uint32_t) util_clock_us64();
 }
 
-void util_delay_us(uint32_t delay) {
-    uint32_t start = util_clock_us();
+/* A cycle count as nanoseconds, for reporting short intervals (saturates at ~4.3 s) */
+uint32_t util_cycles_ns(uint32_t cycles) {
+    uint64_t ns = (uint64_t) cycles * 1000000000u / UTIL_CLOCK_HZ;
 
-    while( util_clock_us() - start < delay);
+    return ns > UINT32_MAX ? UINT32_MAX : (uint32_t) ns;
 }
 
+void util_delay_us(uint32_t delay) {
+    uint64_t end = util_clock_cycles64() + (uint64_t) delay * (UTIL_CLOCK_HZ / 1000000);
 
+    while (util_clock_cycles64() < end);
+}
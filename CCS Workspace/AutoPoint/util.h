@@ -10,8 +10,15 @@
 
 #include <stdint.h>
 
+/* System clock, set up in main() */
+#define UTIL_CLOCK_HZ 80000000
+
 void util_init(void);
+uint32_t util_clock_cycles(void);
+uint64_t util_clock_cycles64(void);
 uint32_t util_clock_us(void);
+uint64_t util_clock_us64(void);
+uint32_t util_cycles_ns(uint32_t cycles);
 void util_delay_us(uint32_t delay);
 
 
@@ -0,0 +1,773 @@
+/*
+ * hal_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+/* hal.h on a PC, for running the whole firmware (main.c's loop and all) without the board.
+ *
+ *   autopoint [--seconds s] [--realtime] [--loop-us us] [--start YYYY-MM-DDTHH:MM:SS]
+ *             [--at s:type[:hex payload]]... [--report s] [--state file] [--record file]
+ *             [--latency ms] [--jitter ms] [--drop p] [--ber p] [--boot-ms ms] [--configured]
+ *             [--seed n] [--link path]
+ *   autopoint --replay file [--state file | --flash file] [--report s]
+ *
+ * Time is virtual: UTIL_CLOCK_HZ cycles, starting at 0. Every time base read costs a few cycles,
+ * and each pass of the main loop (hal_idle()) takes --loop-us. Timers come due on the way and
+ * their ISRs run right then, at the time they were due, preempting whatever has a lower
+ * priority, so interrupts land between any two clock reads (not anywhere, like on the board,
+ * but at the points that matter for timing). Masked timers wait, and timeouts missed while
+ * masked fold into one, like the real interrupt flag.
+ *
+ * Without --realtime that runs as fast as the PC goes, many times real time; --seconds is
+ * virtual. With it, virtual time keeps pace with the PC's clock, for talking to it over the pty
+ * (sim_uart.c) with linkbench or a phone.
+ *
+ * The rest of the board: pins record their level, rising edges and time high. The motors are
+ * first order (full duty is SIM_MOTOR_RATE, time constant SIM_MOTOR_TAU) with the encoders on
+ * their shafts. Flash covers the storage area. The RTC starts stopped, as after a battery change;
+ * --state keeps flash and the RTC in a file between runs, like the board keeps them between
+ * resets. If the clock isn't set once the firmware is up, it's set to --start (default: now).
+ *
+ * --at sends a frame from the phone's end at a virtual time: --at 2:07:01 enables the mount two
+ * seconds in. --report prints the mount's state every so often.
+ *
+ * The build has TRACE_ENABLE on, so it always records (see trace.h); --record saves the trace at
+ * the end. --replay runs the firmware from a trace instead, the hosted build's or one saved off a
+ * board, with no link or clock of its own: time, bytes and interrupts all come out of the trace,
+ * until it runs out (or the firmware goes out of step with it, which is an error). Flash isn't in
+ * the trace; --state loads it as usual, or --flash from a dump of the board's storage area.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stddef.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "util.h"
+#include "clock.h"
+#include "frame.h"
+#include "bluetooth.h"
+#include "mount.h"
+#include "interlock.h"
+#include "setpoint.h"
+#include "storage.h"
+#include "trace.h"
+#include "bluetooth_uart.h"
+#include "sim_uart.h"
+
+#define SIM_READ_CYCLES     8           /* one time base read */
+#define SIM_LOOP_US         100         /* one main loop pass, default */
+
+#define SIM_MOTOR_RATE      1.0         /* rad/s at full duty */
+#define SIM_MOTOR_TAU       0.05        /* s */
+
+#define FLASH_BASE          STORAGE_BASE
+#define FLASH_SIZE          (STORAGE_SLOT_COUNT * STORAGE_SLOT_SIZE)
+#define FLASH_BLOCK         1024
+
+#define STATE_MAGIC         0x41505349  /* "APSI" */
+#define MAX_EVENTS          64
+
+#define RAD_TO_DEG          (180.0 / 3.14159265358979)
+#define RAD_TO_ARCSEC       (RAD_TO_DEG * 3600.0)
+
+/* main.c, built with main renamed */
+int firmware_main(void);
+
+typedef struct {
+    hal_isr_t isr;
+    uint8_t priority;
+    bool running;
+    bool masked;
+    uint32_t period;
+    uint32_t next_period;       /* loaded at the next timeout */
+    uint64_t due;
+    uint64_t count;
+    uint64_t max_late;
+} sim_timer_t;
+
+typedef struct {
+    bool level;
+    uint64_t edges;
+    uint64_t high_since;
+    uint64_t high_cycles;
+} sim_pin_t;
+
+typedef struct {
+    float duty;
+    double pos, vel;            /* rad, rad/s */
+    uint64_t at;
+    int32_t offset;             /* counts, from hal_encoder_set() */
+    double rad_per_count;
+} sim_motor_t;
+
+typedef struct {
+    uint64_t at;
+    uint8_t type;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint32_t len;
+} sim_event_t;
+
+/* Battery backed, saved with --state */
+typedef struct {
+    uint32_t magic;
+    uint32_t rtc_running;
+    uint32_t rtc_sec;
+    uint32_t reserved;
+    int64_t saved_unix;
+    uint32_t rtc_data[HAL_RTC_WORDS];
+    uint8_t flash[FLASH_SIZE];
+} sim_state_t;
+
+static uint64_t now = 0;
+static int current_priority = 256;     /* thread mode, below every interrupt */
+static bool irq_off = false;
+
+static bool realtime = false;
+static uint64_t loop_cycles = (uint64_t) SIM_LOOP_US * (UTIL_CLOCK_HZ / 1000000);
+static uint64_t end_cycles = 0;
+static uint64_t report_cycles = 0, next_report = 0;
+static uint64_t host_base_ns;
+static volatile sig_atomic_t stop = 0;
+
+static bool start_given = false;
+static struct tm start_tm;
+static const char* state_path = NULL;
+static const char* record_path = NULL;
+static bool replaying = false;
+static uint64_t host_start;
+
+static sim_timer_t timers[HAL_TIMER_COUNT];
+static sim_pin_t pins[HAL_PIN_COUNT];
+static sim_motor_t motors[HAL_AXIS_COUNT];
+static sim_state_t state;
+static uint64_t rtc_set_at = 0;
+
+static sim_event_t events[MAX_EVENTS];
+static uint32_t event_count = 0, event_next = 0;
+
+/* Tracking error while the mount is enabled, sampled every loop pass */
+static double err_sq = 0.0, err_max = 0.0;
+static uint64_t err_samples = 0;
+
+static const char* const pin_names[HAL_PIN_COUNT] = {
+    "laser switch", "laser enable", "az step", "az dir", "el step", "el dir",
+};
+static const char* const timer_names[HAL_TIMER_COUNT] = { "setpoint", "az step", "el step" };
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static uint64_t host_cycles(void) {
+    return (mono_ns() - host_base_ns) * (UTIL_CLOCK_HZ / 1000000) / 1000;
+}
+
+/* The timer whose interrupt is next at or before 'to' and allowed to preempt, -1 if none */
+static int next_due(uint64_t to) {
+    int best = -1;
+    if (irq_off || replaying) return -1;
+    for (int i = 0; i < HAL_TIMER_COUNT; i++) {
+        const sim_timer_t* t = &timers[i];
+        if (!t->running || t->masked || t->priority >= current_priority || t->due > to) continue;
+        if (best < 0 || t->due < timers[best].due ||
+            (t->due == timers[best].due && t->priority < timers[best].priority)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void take(sim_timer_t* t) {
+    uint64_t late = now - t->due;
+    if (late > t->max_late) t->max_late = late;
+
+    t->period = t->next_period;
+    t->due += t->period;
+    while (t->due <= now) t->due += t->period;     /* missed timeouts are one interrupt */
+    t->count++;
+
+    int prev = current_priority;
+    current_priority = t->priority;
+    t->isr();
+    current_priority = prev;
+}
+
+/* Move virtual time on to 'to', taking the interrupts that come due on the way */
+static void advance(uint64_t to) {
+    int i;
+    while ((i = next_due(to)) >= 0) {
+        if (timers[i].due > now) now = timers[i].due;
+        take(&timers[i]);
+    }
+    if (to > now) now = to;
+}
+
+static void motor_run(sim_motor_t* m) {
+    double dt = (double) (now - m->at) / UTIL_CLOCK_HZ;
+    double target = m->duty * SIM_MOTOR_RATE;
+    double k = exp(-dt / SIM_MOTOR_TAU);
+
+    m->pos += target * dt + (m->vel - target) * SIM_MOTOR_TAU * (1.0 - k);
+    m->vel = target + (m->vel - target) * k;
+    m->at = now;
+}
+
+static int32_t motor_counts(const sim_motor_t* m) {
+    return (int32_t) (int64_t) floor(m->pos / m->rad_per_count);
+}
+
+/* hal.h */
+
+void hal_init(void) {
+}
+
+void hal_timebase_init(void) {
+}
+
+bool hal_irq_disable(void) {
+    bool was = irq_off;
+    irq_off = true;
+    return was;
+}
+
+void hal_irq_restore(bool was_disabled) {
+    irq_off = was_disabled;
+}
+
+uint32_t hal_cycles(void) {
+    return (uint32_t) hal_cycles64();
+}
+
+uint64_t hal_cycles64(void) {
+    uint64_t to = now + SIM_READ_CYCLES;
+    if (realtime) {
+        uint64_t h = host_cycles();
+        if (h > to) to = h;
+    }
+    advance(to);
+    return now;
+}
+
+void hal_pin_output(hal_pin_t pin, bool level) {
+    hal_pin_write(pin, level);
+}
+
+void hal_pin_write(hal_pin_t pin, bool level) {
+    sim_pin_t* p = &pins[pin];
+    if (level && !p->level) {
+        p->edges++;
+        p->high_since = now;
+    } else if (!level && p->level) {
+        p->high_cycles += now - p->high_since;
+    }
+    p->level = level;
+}
+
+bool hal_pin_read(hal_pin_t pin) {
+    return pins[pin].level;
+}
+
+void hal_timer_init(hal_timer_t timer, hal_isr_t isr, uint8_t priority) {
+    sim_timer_t* t = &timers[timer];
+    t->isr = isr;
+    t->priority = priority;
+    t->running = false;
+    t->masked = false;
+}
+
+void hal_timer_set_period(hal_timer_t timer, uint32_t cycles) {
+    sim_timer_t* t = &timers[timer];
+    t->next_period = cycles;
+    if (!t->running) t->period = cycles;
+}
+
+void hal_timer_start(hal_timer_t timer) {
+    sim_timer_t* t = &timers[timer];
+    if (t->running) return;
+    t->running = true;
+    t->due = now + t->period;
+}
+
+void hal_timer_stop(hal_timer_t timer) {
+    timers[timer].running = false;
+}
+
+void hal_timer_mask(hal_timer_t timer, bool masked) {
+    timers[timer].masked = masked;
+}
+
+void hal_timer_ack(hal_timer_t timer) {
+    (void) timer;
+}
+
+void hal_motor_init(uint32_t pwm_hz) {
+    (void) pwm_hz;
+    for (int i = 0; i < HAL_AXIS_COUNT; i++) {
+        motors[i].duty = 0.0f;
+        motors[i].at = now;
+    }
+}
+
+void hal_motor_drive(hal_axis_t axis, float duty) {
+    motor_run(&motors[axis]);
+    motors[axis].duty = duty;
+}
+
+void hal_encoder_init(void) {
+    motors[HAL_AXIS_AZ].rad_per_count = 2.0 * 3.14159265358979 / MOUNT_AZ_COUNTS_PER_REV;
+    motors[HAL_AXIS_EL].rad_per_count = 2.0 * 3.14159265358979 / MOUNT_EL_COUNTS_PER_REV;
+    for (int i = 0; i < HAL_AXIS_COUNT; i++) hal_encoder_set((hal_axis_t) i, 0);
+}
+
+int32_t hal_encoder_get(hal_axis_t axis) {
+    sim_motor_t* m = &motors[axis];
+    motor_run(m);
+    return motor_counts(m) + m->offset;
+}
+
+void hal_encoder_set(hal_axis_t axis, int32_t count) {
+    sim_motor_t* m = &motors[axis];
+    motor_run(m);
+    m->offset = count - motor_counts(m);
+}
+
+bool hal_flash_erase(uint32_t addr) {
+    if (addr < FLASH_BASE || addr - FLASH_BASE >= FLASH_SIZE || addr % FLASH_BLOCK) return false;
+    memset(&state.flash[addr - FLASH_BASE], 0xFF, FLASH_BLOCK);
+    return true;
+}
+
+/* Programming only ever clears bits */
+bool hal_flash_program(const uint32_t* words, uint32_t addr, uint32_t len) {
+    if (addr < FLASH_BASE || addr - FLASH_BASE + len > FLASH_SIZE || (addr | len) % 4) return false;
+
+    uint8_t* dst = &state.flash[addr - FLASH_BASE];
+    const uint8_t* src = (const uint8_t*) words;
+    for (uint32_t i = 0; i < len; i++) dst[i] &= src[i];
+    return true;
+}
+
+const void* hal_flash_map(uint32_t addr) {
+    return &state.flash[addr - FLASH_BASE];
+}
+
+bool hal_rtc_init(void) {
+    if (state.rtc_running) return true;
+
+    state.rtc_running = 1;
+    state.rtc_sec = 0;
+    rtc_set_at = now;
+    return false;
+}
+
+void hal_rtc_read(uint32_t* sec, uint32_t* subsec) {
+    uint64_t elapsed = now - rtc_set_at;
+    *sec = state.rtc_sec + (uint32_t) (elapsed / UTIL_CLOCK_HZ);
+    *subsec = (uint32_t) ((elapsed % UTIL_CLOCK_HZ) * HAL_RTC_SUBSEC_HZ / UTIL_CLOCK_HZ);
+}
+
+void hal_rtc_set(uint32_t sec) {
+    state.rtc_sec = sec;
+    rtc_set_at = now;
+}
+
+void hal_rtc_data_get(uint32_t* words, uint32_t count) {
+    memcpy(words, state.rtc_data, count * sizeof(uint32_t));
+}
+
+void hal_rtc_data_set(const uint32_t* words, uint32_t count) {
+    memcpy(state.rtc_data, words, count * sizeof(uint32_t));
+}
+
+/* Simulation */
+
+static void state_load(void) {
+    memset(state.flash, 0xFF, sizeof(state.flash));
+    if (state_path == NULL) return;
+
+    FILE* f = fopen(state_path, "rb");
+    if (f == NULL) return;
+
+    sim_state_t s;
+    if (fread(&s, sizeof(s), 1, f) == 1 && s.magic == STATE_MAGIC) {
+        state = s;
+        /* the RTC kept going while we weren't running */
+        if (state.rtc_running) state.rtc_sec += (uint32_t) (time(NULL) - s.saved_unix);
+    }
+    fclose(f);
+}
+
+static void state_save(void) {
+    if (state_path == NULL) return;
+
+    uint32_t subsec;
+    hal_rtc_read(&state.rtc_sec, &subsec);
+    state.magic = STATE_MAGIC;
+    state.saved_unix = time(NULL);
+
+    FILE* f = fopen(state_path, "wb");
+    if (f == NULL || fwrite(&state, sizeof(state), 1, f) != 1) perror(state_path);
+    if (f != NULL) fclose(f);
+}
+
+/* Setting the clock is the operator's doing, not the firmware's, so the time goes in the trace */
+static void set_clock(void) {
+    struct tm tm;
+    uint32_t msec = 0;
+    if (start_given) {
+        tm = start_tm;
+    } else {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        gmtime_r(&ts.tv_sec, &tm);
+        msec = (uint32_t) (ts.tv_nsec / 1000000);
+    }
+
+    uint32_t f[7] = {
+        (uint32_t) tm.tm_year + 1900, (uint32_t) tm.tm_mon + 1, (uint32_t) tm.tm_mday,
+        (uint32_t) tm.tm_hour, (uint32_t) tm.tm_min, (uint32_t) tm.tm_sec, msec,
+    };
+    for (int i = 0; i < 7; i++) f[i] = trace_value(f[i]);
+
+    clock_set_utc(f[0], f[1], f[2], f[3], f[4], f[5], f[6]);
+    printf("%10.3f clock set to %04u-%02u-%02uT%02u:%02u:%02u.%03u\n", (double) now / UTIL_CLOCK_HZ,
+           f[0], f[1], f[2], f[3], f[4], f[5], f[6]);
+}
+
+static void report(void) {
+    mount_status_t m;
+    interlock_status_t il;
+    mount_get_status(&m);
+    interlock_get_status(&il);
+
+    printf("%10.3f az %8.3f el %7.3f deg, error %8.1f %8.1f arcsec, duty %6.3f %6.3f, %s%s, laser %s (0x%lx)\n",
+           (double) now / UTIL_CLOCK_HZ, m.az * RAD_TO_DEG, m.el * RAD_TO_DEG,
+           m.az_err * RAD_TO_ARCSEC, m.el_err * RAD_TO_ARCSEC, m.az_duty, m.el_duty,
+           m.enabled ? "enabled" : "disabled", il.armed ? ", armed" : "",
+           il.laser_on ? "on" : "off", (unsigned long) il.reasons);
+}
+
+static void sample_error(void) {
+    mount_status_t m;
+    mount_get_status(&m);
+    if (!m.enabled) return;
+
+    double e = hypot(m.az_err * cos(m.el), m.el_err) * RAD_TO_ARCSEC;
+    err_sq += e * e;
+    if (e > err_max) err_max = e;
+    err_samples++;
+}
+
+static void summary(double host_s) {
+    double virt_s = (double) now / UTIL_CLOCK_HZ;
+    setpoint_stats_t sp;
+    bluetooth_stats_t bt;
+    sim_link_stats_t link;
+    trace_stats_t tr;
+
+    setpoint_get_stats(&sp);
+    bluetooth_get_stats(&bt);
+    sim_uart_get_stats(&link);
+    trace_get_stats(&tr);
+
+    printf("\n%.1f s simulated in %.2f s (%.0fx)\n", virt_s, host_s, host_s > 0 ? virt_s / host_s : 0.0);
+
+    for (int i = 0; i < HAL_TIMER_COUNT; i++) {
+        if (timers[i].count == 0) continue;
+        printf("timer %-9s %10llu interrupts, latest %.2f us\n", timer_names[i],
+               (unsigned long long) timers[i].count, timers[i].max_late / (UTIL_CLOCK_HZ / 1e6));
+    }
+    for (int i = 0; i < HAL_PIN_COUNT; i++) {
+        const sim_pin_t* p = &pins[i];
+        uint64_t high = p->high_cycles + (p->level ? now - p->high_since : 0);
+        if (p->edges == 0) continue;
+        printf("pin %-12s %10llu rising edges, high %.3f s\n", pin_names[i],
+               (unsigned long long) p->edges, (double) high / UTIL_CLOCK_HZ);
+    }
+#ifndef MOUNT_USE_STEPPERS
+    if (!replaying) printf("motors: az %.3f el %.3f deg\n", motors[HAL_AXIS_AZ].pos * RAD_TO_DEG, motors[HAL_AXIS_EL].pos * RAD_TO_DEG);
+#endif
+    if (err_samples > 0) {
+        printf("tracking error: rms %.1f, max %.1f arcsec\n", sqrt(err_sq / err_samples), err_max);
+    }
+    printf("setpoint: %u ticks, %u underruns\n", sp.ticks, sp.underruns);
+    if (!replaying) printf("link: up %llu bytes, %llu dropped; down %llu bytes, %llu dropped; %u resets, baud %u\n",
+           (unsigned long long) link.up_bytes, (unsigned long long) link.up_dropped,
+           (unsigned long long) link.down_bytes, (unsigned long long) link.down_dropped,
+           link.resets, bluetooth_get_baud());
+    printf("bluetooth: TX high water %u, %u refused, RX %u overruns, %u dropped\n",
+           bt.tx_high_water, bt.tx_overflows, bt.rx_overruns, bt.rx_dropped);
+    printf("trace: %u records, %u bytes%s\n", tr.records, tr.bytes, tr.full ? ", full" : "");
+}
+
+static void trace_save(void) {
+    FILE* f = fopen(record_path, "wb");
+    size_t n = offsetof(trace_buffer_t, data) + trace.len;
+    if (f == NULL || fwrite(&trace, 1, n, f) != n) perror(record_path);
+    if (f != NULL) fclose(f);
+}
+
+static void finish(int code) {
+    trace_hold(true);
+    summary((double) (mono_ns() - host_start) / 1e9);
+    if (!replaying) state_save();
+    if (record_path != NULL) trace_save();
+    exit(code);
+}
+
+/* Replay is at the last time the firmware read */
+static void replay_now(void) {
+    trace_stats_t tr;
+    trace_get_stats(&tr);
+    if (tr.cycles > now) now = tr.cycles;
+}
+
+static void replay_isr(uint32_t source) {
+    if (source >= HAL_TIMER_COUNT || timers[source].isr == NULL) {
+        printf("replay: interrupt from timer %u, which the firmware never set up\n", source);
+        finish(1);
+    }
+    replay_now();
+    timers[source].count++;
+    timers[source].isr();
+}
+
+static void replay_end(uint32_t offset, bool diverged) {
+    if (diverged) {
+        printf("replay: out of step with the trace at byte %u\n", offset);
+    } else {
+        printf("replay: end of trace\n");
+    }
+    finish(diverged ? 1 : 0);
+}
+
+static const trace_replay_t replay_ops = {
+    .isr = replay_isr,
+    .rx_stamp = bluetooth_rx_stamp,
+    .tx_done = bluetooth_tx_done,
+    .end = replay_end,
+};
+
+static bool replay_load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    static trace_buffer_t t;
+    size_t n = fread(&t, 1, sizeof(t), f);
+    fclose(f);
+
+    size_t header = offsetof(trace_buffer_t, data);
+    if (n < header || t.magic != TRACE_MAGIC) return false;
+
+    /* a dump cut short still replays as far as it goes */
+    if (t.len > n - header) t.len = (uint32_t) (n - header);
+
+    trace_replay(t.data, t.len, &replay_ops);
+    replaying = true;
+    printf("replaying %u bytes of trace%s\n", t.len, t.full ? " (recording ran out of room)" : "");
+    return true;
+}
+
+static bool flash_load(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return false;
+    size_t n = fread(state.flash, 1, sizeof(state.flash), f);
+    fclose(f);
+    return n > 0;
+}
+
+void hal_idle(void) {
+    static bool started = false;
+
+    if (!started) {
+        started = true;
+        host_start = mono_ns();
+        if (trace_value(!clock_is_set() || start_given)) set_clock();
+    }
+
+    if (replaying) {
+        replay_now();
+    } else {
+        sim_uart_poll();
+
+        while (event_next < event_count && events[event_next].at <= now) {
+            uint8_t buf[FRAME_MAX_ENCODED];
+            const sim_event_t* e = &events[event_next++];
+            sim_uart_phone_send(buf, frame_encode(e->type, e->payload, e->len, buf));
+        }
+    }
+
+    trace_hold(true);
+    sample_error();
+    if (report_cycles > 0 && now >= next_report) {
+        report();
+        next_report += report_cycles;
+    }
+    trace_hold(false);
+
+    if (stop || (!replaying && end_cycles > 0 && now >= end_cycles)) finish(0);
+
+    /* replay's time is the trace's */
+    if (replaying) return;
+
+    if (realtime) {
+        struct timespec idle = { 0, (long) (loop_cycles * 1000 / (UTIL_CLOCK_HZ / 1000000)) };
+        nanosleep(&idle, NULL);
+        advance(host_cycles());
+    } else {
+        advance(now + loop_cycles);
+    }
+}
+
+static void on_signal(int sig) {
+    (void) sig;
+    stop = 1;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--seconds s] [--realtime] [--loop-us us] [--start YYYY-MM-DDTHH:MM:SS]\n"
+                    "       [--at s:type[:hex]]... [--report s] [--state file] [--record file]\n"
+                    "       [--latency ms] [--jitter ms] [--drop p] [--ber p] [--boot-ms ms] [--configured]\n"
+                    "       [--seed n] [--link path]\n"
+                    "       %s --replay file [--state file | --flash file] [--report s]\n", argv0, argv0);
+    exit(2);
+}
+
+/* s:type[:hex payload] */
+static bool parse_event(const char* arg, sim_event_t* e) {
+    char* p;
+    double at = strtod(arg, &p);
+    if (*p++ != ':') return false;
+
+    e->at = (uint64_t) (at * UTIL_CLOCK_HZ);
+    e->type = (uint8_t) strtoul(p, &p, 16);
+    e->len = 0;
+    if (*p == 0) return true;
+    if (*p++ != ':') return false;
+
+    while (p[0] && p[1] && e->len < FRAME_MAX_PAYLOAD) {
+        char hex[3] = { p[0], p[1], 0 };
+        e->payload[e->len++] = (uint8_t) strtoul(hex, NULL, 16);
+        p += 2;
+    }
+    return *p == 0;
+}
+
+static int cmp_event(const void* a, const void* b) {
+    uint64_t x = ((const sim_event_t*) a)->at, y = ((const sim_event_t*) b)->at;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv) {
+    sim_link_t model = {
+        .latency_ms = 20.0f,
+        .jitter_ms = 5.0f,
+        .boot_ms = 500,
+        .seed = 1,
+    };
+    const char* link_path = NULL;
+    const char* replay_path = NULL;
+    const char* flash_path = NULL;
+    double seconds = -1.0, report_s = 0.0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(a, "--configured") == 0) {
+            model.configured = true;
+            continue;
+        }
+        if (strcmp(a, "--realtime") == 0) {
+            realtime = true;
+            continue;
+        }
+        if (v == NULL) usage(argv[0]);
+        i++;
+
+        if (strcmp(a, "--seconds") == 0) seconds = strtod(v, NULL);
+        else if (strcmp(a, "--loop-us") == 0) loop_cycles = strtoull(v, NULL, 0) * (UTIL_CLOCK_HZ / 1000000);
+        else if (strcmp(a, "--report") == 0) report_s = strtod(v, NULL);
+        else if (strcmp(a, "--state") == 0) state_path = v;
+        else if (strcmp(a, "--record") == 0) record_path = v;
+        else if (strcmp(a, "--replay") == 0) replay_path = v;
+        else if (strcmp(a, "--flash") == 0) flash_path = v;
+        else if (strcmp(a, "--start") == 0) {
+            memset(&start_tm, 0, sizeof(start_tm));
+            if (sscanf(v, "%d-%d-%dT%d:%d:%d", &start_tm.tm_year, &start_tm.tm_mon, &start_tm.tm_mday,
+                       &start_tm.tm_hour, &start_tm.tm_min, &start_tm.tm_sec) != 6) usage(argv[0]);
+            start_tm.tm_year -= 1900;
+            start_tm.tm_mon -= 1;
+            start_given = true;
+        }
+        else if (strcmp(a, "--at") == 0) {
+            if (event_count == MAX_EVENTS || !parse_event(v, &events[event_count++])) usage(argv[0]);
+        }
+        else if (strcmp(a, "--latency") == 0) model.latency_ms = strtof(v, NULL);
+        else if (strcmp(a, "--jitter") == 0) model.jitter_ms = strtof(v, NULL);
+        else if (strcmp(a, "--drop") == 0) model.drop = strtof(v, NULL);
+        else if (strcmp(a, "--ber") == 0) model.ber = strtof(v, NULL);
+        else if (strcmp(a, "--boot-ms") == 0) model.boot_ms = (uint32_t) strtoul(v, NULL, 0);
+        else if (strcmp(a, "--seed") == 0) model.seed = (uint32_t) strtoul(v, NULL, 0);
+        else if (strcmp(a, "--link") == 0) link_path = v;
+        else usage(argv[0]);
+    }
+
+    /* a fast run with no end would never stop */
+    if (seconds < 0.0) seconds = realtime ? 0.0 : 60.0;
+    end_cycles = (uint64_t) (seconds * UTIL_CLOCK_HZ);
+    report_cycles = (uint64_t) (report_s * UTIL_CLOCK_HZ);
+    next_report = report_cycles;
+    qsort(events, event_count, sizeof(sim_event_t), cmp_event);
+
+    state_load();
+    if (flash_path != NULL && !flash_load(flash_path)) {
+        perror(flash_path);
+        return 1;
+    }
+    host_base_ns = mono_ns();
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    if (replay_path != NULL) {
+        if (!replay_load(replay_path)) {
+            fprintf(stderr, "%s: not a trace\n", replay_path);
+            return 1;
+        }
+        setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+        return firmware_main();
+    }
+
+    const char* pty = sim_uart_open(&model);
+    if (pty == NULL) {
+        perror("sim_uart_open");
+        return 1;
+    }
+    if (link_path != NULL) {
+        unlink(link_path);
+        if (symlink(pty, link_path) != 0) {
+            perror(link_path);
+            return 1;
+        }
+    }
+    printf("%s\n", pty);
+    fflush(stdout);
+
+    if (!realtime) setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+
+    return firmware_main();
+}
@@ -0,0 +1,281 @@
+/*
+ * linkbench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+/* The phone's end of the link, for benchmarking against autopoint --realtime (or, through a
+ * serial port bridge, the real thing): waits for the link to come up, then measures time sync
+ * round trips and the link test throughput both ways.
+ *
+ *   linkbench <pty> [--pings n] [--down bytes] [--up bytes]
+ *
+ * Round trips are TIME_REQUEST to its reply; offset is the time sync estimate. Against the hosted
+ * firmware both ends run off the PC's clock (the firmware's set from it to the millisecond), so
+ * it shows the error the estimate carries: about -1 ms, half of the module holding the reply back
+ * (SIM_RADIO_FLUSH_US) to fill a radio packet, which the firmware can't see. Throughput is
+ * on-wire bytes (what the UART carries) per second.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "linktest.h"
+#include "protocol.h"
+
+#define LINK_UP_TIMEOUT_MS  60000
+#define REPLY_TIMEOUT_MS    2000
+
+static int fd = -1;
+
+static uint8_t rx_buf[FRAME_MAX_ENCODED * 2];
+static uint32_t rx_len = 0;
+
+static uint64_t down_wire = 0;      /* LINK_FILL bytes on the wire since the last reset */
+static int64_t down_first = 0, down_last = 0;
+static uint64_t down_timed = 0;     /* bytes after the first frame, the ones first to last covers */
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool send_frame(uint8_t type, const void* payload, uint32_t len) {
+    uint8_t buf[FRAME_MAX_ENCODED];
+    uint32_t n = frame_encode(type, payload, len, buf);
+    uint32_t done = 0;
+
+    while (done < n) {
+        ssize_t w = write(fd, &buf[done], n - done);
+        if (w < 0) {
+            if (errno != EAGAIN && errno != EINTR) return false;
+            struct pollfd p = { fd, POLLOUT, 0 };
+            poll(&p, 1, 100);
+            continue;
+        }
+        done += (uint32_t) w;
+    }
+    return true;
+}
+
+/* Read until a reply of the wanted type comes in (payload into out, returns its length) or the
+ * timeout runs out (-1). Filler seen on the way is counted for the downlink test. */
+static int32_t wait_reply(uint8_t type, uint8_t* out, uint32_t out_len, int timeout_ms) {
+    int64_t end = now_us() + (int64_t) timeout_ms * 1000;
+
+    for (;;) {
+        uint8_t chunk[256];
+        int64_t left = end - now_us();
+        if (left <= 0) return -1;
+
+        struct pollfd p = { fd, POLLIN, 0 };
+        if (poll(&p, 1, (int) (left / 1000) + 1) <= 0) continue;
+
+        ssize_t r = read(fd, chunk, sizeof(chunk));
+        if (r <= 0) continue;
+
+        for (ssize_t i = 0; i < r; i++) {
+            if (chunk[i] != FRAME_DELIM) {
+                if (rx_len < sizeof(rx_buf)) rx_buf[rx_len] = chunk[i];
+                rx_len++;
+                continue;
+            }
+
+            uint32_t wire = rx_len + 1;
+            uint8_t t;
+            uint8_t* payload;
+            int32_t n = rx_len <= sizeof(rx_buf) ? frame_decode(rx_buf, rx_len, &t, &payload) : -1;
+            rx_len = 0;
+            if (n < 0) continue;
+
+            if (t == (PROTO_LINK_FILL | PROTO_REPLY)) {
+                int64_t now = now_us();
+                if (down_wire == 0) {
+                    down_first = now;
+                } else {
+                    down_timed += wire;
+                }
+                down_last = now;
+                down_wire += wire;
+            }
+            if (t == (type | PROTO_REPLY)) {
+                uint32_t copy = (uint32_t) n < out_len ? (uint32_t) n : out_len;
+                memcpy(out, payload, copy);
+                return n;
+            }
+        }
+    }
+}
+
+/* The module is up and the firmware is framing once anything gets answered */
+static bool wait_link(void) {
+    int64_t start = now_us();
+    uint8_t type = PROTO_PACKET_STATS;
+    uint8_t reply[17];
+
+    while (now_us() - start < (int64_t) LINK_UP_TIMEOUT_MS * 1000) {
+        send_frame(PROTO_PACKET_STATS, &type, 1);
+        if (wait_reply(PROTO_PACKET_STATS, reply, sizeof(reply), 250) >= 0) {
+            printf("link up after %.1f s\n", (double) (now_us() - start) / 1e6);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int cmp_i64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*) a, y = *(const int64_t*) b;
+    return (x > y) - (x < y);
+}
+
+static void bench_rtt(uint32_t count) {
+    int64_t* rtt = malloc(count * sizeof(int64_t));
+    int64_t* offset = malloc(count * sizeof(int64_t));
+    uint32_t got = 0, lost = 0;
+
+    for (uint32_t seq = 0; seq < count; seq++) {
+        uint8_t req[12], reply[28];
+        int64_t t1 = now_us();
+
+        le_put_u32(&req[0], seq);
+        le_put_i64(&req[4], t1);
+        send_frame(PROTO_TIME_REQUEST, req, sizeof(req));
+
+        /* a reply to an earlier, timed out request doesn't count */
+        int32_t n;
+        do {
+            n = wait_reply(PROTO_TIME_REQUEST, reply, sizeof(reply), REPLY_TIMEOUT_MS);
+        } while (n == 28 && le_get_u32(reply) != seq);
+
+        int64_t t4 = now_us();
+        if (n != 28) {
+            lost++;
+            continue;
+        }
+        int64_t t2 = le_get_i64(&reply[12]), t3 = le_get_i64(&reply[20]);
+        rtt[got] = t4 - t1;
+        offset[got] = ((t2 - t1) + (t3 - t4)) / 2;
+        got++;
+    }
+
+    if (got > 0) {
+        qsort(rtt, got, sizeof(int64_t), cmp_i64);
+        qsort(offset, got, sizeof(int64_t), cmp_i64);
+        printf("rtt: %u ok, %u lost; min %.2f, median %.2f, p95 %.2f, p99 %.2f, max %.2f ms\n",
+               got, lost, rtt[0] / 1e3, rtt[got / 2] / 1e3, rtt[got * 95 / 100] / 1e3,
+               rtt[got * 99 / 100] / 1e3, rtt[got - 1] / 1e3);
+        printf("offset: median %lld us, %lld..%lld us\n", (long long) offset[got / 2],
+               (long long) offset[0], (long long) offset[got - 1]);
+    } else {
+        printf("rtt: all %u lost\n", lost);
+    }
+    free(rtt);
+    free(offset);
+}
+
+static void bench_down(uint32_t bytes) {
+    uint8_t req[4], reply[8];
+
+    down_wire = 0;
+    down_timed = 0;
+    le_put_u32(req, bytes);
+    send_frame(PROTO_LINK_SEND, req, sizeof(req));
+
+    /* a little over the time it should take at 9600 baud, whatever the link's at */
+    int timeout = REPLY_TIMEOUT_MS + (int) (bytes / 960 * 1000);
+    if (wait_reply(PROTO_LINK_SEND, reply, sizeof(reply), timeout) < 0) {
+        printf("down: no end marker, %llu bytes arrived\n", (unsigned long long) down_wire);
+        return;
+    }
+
+    uint32_t sent = le_get_u32(reply), baud = le_get_u32(&reply[4]);
+    double s = (double) (down_last - down_first) / 1e6;
+    printf("down: %llu of %u bytes in %.2f s, %.0f B/s (baud %u, %.0f%% of the UART)\n",
+           (unsigned long long) down_wire, sent, s, s > 0 ? down_timed / s : 0.0, baud,
+           s > 0 ? 100.0 * down_timed / s / (baud / 10.0) : 0.0);
+}
+
+static void bench_up(uint32_t bytes) {
+    uint8_t fill[LINKTEST_FRAME_BYTES - FRAME_OVERHEAD - 2];
+    uint8_t reply[12];
+    uint32_t frames = (bytes + LINKTEST_FRAME_BYTES - 1) / LINKTEST_FRAME_BYTES;
+
+    /* restart the count */
+    send_frame(PROTO_LINK_COUNT, NULL, 0);
+    if (wait_reply(PROTO_LINK_COUNT, reply, sizeof(reply), REPLY_TIMEOUT_MS) < 0) {
+        printf("up: no count reply\n");
+        return;
+    }
+
+    memset(fill, 0x55, sizeof(fill));
+    for (uint32_t i = 0; i < frames; i++) send_frame(PROTO_LINK_FILL, fill, sizeof(fill));
+
+    /* the count goes behind the filler, so it comes back once all of it has been through */
+    send_frame(PROTO_LINK_COUNT, NULL, 0);
+    int timeout = REPLY_TIMEOUT_MS + (int) (bytes / 960 * 1000);
+    if (wait_reply(PROTO_LINK_COUNT, reply, sizeof(reply), timeout) < 0) {
+        printf("up: no count reply\n");
+        return;
+    }
+
+    uint32_t got = le_get_u32(reply), us = le_get_u32(&reply[4]), baud = le_get_u32(&reply[8]);
+    double s = us / 1e6;
+    printf("up: %u of %u bytes in %.2f s, %.0f B/s (baud %u, %.0f%% of the UART)\n",
+           got, frames * LINKTEST_FRAME_BYTES, s, s > 0 ? got / s : 0.0, baud,
+           s > 0 ? 100.0 * got / s / (baud / 10.0) : 0.0);
+}
+
+int main(int argc, char** argv) {
+    uint32_t pings = 200, down = 32768, up = 32768;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <pty> [--pings n] [--down bytes] [--up bytes]\n", argv[0]);
+        return 2;
+    }
+    for (int i = 2; i + 1 < argc; i += 2) {
+        uint32_t v = (uint32_t) strtoul(argv[i + 1], NULL, 0);
+        if (strcmp(argv[i], "--pings") == 0) pings = v;
+        else if (strcmp(argv[i], "--down") == 0) down = v;
+        else if (strcmp(argv[i], "--up") == 0) up = v;
+    }
+
+    fd = open(argv[1], O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    /* raw: no line discipline between us and the frames */
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        tio.c_iflag &= ~(tcflag_t) (IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+        tio.c_oflag &= ~(tcflag_t) OPOST;
+        tio.c_lflag &= ~(tcflag_t) (ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+        tio.c_cflag &= ~(tcflag_t) (CSIZE | PARENB);
+        tio.c_cflag |= CS8;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    if (!wait_link()) {
+        printf("link didn't come up\n");
+        return 1;
+    }
+    if (pings > 0) bench_rtt(pings);
+    if (down > 0) bench_down(down);
+    if (up > 0) bench_up(up);
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * pass_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+/* pass_plan.c over a few LEO passes culminating closer and closer to the zenith: peak azimuth and
+ * elevation rates tracking the target directly against following the plan, for the mount's limits
+ * (mount.h) and for one that can go over the top. Also how many pass_plan_step()s each plan took,
+ * which is what the main loop has to find time for.
+ *
+ * The passes are a circular orbit over a non-rotating Earth, which is plenty to get the geometry
+ * of a keyhole right.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "mount.h"
+#include "pass_plan.h"
+
+#define PI 3.14159265358979
+#define DEG (180.0 / PI)
+
+#define EARTH_KM    6371.0
+#define ALT_KM      420.0               /* about the ISS */
+#define MU          398600.4418         /* km^3/s^2 */
+
+typedef struct {
+    double gamma;       /* earth central angle from the site to the ground track */
+    double rate;        /* orbital angular rate, rad/min */
+} pass_t;
+
+/* Target az/el at tsince minutes from culmination. Site at the pole of the frame, orbit through
+ * (sin gamma, 0, cos gamma) heading +y. */
+static bool sample(void* ctx, float tsince, float* az, float* el) {
+    const pass_t* p = ctx;
+    double r = EARTH_KM + ALT_KM;
+    double a = p->rate * tsince;
+
+    double x = r * cos(a) * sin(p->gamma);
+    double y = r * sin(a);
+    double z = r * cos(a) * cos(p->gamma) - EARTH_KM;
+    double range = sqrt(x * x + y * y + z * z);
+
+    /* north along +x, east along +y */
+    *el = (float) asin(z / range);
+    *az = (float) atan2(y, x);
+    if (*az < 0) *az += (float) (2 * PI);
+    return true;
+}
+
+/* The central angle that gives a pass culminating at el */
+static double gamma_for(double el) {
+    double r = EARTH_KM + ALT_KM;
+    return acos(EARTH_KM / r * cos(el)) - el;
+}
+
+/* Peak rates tracking the target directly, at the planner's sampling interval */
+static void raw_rates(pass_t* p, const pass_plan_t* plan, double* az_rate, double* el_rate) {
+    float az0, el0, az1, el1;
+    double dt = PASS_PLAN_STEP_S / 60.0;
+
+    *az_rate = *el_rate = 0;
+    sample(p, plan->aos, &az0, &el0);
+    for (float t = plan->aos; t < plan->los; t += (float) dt) {
+        sample(p, (float) (t + dt), &az1, &el1);
+        double daz = fabs(az1 - az0);
+        if (daz > PI) daz = 2 * PI - daz;
+        if (daz / PASS_PLAN_STEP_S > *az_rate) *az_rate = daz / PASS_PLAN_STEP_S;
+        if (fabs(el1 - el0) / PASS_PLAN_STEP_S > *el_rate) *el_rate = fabs(el1 - el0) / PASS_PLAN_STEP_S;
+        az0 = az1;
+        el0 = el1;
+    }
+}
+
+static void run(double max_el_deg, float mount_max_el) {
+    static const char* modes[] = { "none", "flip", "over the top" };
+    pass_t p;
+    pass_plan_t plan;
+
+    p.gamma = gamma_for(max_el_deg / DEG);
+    p.rate = sqrt(MU / pow(EARTH_KM + ALT_KM, 3)) * 60.0;
+
+    pass_plan_start(-15.0f, 30.0f, MOUNT_MAX_AZ_RATE, mount_max_el);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    uint32_t steps = 1;
+    while (!pass_plan_step(&plan, sample, &p)) steps++;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) * 1e-6;
+
+    if (!plan.valid) {
+        printf("%5.1f  no pass found\n", max_el_deg);
+        return;
+    }
+
+    double raw_az, raw_el;
+    raw_rates(&p, &plan, &raw_az, &raw_el);
+
+    printf("%5.1f  %6.2f %5.2f   %6.2f %5.2f   %-12s %6.3f   %4.0f s  %5u  %5.2f\n", max_el_deg,
+           raw_az * DEG, raw_el * DEG, plan.peak_az_rate * DEG, plan.peak_el_rate * DEG,
+           modes[plan.mode], plan.peak_error * DEG,
+           (plan.mode == PASS_PLAN_NONE ? 0 : (plan.win_end - plan.win_start) * 60.0), steps, ms);
+}
+
+static void table(const char* title, float mount_max_el) {
+    static const double culminations[] = { 45.0, 70.0, 80.0, 85.0, 88.0, 89.0, 89.7 };
+
+    printf("%s (azimuth limit %.1f deg/s, elevation limit %.0f deg)\n", title,
+           MOUNT_MAX_AZ_RATE * DEG, mount_max_el * DEG);
+    printf("  max  raw deg/s      planned deg/s  mode         error    window  steps  host ms\n"
+           "   el     az    el       az    el                  deg\n");
+    for (uint32_t i = 0; i < sizeof(culminations) / sizeof(culminations[0]); i++) {
+        run(culminations[i], mount_max_el);
+    }
+    printf("\n");
+}
+
+int main(void) {
+    table("this mount", MOUNT_MAX_EL);
+    table("with elevation past the zenith", (float) PI);
+    return 0;
+}
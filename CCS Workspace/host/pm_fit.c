@@ -0,0 +1,308 @@
+/*
+ * pm_fit.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+/* Least squares fit of the pointing model terms (pointing_model.h) to sightings, for upload.
+ *
+ *   pm_fit sightings.txt
+ *   pm_fit test
+ *
+ * A sighting is a star or satellite centred by hand: one line of target az, target el, then the
+ * mount's az, el where it was actually centred, all in degrees ('#' starts a comment). The model
+ * is mount = target + correction, so each sighting gives the correction at its target position,
+ * and the terms are linear in that. Azimuth residuals are weighted by cos(el), which makes both
+ * axes arcseconds on the sky.
+ *
+ * TF and ECEC are the same function of elevation on an alt-az mount, so sightings can only ever
+ * tell their sum; it all goes in TF and ECEC stays 0. Prints the terms in arcsec, the residuals
+ * before and after, and the POINTING_MODEL payload as an autopoint --at argument.
+ *
+ * "test" makes up sightings from known terms with the firmware's own pointing_model_apply(), with
+ * and without noise, and checks the fit gets them back.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pointing_model.h"
+#include "protocol.h"
+#include "storage.h"
+
+#define CHECK(c) do { if (!(c)) { printf("%s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+#define PI 3.14159265358979
+#define DEG2RAD (PI / 180.0)
+#define RAD2ARCSEC (180.0 / PI * 3600.0)
+
+#define MAX_SIGHTINGS 1024
+
+/* Below this the azimuth weight (and what a sighting says about azimuth) is next to nothing, and
+ * sec / tan are running away; the firmware clamps there too */
+#define MIN_COS_EL 0.01
+
+typedef struct {
+    double az, el;          /* target, radians */
+    double d_az, d_el;      /* mount - target, radians */
+} sighting_t;
+
+static const char* term_names[PM_TERM_COUNT] = {
+    "IA", "IE", "NPAE", "CA", "AN", "AW", "TF", "ACEC", "ACES", "ECEC", "ECES",
+};
+
+/* pointing_model.c is linked in to make the test sightings the way the firmware applies the
+ * model. It never gets to flash here. */
+const void* storage_get(storage_slot_t slot, uint32_t len) {
+    (void) slot;
+    (void) len;
+    return NULL;
+}
+
+bool storage_writable(void) {
+    return true;
+}
+
+bool storage_save(storage_slot_t slot, const void* data, uint32_t len) {
+    (void) slot;
+    (void) data;
+    (void) len;
+    return true;
+}
+
+/* Partial derivatives of the az and el corrections with respect to each term at (az, el), the
+ * rows of the design matrix. Mirrors pointing_model_apply(). */
+static void partials(double az, double el, double p_az[PM_TERM_COUNT], double p_el[PM_TERM_COUNT]) {
+    double sa = sin(az), ca = cos(az), se = sin(el), ce = cos(el);
+    if (ce < MIN_COS_EL) ce = MIN_COS_EL;
+    double sec = 1.0 / ce, tan = se * sec;
+
+    memset(p_az, 0, PM_TERM_COUNT * sizeof(double));
+    memset(p_el, 0, PM_TERM_COUNT * sizeof(double));
+
+    p_az[PM_IA] = -1.0;
+    p_az[PM_CA] = -sec;
+    p_az[PM_NPAE] = -tan;
+    p_az[PM_AN] = -sa * tan;
+    p_az[PM_AW] = -ca * tan;
+    p_az[PM_ACEC] = ca;
+    p_az[PM_ACES] = sa;
+
+    p_el[PM_IE] = 1.0;
+    p_el[PM_AN] = -ca;
+    p_el[PM_AW] = sa;
+    p_el[PM_TF] = ce;
+    p_el[PM_ECEC] = ce;
+    p_el[PM_ECES] = se;
+}
+
+/* On-sky rms of the residuals left by terms (radians) */
+static double residual_rms(const sighting_t* s, uint32_t n, const double terms[PM_TERM_COUNT]) {
+    double sum = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        double p_az[PM_TERM_COUNT], p_el[PM_TERM_COUNT];
+        double r_az = s[i].d_az, r_el = s[i].d_el;
+
+        partials(s[i].az, s[i].el, p_az, p_el);
+        for (uint32_t k = 0; k < PM_TERM_COUNT; k++) {
+            r_az -= p_az[k] * terms[k];
+            r_el -= p_el[k] * terms[k];
+        }
+        r_az *= cos(s[i].el);
+        sum += r_az * r_az + r_el * r_el;
+    }
+    return n ? sqrt(sum / n) : 0.0;
+}
+
+/* Fit terms (radians) to n sightings through the normal equations. Returns false if the sightings
+ * don't pin the terms down (too few, or all in one part of the sky). */
+static bool fit(const sighting_t* s, uint32_t n, double terms[PM_TERM_COUNT]) {
+    enum { N = PM_TERM_COUNT };
+    double a[N][N + 1];
+
+    memset(a, 0, sizeof(a));
+    for (uint32_t i = 0; i < n; i++) {
+        double p_az[N], p_el[N];
+        double w = cos(s[i].el);
+
+        partials(s[i].az, s[i].el, p_az, p_el);
+        for (uint32_t j = 0; j < N; j++) p_az[j] *= w;
+
+        for (uint32_t j = 0; j < N; j++) {
+            for (uint32_t k = 0; k < N; k++) a[j][k] += p_az[j] * p_az[k] + p_el[j] * p_el[k];
+            a[j][N] += p_az[j] * s[i].d_az * w + p_el[j] * s[i].d_el;
+        }
+    }
+
+    /* ECEC is TF again: pin it to 0 */
+    for (uint32_t k = 0; k <= N; k++) a[PM_ECEC][k] = 0.0;
+    for (uint32_t j = 0; j < N; j++) a[j][PM_ECEC] = 0.0;
+    a[PM_ECEC][PM_ECEC] = 1.0;
+
+    /* Gaussian elimination with partial pivoting. A pivot that small next to the diagonal it
+     * started from is a term the sightings can't separate from the others. */
+    double scale = 0.0;
+    for (uint32_t j = 0; j < N; j++) if (a[j][j] > scale) scale = a[j][j];
+
+    for (uint32_t c = 0; c < N; c++) {
+        uint32_t best = c;
+        for (uint32_t r = c + 1; r < N; r++) if (fabs(a[r][c]) > fabs(a[best][c])) best = r;
+        if (fabs(a[best][c]) < 1e-9 * scale) return false;
+
+        if (best != c) {
+            for (uint32_t k = 0; k <= N; k++) {
+                double t = a[c][k];
+                a[c][k] = a[best][k];
+                a[best][k] = t;
+            }
+        }
+        for (uint32_t r = c + 1; r < N; r++) {
+            double f = a[r][c] / a[c][c];
+            for (uint32_t k = c; k <= N; k++) a[r][k] -= f * a[c][k];
+        }
+    }
+
+    for (int32_t c = N - 1; c >= 0; c--) {
+        double v = a[c][N];
+        for (uint32_t k = c + 1; k < N; k++) v -= a[c][k] * terms[k];
+        terms[c] = v / a[c][c];
+    }
+    return true;
+}
+
+static uint32_t load(const char* path, sighting_t* s) {
+    FILE* f = fopen(path, "r");
+    char line[256];
+    uint32_t n = 0;
+
+    if (f == NULL) {
+        perror(path);
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f) && n < MAX_SIGHTINGS) {
+        double taz, tel, maz, mel;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        if (sscanf(line, "%lf %lf %lf %lf", &taz, &tel, &maz, &mel) != 4) continue;
+
+        double d_az = fmod(maz - taz + 540.0, 360.0) - 180.0;
+        s[n].az = taz * DEG2RAD;
+        s[n].el = tel * DEG2RAD;
+        s[n].d_az = d_az * DEG2RAD;
+        s[n].d_el = (mel - tel) * DEG2RAD;
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+/* Little-endian float arcsec, as handle_pointing_model() takes them */
+static void print_payload(const double terms[PM_TERM_COUNT]) {
+    printf("--at 1:%02x:", PROTO_POINTING_MODEL);
+    for (uint32_t k = 0; k < PM_TERM_COUNT; k++) {
+        float v = (float) (terms[k] * RAD2ARCSEC);
+        uint32_t u;
+        memcpy(&u, &v, 4);
+        printf("%02x%02x%02x%02x", u & 0xFF, (u >> 8) & 0xFF, (u >> 16) & 0xFF, u >> 24);
+    }
+    printf("\n");
+}
+
+/* Uniform in [-1, 1), repeatable */
+static double noise(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (*state >> 8) / (double) (1u << 23) - 1.0;
+}
+
+/* Sightings at n spots over the sky through the firmware's model, plus up to noise_as each way */
+static void synthesize(sighting_t* s, uint32_t n, const double known[PM_TERM_COUNT], double noise_as) {
+    float terms[PM_TERM_COUNT];
+    uint32_t rng = 12345;
+
+    for (uint32_t k = 0; k < PM_TERM_COUNT; k++) terms[k] = (float) known[k];
+    pointing_model_set(terms);
+
+    for (uint32_t i = 0; i < n; i++) {
+        /* golden angle round in azimuth, 10 to 80 degrees up */
+        double az = fmod(i * 137.508, 360.0) * DEG2RAD;
+        double el = (10.0 + 70.0 * (i + 0.5) / n) * DEG2RAD;
+        float d_az, d_el;
+
+        pointing_model_apply((float) sin(az), (float) cos(az), (float) sin(el), (float) cos(el), &d_az, &d_el);
+        s[i].az = az;
+        s[i].el = el;
+        s[i].d_az = d_az + noise(&rng) * noise_as / RAD2ARCSEC / cos(el);
+        s[i].d_el = d_el + noise(&rng) * noise_as / RAD2ARCSEC;
+    }
+}
+
+static void test(void) {
+    static sighting_t s[MAX_SIGHTINGS];
+    double known[PM_TERM_COUNT] = { 0 };
+    double got[PM_TERM_COUNT];
+
+    /* arcsec, the size a rough backyard mount might have; ECEC left at 0 as the fit has to */
+    const double as[PM_TERM_COUNT] = { 120, -45, 30, -60, 25, -15, 40, 10, -8, 0, 12 };
+    for (uint32_t k = 0; k < PM_TERM_COUNT; k++) known[k] = as[k] / RAD2ARCSEC;
+
+    /* exact sightings: back to float precision */
+    synthesize(s, 40, known, 0.0);
+    CHECK(fit(s, 40, got));
+    for (uint32_t k = 0; k < PM_TERM_COUNT; k++) CHECK(fabs(got[k] - known[k]) * RAD2ARCSEC < 0.05);
+    CHECK(residual_rms(s, 40, got) * RAD2ARCSEC < 0.05);
+
+    /* up to 5 arcsec of hand centering error. IA, CA and NPAE only differ in how they go with
+     * elevation, so they trade off against each other by a few arcsec. */
+    synthesize(s, 200, known, 5.0);
+    CHECK(fit(s, 200, got));
+    for (uint32_t k = 0; k < PM_TERM_COUNT; k++) CHECK(fabs(got[k] - known[k]) * RAD2ARCSEC < 5.0);
+    CHECK(residual_rms(s, 200, got) * RAD2ARCSEC < 5.0);
+
+    /* ECEC goes to TF */
+    known[PM_ECEC] = 20 / RAD2ARCSEC;
+    synthesize(s, 40, known, 0.0);
+    CHECK(fit(s, 40, got));
+    CHECK(got[PM_ECEC] == 0.0);
+    CHECK(fabs(got[PM_TF] - (known[PM_TF] + known[PM_ECEC])) * RAD2ARCSEC < 0.05);
+
+    /* not enough to go on */
+    CHECK(!fit(s, 3, got));
+    for (uint32_t i = 0; i < 40; i++) s[i].az = 0.5;
+    CHECK(!fit(s, 40, got));
+
+    printf("pm_fit ok\n");
+}
+
+int main(int argc, char** argv) {
+    static sighting_t s[MAX_SIGHTINGS];
+    double zero[PM_TERM_COUNT] = { 0 };
+    double terms[PM_TERM_COUNT];
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s sightings.txt | test\n", argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "test") == 0) {
+        test();
+        return 0;
+    }
+
+    uint32_t n = load(argv[1], s);
+    if (!fit(s, n, terms)) {
+        fprintf(stderr, "%u sightings aren't enough to fit %u terms; spread them over the sky\n",
+                n, PM_TERM_COUNT - 1);
+        return 1;
+    }
+
+    for (uint32_t k = 0; k < PM_TERM_COUNT; k++) printf("%-5s %9.1f arcsec\n", term_names[k], terms[k] * RAD2ARCSEC);
+    printf("%u sightings, rms %.1f arcsec before, %.1f after\n", n,
+           residual_rms(s, n, zero) * RAD2ARCSEC, residual_rms(s, n, terms) * RAD2ARCSEC);
+    print_payload(terms);
+    return 0;
+}
@@ -0,0 +1,184 @@
+/*
+ * ring_test.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+/* Host checks for ring.h: edge cases, a two thread stress test that checks every byte comes
+ * out in order, and (with "bench") throughput numbers.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ring.h"
+
+#define CHECK(c) do { if (!(c)) { printf("%s:%d: %s\n", __FILE__, __LINE__, #c); exit(1); } } while (0)
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void test_edges(void) {
+    uint8_t buf[16];
+    uint8_t out[16];
+    ring_t r;
+
+    CHECK(!ring_init(&r, buf, 0));
+    CHECK(!ring_init(&r, buf, 12));
+    CHECK(ring_init(&r, buf, 16));
+
+    /* all of it is usable, and a write that doesn't fit writes nothing */
+    CHECK(ring_write(&r, "0123456789abcdef", 16));
+    CHECK(ring_free(&r) == 0);
+    CHECK(!ring_write(&r, "x", 1));
+    CHECK(r.overflows == 1);
+    CHECK(r.high_water == 16);
+
+    CHECK(ring_read(&r, out, 10) == 10);
+    CHECK(memcmp(out, "0123456789", 10) == 0);
+
+    /* wraps round the end of the buffer: two spans */
+    CHECK(ring_write(&r, "ABCDEFGH", 8));
+    const uint8_t* span;
+    CHECK(ring_read_span(&r, &span) == 6);
+    CHECK(memcmp(span, "abcdef", 6) == 0);
+    CHECK(ring_read(&r, out, sizeof(out)) == 14);
+    CHECK(memcmp(out, "abcdefABCDEFGH", 14) == 0);
+    CHECK(ring_used(&r) == 0);
+
+    /* indices wrap at 2^32 */
+    r.head = r.tail = 0xFFFFFFFA;
+    CHECK(ring_write(&r, "0123456789", 10));
+    CHECK(ring_used(&r) == 10);
+    CHECK(ring_read(&r, out, sizeof(out)) == 10);
+    CHECK(memcmp(out, "0123456789", 10) == 0);
+
+    /* write in place */
+    uint8_t* w;
+    uint32_t n = ring_write_span(&r, &w);
+    CHECK(n > 0 && n <= 16);
+    memset(w, 'z', n);
+    ring_commit(&r, n);
+    CHECK(ring_used(&r) == n);
+
+    printf("edges ok\n");
+}
+
+#define STRESS_SIZE 1024
+#define STRESS_BYTES (64u << 20)
+
+static uint8_t stress_buf[STRESS_SIZE];
+static ring_t stress;
+
+/* The stream is a counting pattern with a prime period, so it never lines up with the buffer */
+static uint8_t pattern(uint32_t i) {
+    return (uint8_t) (i % 251);
+}
+
+static void* producer(void* arg) {
+    uint8_t chunk[300];
+    uint32_t sent = 0;
+    uint32_t seed = 1;
+    (void) arg;
+
+    while (sent < STRESS_BYTES) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t len = 1 + (seed >> 16) % sizeof(chunk);
+        if (len > STRESS_BYTES - sent) len = STRESS_BYTES - sent;
+
+        for (uint32_t i = 0; i < len; i++) chunk[i] = pattern(sent + i);
+        while (!ring_write(&stress, chunk, len)) sched_yield();
+        sent += len;
+    }
+    return NULL;
+}
+
+static void* consumer(void* arg) {
+    uint8_t chunk[200];
+    uint32_t got = 0;
+    bool spans = false;
+    (void) arg;
+
+    while (got < STRESS_BYTES) {
+        const uint8_t* data;
+        uint32_t n;
+
+        /* alternate between copying out and reading in place, like the DMA does */
+        if (spans) {
+            n = ring_read_span(&stress, &data);
+        } else {
+            n = ring_read(&stress, chunk, sizeof(chunk));
+            data = chunk;
+        }
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+
+        for (uint32_t i = 0; i < n; i++) {
+            if (data[i] != pattern(got + i)) {
+                printf("stress: byte %u is %u, expected %u\n", got + i, data[i], pattern(got + i));
+                exit(1);
+            }
+        }
+        if (spans) ring_consume(&stress, n);
+        got += n;
+        spans = !spans;
+    }
+    return NULL;
+}
+
+static void test_stress(void) {
+    pthread_t p, c;
+
+    CHECK(ring_init(&stress, stress_buf, STRESS_SIZE));
+
+    double t0 = now_s();
+    pthread_create(&c, NULL, consumer, NULL);
+    pthread_create(&p, NULL, producer, NULL);
+    pthread_join(p, NULL);
+    pthread_join(c, NULL);
+    double dt = now_s() - t0;
+
+    CHECK(ring_used(&stress) == 0);
+    printf("stress ok: %u MB across threads in %.2f s (%.0f MB/s), high water %u, %u full\n",
+           STRESS_BYTES >> 20, dt, (STRESS_BYTES >> 20) / dt, stress.high_water, stress.overflows);
+}
+
+/* Single thread write then read, for the cost of the ring itself at a few frame sizes */
+static void bench(void) {
+    static uint8_t buf[1024];
+    uint8_t block[256];
+    ring_t r;
+
+    memset(block, 0x55, sizeof(block));
+
+    for (uint32_t len = 16; len <= sizeof(block); len *= 4) {
+        uint64_t total = 256u << 20;
+        ring_init(&r, buf, sizeof(buf));
+
+        double t0 = now_s();
+        for (uint64_t moved = 0; moved < total; moved += len) {
+            ring_write(&r, block, len);
+            ring_read(&r, block, len);
+        }
+        double dt = now_s() - t0;
+        printf("bench: %3u byte blocks, %.0f MB/s, %.1f ns per write + read\n",
+               len, (total >> 20) / dt, dt * 1e9 / (total / len));
+    }
+}
+
+int main(int argc, char** argv) {
+    test_edges();
+    test_stress();
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) bench();
+    return 0;
+}
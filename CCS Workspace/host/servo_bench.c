@@ -0,0 +1,135 @@
+/*
+ * servo_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+/* mount_control.c's PID, with mount_default_gains, against its own plant: a step response (rise
+ * time, overshoot, settling time) and tracking error on a ramp at LEO rates. Runs the loop the way
+ * mount.c does, at SETPOINT_RATE_HZ off a quantized encoder, with the plant stepped finer in
+ * between. Numbers are only as good as the plant below, which is a guess at the mount until it's
+ * measured.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "mount.h"
+#include "mount_control.h"
+#include "setpoint.h"
+
+#define PI 3.14159265358979
+#define RAD_TO_ARCSEC (180.0 / PI * 3600.0)
+
+#define DT (1.0f / SETPOINT_RATE_HZ)
+#define PLANT_SUBSTEPS 10
+#define RAD_PER_COUNT (2.0 * PI / MOUNT_AZ_COUNTS_PER_REV)
+
+/* Full duty runs the axis at 0.5 rad/s, the feed-forward gain's 2 duty per rad/s, with a 50 ms
+ * mechanical time constant (inertia * no load rate / stall torque) and 2% of stall in friction */
+static const mount_plant_t default_plant = {
+    .inertia = 0.2f,
+    .stall_torque = 2.0f,
+    .no_load_rate = 0.5f,
+    .friction = 0.04f,
+};
+
+#define STEP_RAD        (1.0 * PI / 180.0)
+#define STEP_SECONDS    3.0
+#define SETTLE_BAND     0.02    /* of the step */
+
+/* ISS straight overhead is about 1.1 deg/s at culmination; lower passes are slower */
+#define RAMP_DEG_S      1.1
+#define RAMP_SECONDS    60.0
+#define RAMP_SETTLE_S   1.0     /* acquisition, reported on its own */
+
+typedef struct {
+    mount_pid_t pid;
+    mount_plant_t plant;
+} axis_t;
+
+static void axis_init(axis_t* a) {
+    mount_pid_init(&a->pid, &mount_default_gains);
+    a->plant = default_plant;
+}
+
+/* One setpoint tick: read the encoder, run the controller, drive the plant until the next tick.
+ * Returns the true (unquantized) error after the tick. */
+static double axis_tick(axis_t* a, double sp, double sp_rate) {
+    double counts = trunc(a->plant.pos / RAD_PER_COUNT);
+    float err = (float) (sp - counts * RAD_PER_COUNT);
+    float duty = mount_pid_update(&a->pid, err, (float) sp_rate, DT);
+
+    for (int i = 0; i < PLANT_SUBSTEPS; i++) mount_plant_step(&a->plant, duty, DT / PLANT_SUBSTEPS);
+    return sp_rate * DT + sp - a->plant.pos;
+}
+
+static void step_response(void) {
+    axis_t a;
+    axis_init(&a);
+
+    uint32_t ticks = (uint32_t) (STEP_SECONDS * SETPOINT_RATE_HZ);
+    double t10 = -1, t90 = -1, settled = 0, peak = 0;
+
+    for (uint32_t i = 0; i < ticks; i++) {
+        double t = (i + 1) * (double) DT;
+        axis_tick(&a, STEP_RAD, 0.0);
+        double pos = a.plant.pos;
+
+        if (t10 < 0 && pos >= 0.1 * STEP_RAD) t10 = t;
+        if (t90 < 0 && pos >= 0.9 * STEP_RAD) t90 = t;
+        if (pos > peak) peak = pos;
+        if (fabs(pos - STEP_RAD) > SETTLE_BAND * STEP_RAD) settled = t;
+    }
+
+    printf("step %.1f deg: ", STEP_RAD * 180.0 / PI);
+    if (t90 < 0) {
+        printf("never reached 90%% in %.0f s\n", STEP_SECONDS);
+        return;
+    }
+    printf("rise %.0f ms (10-90%%), overshoot %.1f%%, ", (t90 - t10) * 1e3,
+           peak > STEP_RAD ? (peak - STEP_RAD) / STEP_RAD * 100.0 : 0.0);
+    if (settled >= STEP_SECONDS - DT) {
+        printf("not settled to %.0f%% in %.0f s\n", SETTLE_BAND * 100.0, STEP_SECONDS);
+    } else {
+        printf("settled to %.0f%% in %.0f ms\n", SETTLE_BAND * 100.0, settled * 1e3);
+    }
+}
+
+/* From rest, the setpoint moving off at a constant rate */
+static void ramp(double deg_s) {
+    axis_t a;
+    axis_init(&a);
+
+    double rate = deg_s * PI / 180.0;
+    uint32_t ticks = (uint32_t) (RAMP_SECONDS * SETPOINT_RATE_HZ);
+    uint32_t settle = (uint32_t) (RAMP_SETTLE_S * SETPOINT_RATE_HZ);
+    double acq_max = 0, max = 0, sum_sq = 0;
+
+    for (uint32_t i = 0; i < ticks; i++) {
+        double err = fabs(axis_tick(&a, i * rate * DT, rate));
+        if (i < settle) {
+            if (err > acq_max) acq_max = err;
+        } else {
+            sum_sq += err * err;
+            if (err > max) max = err;
+        }
+    }
+
+    printf("ramp %.1f deg/s: tracking error rms %.1f, max %.1f arcsec (%.0f s on); "
+           "max %.1f arcsec in the first %.0f s\n", deg_s,
+           sqrt(sum_sq / (ticks - settle)) * RAD_TO_ARCSEC, max * RAD_TO_ARCSEC, RAMP_SETTLE_S,
+           acq_max * RAD_TO_ARCSEC, RAMP_SETTLE_S);
+}
+
+int main(void) {
+    const mount_pid_gains_t* g = &mount_default_gains;
+
+    printf("gains: kp %g ki %g kd %g kff %g, at %u Hz; encoder %.1f arcsec/count\n",
+           g->kp, g->ki, g->kd, g->kff, SETPOINT_RATE_HZ, RAD_PER_COUNT * RAD_TO_ARCSEC);
+    step_response();
+    ramp(RAMP_DEG_S);
+    ramp(RAMP_DEG_S / 4);
+    return 0;
+}
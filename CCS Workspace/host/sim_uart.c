@@ -0,0 +1,485 @@
+/*
+ * sim_uart.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "hal.h"
+#include "util.h"
+#include "frame.h"
+#include "bluetooth.h"
+#include "bluetooth_uart.h"
+
+#include "sim_uart.h"
+
+#define MS_CYCLES(ms)       ((uint64_t) ((double) (ms) * (UTIL_CLOCK_HZ / 1000)))
+#define US_CYCLES(us)       ((uint64_t) (us) * (UTIL_CLOCK_HZ / 1000000))
+
+/* The module only takes "$$$" in its first minute, with the line quiet for a moment before it */
+#define CMD_WINDOW_MS       60000
+#define CMD_GUARD_MS        10
+
+#define PACKET_QUEUE        512
+#define TO_MCU_SIZE         65536
+
+typedef struct {
+    uint8_t data[SIM_RADIO_PACKET];
+    uint32_t len;
+    uint64_t due;
+} packet_t;
+
+/* Radio packets in flight one way, delivered in order */
+typedef struct {
+    packet_t q[PACKET_QUEUE];
+    uint32_t head, tail;
+    uint64_t last_due;
+} radio_t;
+
+typedef enum {
+    MOD_OFF = 0,
+    MOD_BOOT,
+    MOD_DATA,
+    MOD_CMD
+} mod_state_t;
+
+typedef struct {
+    char key;
+    char value[40];
+} setting_t;
+
+static sim_link_t model;
+static sim_link_stats_t stats;
+static uint32_t rng;
+
+static int master = -1;
+static int slave = -1;
+static char pty_path[64];
+
+/* Firmware side of the UART */
+static uint32_t mcu_baud = BLUETOOTH_BAUD_BOOT;
+static uint64_t tx_next = 0;        /* when the byte on the wire finishes */
+static bool tx_idle = true;
+static uint32_t rx_written = 0;
+static uint32_t rx_released = 0;
+static uint64_t rx_next = 0;
+static bool rx_idle = true;
+
+/* The module */
+static mod_state_t mod_state = MOD_OFF;
+static bool pin_reset = true;
+static uint32_t mod_baud = BLUETOOTH_BAUD_BOOT;
+static uint32_t mod_pending_baud = 0;
+static uint64_t mod_boot_at = 0;
+static uint64_t mod_last_rx = 0;
+static uint32_t mod_dollars = 0;
+static char mod_line[64];
+static uint32_t mod_line_len = 0;
+
+/* Factory settings, or rn42.c's if model.configured */
+static setting_t settings[] = {
+    { 'P', "1234" },
+    { 'Y', "0010" },
+    { '~', "0" },
+    { 'N', "RN42-5A3C" },
+    { 'E', "0000110100001000800000805F9B34FB" },
+};
+#define SETTING_COUNT (sizeof(settings) / sizeof(settings[0]))
+
+/* Module to firmware, paced at the module's baud */
+static uint8_t to_mcu[TO_MCU_SIZE];
+static uint32_t to_mcu_head = 0, to_mcu_tail = 0;
+
+/* Radio packet being built from UART bytes, and the radio each way */
+static packet_t up_build;
+static uint64_t up_last = 0;
+static radio_t up, down;
+
+static uint32_t next_rand(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static float uniform(void) {
+    return (next_rand() >> 8) * (1.0f / 16777216.0f);
+}
+
+static uint32_t char_cycles(uint32_t baud) {
+    return 10 * (UTIL_CLOCK_HZ / baud);
+}
+
+static void mod_say(const char* s) {
+    while (*s) {
+        to_mcu[to_mcu_head++ % TO_MCU_SIZE] = (uint8_t) *s++;
+    }
+}
+
+/* Corrupt a packet on the radio, true if it's lost altogether */
+static bool radio_damage(packet_t* p, uint64_t* flipped) {
+    if (model.drop > 0.0f && uniform() < model.drop) return true;
+
+    if (model.ber > 0.0f) {
+        for (uint32_t i = 0; i < p->len; i++) {
+            for (uint32_t b = 0; b < 8; b++) {
+                if (uniform() < model.ber) {
+                    p->data[i] ^= (uint8_t) (1 << b);
+                    (*flipped)++;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+static void radio_send(radio_t* r, const uint8_t* data, uint32_t len, uint64_t now) {
+    if (r->head - r->tail >= PACKET_QUEUE) return;
+
+    packet_t* p = &r->q[r->head % PACKET_QUEUE];
+    memcpy(p->data, data, len);
+    p->len = len;
+
+    /* in order, however the jitter falls */
+    uint64_t due = now + MS_CYCLES(model.latency_ms + model.jitter_ms * uniform());
+    if (due < r->last_due) due = r->last_due;
+    p->due = due;
+    r->last_due = due;
+    r->head++;
+}
+
+static void up_flush(uint64_t now) {
+    if (up_build.len == 0) return;
+    radio_send(&up, up_build.data, up_build.len, now);
+    up_build.len = 0;
+}
+
+/* A byte from the module's UART going out over the radio */
+static void mod_forward(uint8_t c, uint64_t now) {
+    up_build.data[up_build.len++] = c;
+    up_last = now;
+    if (up_build.len == SIM_RADIO_PACKET) up_flush(now);
+}
+
+static setting_t* find_setting(char key) {
+    for (uint32_t i = 0; i < SETTING_COUNT; i++) {
+        if (settings[i].key == key) return &settings[i];
+    }
+    return NULL;
+}
+
+static void mod_boot(uint64_t now) {
+    mod_state = MOD_BOOT;
+    mod_boot_at = now + MS_CYCLES(model.boot_ms);
+    mod_baud = BLUETOOTH_BAUD_BOOT;     /* strapped or stored, it's 9600 either way */
+    mod_pending_baud = 0;
+    mod_dollars = 0;
+    mod_line_len = 0;
+    stats.resets++;
+}
+
+static void mod_command(const char* line, uint64_t now) {
+    setting_t* s;
+
+    if (strcmp(line, "---") == 0) {
+        mod_say("END\r\n");
+        mod_state = MOD_DATA;
+    } else if (line[0] == 'G' && line[1] != 0 && line[2] == 0) {
+        s = find_setting(line[1]);
+        mod_say(s ? s->value : "?");
+        mod_say("\r\n");
+    } else if (line[0] == 'S' && line[1] != 0 && line[2] == ',') {
+        s = find_setting(line[1]);
+        if (s && strlen(&line[3]) < sizeof(s->value)) {
+            strcpy(s->value, &line[3]);
+            mod_say("AOK\r\n");
+        } else {
+            mod_say("ERR\r\n");
+        }
+    } else if (line[0] == 'U' && line[1] == ',') {
+        /* answers at the old baud, then switches and drops out of command mode */
+        uint32_t k = (uint32_t) strtoul(&line[2], NULL, 10);
+        mod_say("AOK\r\n");
+        mod_pending_baud = k == 115 ? 115200 : k * 1000;
+        mod_state = MOD_DATA;
+    } else if (strcmp(line, "R,1") == 0) {
+        mod_say("Reboot!\r\n");
+        mod_boot(now);
+    } else {
+        mod_say("?\r\n");
+    }
+}
+
+/* A byte into the module's UART */
+static void mod_receive(uint8_t c, uint64_t now) {
+    uint64_t quiet = now - mod_last_rx;
+    mod_last_rx = now;
+
+    if (mod_state == MOD_CMD) {
+        if (c == '\n') {
+            mod_line[mod_line_len] = 0;
+            if (mod_line_len > 0 && mod_line[mod_line_len - 1] == '\r') mod_line[mod_line_len - 1] = 0;
+            mod_line_len = 0;
+            mod_command(mod_line, now);
+        } else if (mod_line_len < sizeof(mod_line) - 1) {
+            mod_line[mod_line_len++] = (char) c;
+        }
+        return;
+    }
+
+    if (mod_state != MOD_DATA) return;
+
+    /* hold on to '$'s until we know whether they're "$$$" */
+    if (c == '$' && (mod_dollars > 0 || quiet >= MS_CYCLES(CMD_GUARD_MS))) {
+        if (++mod_dollars == 3) {
+            mod_dollars = 0;
+            if (now - mod_boot_at < MS_CYCLES(CMD_WINDOW_MS)) {
+                up_flush(now);
+                mod_state = MOD_CMD;
+                mod_line_len = 0;
+                mod_say("CMD\r\n");
+                return;
+            }
+            for (uint32_t i = 0; i < 3; i++) mod_forward('$', now);
+        }
+        return;
+    }
+    for (; mod_dollars > 0; mod_dollars--) mod_forward('$', now);
+    mod_forward(c, now);
+}
+
+/* Firmware TX: one character time per byte off the ring */
+static void poll_tx(uint64_t now) {
+    const uint8_t* run;
+    uint32_t cc = char_cycles(mcu_baud);
+
+    /* after the line has been idle, the next byte starts now; while it's busy, catch up */
+    if (tx_idle && tx_next + cc < now) tx_next = now - cc;
+
+    uint32_t avail = ring_read_span(&bluetooth_tx_ring, &run);
+    uint32_t sent = 0;
+
+    while (tx_next + cc <= now) {
+        if (sent == avail) {
+            if (sent > 0) bluetooth_tx_done(sent);
+            sent = 0;
+            avail = ring_read_span(&bluetooth_tx_ring, &run);
+            if (avail == 0) break;
+        }
+        uint8_t c = run[sent++];
+        tx_next += cc;
+
+        if (mod_state == MOD_OFF) continue;
+        if (mcu_baud != mod_baud) {
+            stats.garbled++;
+            c = (uint8_t) next_rand();
+        }
+        mod_receive(c, tx_next);
+    }
+    if (sent > 0) bluetooth_tx_done(sent);
+    tx_idle = ring_used(&bluetooth_tx_ring) == 0;
+}
+
+/* Like bluetooth_uart.c's DMA: each half of bluetooth_rx_buff takes more once the firmware has
+ * read past what was in it last time round */
+static bool rx_room(void) {
+    uint32_t half = rx_written / (BLUETOOTH_RX_BUFF_SIZE / 2);
+    return half < 2 || (int32_t) (rx_released - (half - 1) * (BLUETOOTH_RX_BUFF_SIZE / 2)) >= 0;
+}
+
+/* Module to firmware: one character time per byte into bluetooth_rx_buff. With no room the rest
+ * waits in the module, as it would with RTS held. */
+static void poll_rx(uint64_t now) {
+    uint32_t cc = char_cycles(mod_baud);
+
+    if (rx_idle && rx_next + cc < now) rx_next = now - cc;
+
+    while (to_mcu_tail != to_mcu_head && rx_next + cc <= now) {
+        if (!rx_room()) {
+            rx_next = now - cc;
+            break;
+        }
+        uint8_t c = to_mcu[to_mcu_tail++ % TO_MCU_SIZE];
+        rx_next += cc;
+
+        if (mcu_baud != mod_baud) {
+            stats.garbled++;
+            c = (uint8_t) next_rand();
+        }
+        bluetooth_rx_buff[rx_written % BLUETOOTH_RX_BUFF_SIZE] = c;
+        if (c == FRAME_DELIM) bluetooth_rx_stamp(rx_written, rx_next);
+        rx_written++;
+    }
+    rx_idle = to_mcu_tail == to_mcu_head;
+
+    /* a baud change takes once the answer has gone */
+    if (mod_pending_baud && to_mcu_tail == to_mcu_head) {
+        mod_baud = mod_pending_baud;
+        mod_pending_baud = 0;
+    }
+}
+
+static void poll_radio(uint64_t now) {
+    uint8_t buf[SIM_RADIO_PACKET];
+
+    if (up_build.len > 0 && now - up_last >= US_CYCLES(SIM_RADIO_FLUSH_US)) up_flush(now);
+
+    /* up: radio to the pty */
+    while (up.tail != up.head && up.q[up.tail % PACKET_QUEUE].due <= now) {
+        packet_t* p = &up.q[up.tail++ % PACKET_QUEUE];
+        stats.up_packets++;
+        if (radio_damage(p, &stats.up_flipped)) {
+            stats.up_dropped++;
+            continue;
+        }
+        ssize_t n = write(master, p->data, p->len);
+        if (n < 0) n = 0;
+        stats.up_bytes += (uint64_t) n;
+        stats.unread += p->len - (uint64_t) n;
+    }
+
+    /* down: pty to the radio, then the module's UART */
+    ssize_t n;
+    while ((n = read(master, buf, sizeof(buf))) > 0) radio_send(&down, buf, (uint32_t) n, now);
+
+    while (down.tail != down.head && down.q[down.tail % PACKET_QUEUE].due <= now) {
+        packet_t* p = &down.q[down.tail++ % PACKET_QUEUE];
+        stats.down_packets++;
+        if (radio_damage(p, &stats.down_flipped)) {
+            stats.down_dropped++;
+            continue;
+        }
+        stats.down_bytes += p->len;
+        if (mod_state == MOD_DATA) {
+            for (uint32_t i = 0; i < p->len; i++) to_mcu[to_mcu_head++ % TO_MCU_SIZE] = p->data[i];
+        }
+    }
+}
+
+void sim_uart_poll(void) {
+    uint64_t now = hal_cycles64();
+
+    if (mod_state == MOD_BOOT && now >= mod_boot_at) mod_state = MOD_DATA;
+
+    poll_tx(now);
+    poll_rx(now);
+    poll_radio(now);
+}
+
+void sim_uart_phone_send(const uint8_t* data, uint32_t len) {
+    uint64_t now = hal_cycles64();
+
+    while (len > 0) {
+        uint32_t n = len < SIM_RADIO_PACKET ? len : SIM_RADIO_PACKET;
+        radio_send(&down, data, n, now);
+        data += n;
+        len -= n;
+    }
+}
+
+const char* sim_uart_open(const sim_link_t* cfg) {
+    struct termios t;
+
+    model = *cfg;
+    rng = model.seed ? model.seed : 1;
+
+    if (model.configured) {
+        strcpy(find_setting('P')->value, "69420");
+        strcpy(find_setting('N')->value, "laser");
+    }
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) return NULL;
+
+    const char* name = ptsname(master);
+    if (name == NULL) return NULL;
+    snprintf(pty_path, sizeof(pty_path), "%s", name);
+
+    /* keep the far end open ourselves, so the pty stays up between clients; and raw, so bytes
+     * go through untouched */
+    slave = open(pty_path, O_RDWR | O_NOCTTY);
+    if (slave < 0 || tcgetattr(slave, &t) != 0) return NULL;
+    t.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+    t.c_oflag &= ~OPOST;
+    t.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    t.c_cflag &= ~(CSIZE | PARENB);
+    t.c_cflag |= CS8;
+    tcsetattr(slave, TCSANOW, &t);
+
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return pty_path;
+}
+
+bool sim_uart_module_ready(void) {
+    return mod_state == MOD_DATA;
+}
+
+void sim_uart_get_stats(sim_link_stats_t* out) {
+    *out = stats;
+}
+
+/* bluetooth_uart.h */
+
+void bluetooth_uart_init(uint32_t baud) {
+    mcu_baud = baud;
+    tx_next = rx_next = hal_cycles64();
+}
+
+uint32_t bluetooth_uart_rx_written(void) {
+    return rx_written;
+}
+
+void bluetooth_uart_rx_release(uint32_t read) {
+    rx_released = read;
+}
+
+void bluetooth_uart_tx_start(void) {
+    /* sim_uart_poll() drains the ring */
+}
+
+void bluetooth_uart_tx_discard(void) {
+    /* (in a replay the trace says what went) */
+    if (master < 0) return;
+
+    uint32_t queued = ring_used(&bluetooth_tx_ring);
+    if (queued != 0) bluetooth_tx_done(queued);
+    tx_idle = true;
+}
+
+uint32_t bluetooth_uart_tx_pending(void) {
+    return ring_used(&bluetooth_tx_ring);
+}
+
+void bluetooth_uart_set_baud(uint32_t baud) {
+    /* (not open: a replay, where the trace says when the ring drains) */
+    while (master >= 0 && ring_used(&bluetooth_tx_ring) != 0) sim_uart_poll();
+    mcu_baud = baud;
+}
+
+void bluetooth_uart_pin_reset(bool assert) {
+    uint64_t now = hal_cycles64();
+
+    if (assert) {
+        mod_state = MOD_OFF;
+    } else if (pin_reset) {
+        mod_boot(now);
+    }
+    pin_reset = assert;
+}
+
+/* The model's stored baud is BLUETOOTH_BAUD_BOOT as well, so the strap changes nothing */
+void bluetooth_uart_pin_force_baud(bool force) {
+    (void) force;
+}
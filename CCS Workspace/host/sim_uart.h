@@ -0,0 +1,61 @@
+/*
+ * sim_uart.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef SIM_UART_H_
+#define SIM_UART_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Host stand-in for bluetooth_uart.c: the firmware's UART1 and RN42, with a pty where the phone
+ * would be.
+ *
+ * Bytes cross the "UART" at the firmware's baud, one character time each, and only make sense to
+ * the module if both ends agree on the baud (a mismatch garbles them, like the real thing). The
+ * module model boots after ~RESET is released, answers the command mode the bring-up in rn42.c
+ * uses ($$$, G, S, U, ---), and keeps its settings across resets like its flash does.
+ *
+ * In data mode it packs UART bytes into radio packets (up to SIM_RADIO_PACKET bytes, or whatever
+ * has built up once the UART goes quiet) and the link model delivers them to the other end after
+ * latency + uniform jitter, in order, losing whole packets with probability drop and flipping each
+ * bit with probability ber. The same goes for the other way, from the pty.
+ *
+ * Everything runs from sim_uart_poll() in the main loop, so "interrupt" work happens between
+ * passes of the loop rather than in the middle of one.
+ */
+
+#define SIM_RADIO_PACKET    127
+#define SIM_RADIO_FLUSH_US  2000
+
+typedef struct {
+    float latency_ms;
+    float jitter_ms;
+    float drop;             /* per radio packet */
+    float ber;              /* per bit */
+    uint32_t boot_ms;       /* ~RESET released to the module listening */
+    bool configured;        /* module starts with rn42.c's settings, no rewrite and reboot */
+    uint32_t seed;
+} sim_link_t;
+
+typedef struct {
+    uint64_t up_bytes, up_packets, up_dropped, up_flipped;
+    uint64_t down_bytes, down_packets, down_dropped, down_flipped;
+    uint64_t garbled;       /* bytes lost to a baud mismatch */
+    uint64_t unread;        /* bytes for the pty nobody took */
+    uint32_t resets;
+} sim_link_stats_t;
+
+/* Returns the pty's path, NULL on failure */
+const char* sim_uart_open(const sim_link_t* link);
+void sim_uart_poll(void);
+
+/* Bytes from the phone's end, as if written to the pty */
+void sim_uart_phone_send(const uint8_t* data, uint32_t len);
+bool sim_uart_module_ready(void);
+void sim_uart_get_stats(sim_link_stats_t* out);
+
+#endif /* SIM_UART_H_ */
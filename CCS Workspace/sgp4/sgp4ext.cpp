@@ -32,6 +32,7 @@
 *       ----------------------------------------------------------------      */
 
 #include "sgp4ext.h"
+#include "timeconv.h"
 
 
 float  sgn
@@ -544,7 +545,7 @@ void rv2coe
 *  this procedure finds the julian date given the year, month, day, and time.
 *    the julian date is defined by each elapsed day since noon, jan 1, 4713 bc.
 *
-*  algorithm     : calculate the answer in one step for efficiency
+*  algorithm     : calculate the answer in one step for efficiency (timeconv.h)
 *
 *  author        : david vallado                  719-573-2600    1 mar 2001
 *
@@ -576,12 +577,7 @@ void    jday
           float& jd
         )
    {
-     jd = 367.0f * year -
-          floorf((7 * (year + floorf((mon + 9) / 12.0f))) * 0.25f) +
-          floorf( 275 * mon / 9.0f ) +
-          day + 1721013.5f +
-          ((sec / 60.0f + minute) / 60.0f + hr) / 24.0f;  // ut in days
-          // - 0.5*sgn(100.0*year + mon - 190002.5) + 0.5;
+     jd = tconv_split_to_jd(tconv_split_from_civil(year, mon, day, hr, minute, sec));
    }  // end jday
 
 
@@ -592,10 +588,7 @@ void    jday
 *  this procedure converts the day of the year, days, to the equivalent month
 *    day, hour, minute and second.
 *
-*  algorithm     : set up array for the number of days per month
-*                  find leap year - use 1900 because 2000 is a leap year
-*                  loop through a temp value while the value is < the days
-*                  perform int conversions to the correct day and month
+*  algorithm     : closed form day number -> civil date, see timeconv.h
 *                  convert remainder into h m s using type conversions
 *
 *  author        : david vallado                  719-573-2600    1 mar 2001
@@ -628,31 +621,15 @@ void    days2mdhms
           int& mon, int& day, int& hr, int& minute, float& sec
         )
    {
-     int i, inttemp, dayofyr;
-     float    temp;
-     int lmonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-
-     dayofyr = (int)floorf(days);
-     /* ----------------- find month and day of month ---------------- */
-     if ( (year % 4) == 0 )
-       lmonth[1] = 29;
-
-     i = 1;
-     inttemp = 0;
-     while ((dayofyr > inttemp + lmonth[i-1]) && (i < 12))
-     {
-       inttemp = inttemp + lmonth[i-1];
-       i++;
-     }
-     mon = i;
-     day = dayofyr - inttemp;
-
-     /* ----------------- find hours minutes and seconds ------------- */
-     temp = (days - dayofyr) * 24.0;
-     hr   = (int)floorf(temp);
-     temp = (temp - hr) * 60.0;
-     minute  = (int)floorf(temp);
-     sec  = (temp - minute) * 60.0;
+     int32_t y, m, d, h, mi;
+     int32_t dayofyr = (int32_t)floorf(days);
+
+     tconv_civil_from_days(tconv_days_from_doy(year, dayofyr), &y, &m, &d);
+     tconv_hms_from_frac(days - dayofyr, &h, &mi, &sec);
+     mon = m;
+     day = d;
+     hr = h;
+     minute = mi;
    }  // end days2mdhms
 
 /* -----------------------------------------------------------------------------
@@ -662,10 +639,8 @@ void    days2mdhms
 *  this procedure finds the year, month, day, hour, minute and second
 *  given the julian date. tu can be ut1, tdt, tdb, etc.
 *
-*  algorithm     : set up starting values
-*                  find leap year - use 1900 because 2000 is a leap year
-*                  find the elapsed days through the year in a loop
-*                  call routine to find each individual value
+*  algorithm     : split the jd into day number and fraction, then closed
+*                  form civil date and h m s, see timeconv.h
 *
 *  author        : david vallado                  719-573-2600    1 mar 2001
 *
@@ -702,29 +677,16 @@ void    invjday
           int& hr, int& minute, float& sec
         )
    {
-     int leapyrs;
-     float    days, tu, temp;
-
-     /* --------------- find year and days of the year --------------- */
-     temp    = jd - 2415019.5;
-     tu      = temp / 365.25;
-     year    = 1900 + (int)floorf(tu);
-     leapyrs = (int)floorf((year - 1901) * 0.25f);
-
-     // optional nudge by 8.64x10-7 sec to get even outputs
-     days    = temp - ((year - 1900) * 365.0f + leapyrs) + 0.00000000001f;
-
-     /* ------------ check for case of beginning of a year ----------- */
-     if (days < 1.0f)
-       {
-         year    = year - 1;
-         leapyrs = (int)floorf((year - 1901) * 0.25f);
-         days    = temp - ((year - 1900) * 365.0f + leapyrs);
-       }
-
-     /* ----------------- find remaing data  ------------------------- */
-     days2mdhms(year, days, mon, day, hr, minute, sec);
-     sec = sec - 0.00000086400f;
+     int32_t y, m, d, h, mi;
+     tconv_split_t t = tconv_split_from_jd(jd);
+
+     tconv_civil_from_days(t.day, &y, &m, &d);
+     tconv_hms_from_frac(t.frac, &h, &mi, &sec);
+     year = y;
+     mon = m;
+     day = d;
+     hr = h;
+     minute = mi;
    }  // end invjday
 
 
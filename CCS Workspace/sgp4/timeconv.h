@@ -0,0 +1,120 @@
+/*
+ * timeconv.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+#ifndef TIMECONV_H_
+#define TIMECONV_H_
+
+#include <stdint.h>
+
+/* Calendar / Julian date conversions, shared by sgp4 and AutoPoint. Header only, C and C++.
+ *
+ * Everything is closed form (Hinnant's days_from_civil / civil_from_days), no month tables or
+ * loops. Days are counted from 2000-01-01 00:00 UTC (JD 2451544.5), which keeps day numbers small
+ * enough to carry exactly next to a float fraction of a day (tconv_split_t): a plain float JD only
+ * resolves ~0.25 day at current dates.
+ *
+ * TCONV_DAYS_FROM_CIVIL() is a plain constant expression, so epoch constants can be computed at
+ * compile time in C (static initializers) as well as C++. In C++11 and later the integer
+ * functions are also constexpr. Valid for years 1 onwards.
+ */
+
+/* Julian date of day 0 */
+#define TCONV_EPOCH_JD      2451544.5f
+
+#define TCONV_SEC_PER_DAY   86400
+
+/* Day number, plus a fraction of the day in [0, 1) */
+typedef struct {
+    int32_t day;
+    float frac;
+} tconv_split_t;
+
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define TCONV_CONSTEXPR constexpr
+#else
+#define TCONV_CONSTEXPR static inline
+#endif
+
+/* Shift the year to start in March, so the leap day is the last day of the year */
+#define TCONV_MYEAR_(y, m)  ((y) - ((m) <= 2))
+#define TCONV_YOE_(y, m)    (TCONV_MYEAR_(y, m) % 400)
+
+/* Days since 2000-01-01 for a Gregorian date. 730425 is 0000-03-01 to 2000-01-01. */
+#define TCONV_DAYS_FROM_CIVIL(y, m, d) \
+    ((TCONV_MYEAR_(y, m) / 400) * 146097 \
+     + TCONV_YOE_(y, m) * 365 + TCONV_YOE_(y, m) / 4 - TCONV_YOE_(y, m) / 100 \
+     + (153 * ((m) > 2 ? (m) - 3 : (m) + 9) + 2) / 5 + (d) - 1 \
+     - 730425)
+
+TCONV_CONSTEXPR int32_t tconv_days_from_civil(int32_t year, int32_t mon, int32_t day) {
+    return TCONV_DAYS_FROM_CIVIL(year, mon, day);
+}
+
+/* Day number of day-of-year doy (1 = Jan 1) */
+TCONV_CONSTEXPR int32_t tconv_days_from_doy(int32_t year, int32_t doy) {
+    return TCONV_DAYS_FROM_CIVIL(year, 1, 1) + doy - 1;
+}
+
+/* Gregorian date of a day number */
+static inline void tconv_civil_from_days(int32_t days, int32_t* year, int32_t* mon, int32_t* day) {
+    uint32_t z = (uint32_t) (days + 730425);
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;                                    /* [0, 146096] */
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; /* [0, 399] */
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);             /* [0, 365], from Mar 1 */
+    uint32_t mp = (5 * doy + 2) / 153;                                  /* [0, 11], from Mar */
+
+    *day = (int32_t) (doy - (153 * mp + 2) / 5 + 1);
+    *mon = (int32_t) (mp < 10 ? mp + 3 : mp - 9);
+    *year = (int32_t) (yoe + era * 400) + (*mon <= 2);
+}
+
+/* Split a fraction of a day into hours, minutes and seconds */
+static inline void tconv_hms_from_frac(float frac, int32_t* hr, int32_t* minute, float* sec) {
+    float s = frac * TCONV_SEC_PER_DAY;
+    int32_t whole = (int32_t) s;
+
+    *hr = whole / 3600;
+    *minute = (whole / 60) % 60;
+    *sec = s - (float) (whole - whole % 60);
+}
+
+static inline tconv_split_t tconv_split_from_civil(int32_t year, int32_t mon, int32_t day,
+                                                   int32_t hr, int32_t minute, float sec) {
+    tconv_split_t t;
+    t.day = tconv_days_from_civil(year, mon, day);
+    t.frac = ((hr * 60 + minute) * 60 + sec) * (1.0f / TCONV_SEC_PER_DAY);
+    return t;
+}
+
+/* TLE style epoch: year, day of year (1 = Jan 1) and fraction of that day */
+static inline tconv_split_t tconv_split_from_doy(int32_t year, int32_t doy, float frac) {
+    tconv_split_t t;
+    t.day = tconv_days_from_doy(year, doy);
+    t.frac = frac;
+    return t;
+}
+
+/* Back to a float JD, for code that wants one (loses everything past ~0.25 day) */
+static inline float tconv_split_to_jd(tconv_split_t t) {
+    return TCONV_EPOCH_JD + (float) t.day + t.frac;
+}
+
+static inline tconv_split_t tconv_split_from_jd(float jd) {
+    float d = jd - TCONV_EPOCH_JD;
+    tconv_split_t t;
+    t.day = (int32_t) d - (d < (float) (int32_t) d);    /* floor */
+    t.frac = d - (float) t.day;
+    return t;
+}
+
+/* b - a in minutes, without ever forming a float JD */
+static inline float tconv_split_diff_min(tconv_split_t a, tconv_split_t b) {
+    return (float) (b.day - a.day) * 1440.0f + (b.frac - a.frac) * 1440.0f;
+}
+
+#endif /* TIMECONV_H_ */
@@ -0,0 +1,139 @@
+/*
+ * timeconv_test.cpp
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: james
+ */
+
+/* Host test for timeconv.h and the sgp4ext.cpp routines built on it: round trips every day
+ * from 1900 to 2100 against the old month table loops, and (with "bench") times both.
+ *
+ * Not part of the CCS build; host/Makefile builds it, and runs it from make test / make bench.
+ * sgp4ext.h's float asinh() clashes with C++11 <cmath>, so sgp4ext.cpp is built as C++98 and its
+ * prototypes are repeated here.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "timeconv.h"
+
+void jday(int year, int mon, int day, int hr, int minute, float sec, float& jd);
+void days2mdhms(int year, float days, int& mon, int& day, int& hr, int& minute, float& sec);
+void invjday(float jd, int& year, int& mon, int& day, int& hr, int& minute, float& sec);
+
+/* compile time epoch constants */
+static_assert(tconv_days_from_civil(2000, 1, 1) == 0, "day 0");
+static_assert(tconv_days_from_civil(2017, 12, 26) == 6569, "tle epoch");
+static_assert(TCONV_DAYS_FROM_CIVIL(1999, 12, 31) == -1, "day -1");
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { failures++; if (failures < 20) printf(__VA_ARGS__); } } while (0)
+
+/* The month table loop days2mdhms used to do */
+static void ref_month_day(int year, int dayofyr, int& mon, int& day) {
+    int lmonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0) lmonth[1] = 29;
+
+    int i = 1, inttemp = 0;
+    while ((dayofyr > inttemp + lmonth[i-1]) && (i < 12)) {
+        inttemp += lmonth[i-1];
+        i++;
+    }
+    mon = i;
+    day = dayofyr - inttemp;
+}
+
+static int days_in_year(int year) {
+    return ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0) ? 366 : 365;
+}
+
+static void test_round_trip(void) {
+    int32_t expect = tconv_days_from_civil(1900, 1, 1);
+
+    for (int year = 1900; year <= 2100; year++) {
+        for (int doy = 1; doy <= days_in_year(year); doy++) {
+            int mon, day;
+            ref_month_day(year, doy, mon, day);
+
+            int32_t days = tconv_days_from_civil(year, mon, day);
+            CHECK(days == expect, "%04d-%02d-%02d: day %ld, expected %ld\n", year, mon, day, (long) days, (long) expect);
+            CHECK(tconv_days_from_doy(year, doy) == days, "%04d doy %d\n", year, doy);
+
+            int32_t y, m, d;
+            tconv_civil_from_days(days, &y, &m, &d);
+            CHECK(y == year && m == mon && d == day, "day %ld -> %04ld-%02ld-%02ld, expected %04d-%02d-%02d\n",
+                  (long) days, (long) y, (long) m, (long) d, year, mon, day);
+
+            /* sgp4ext wrapper, at 12:01 (float day of year is only good to a few seconds) */
+            int m2, d2, hr, minute;
+            float sec;
+            days2mdhms(year, doy + 0.5f + 1.0f / 1440.0f, m2, d2, hr, minute, sec);
+            float tod = (hr * 60 + minute) * 60 + sec;
+            CHECK(m2 == mon && d2 == day && tod > 43257.0f && tod < 43263.0f,
+                  "days2mdhms %04d %d -> %d/%d %d:%d:%f\n", year, doy, m2, d2, hr, minute, sec);
+
+            expect++;
+        }
+    }
+}
+
+static void test_jd(void) {
+    /* known julian dates */
+    float jd;
+    jday(2000, 1, 1, 12, 0, 0.0f, jd);
+    CHECK(jd == 2451545.0f, "J2000 jd %f\n", jd);
+    jday(1957, 10, 4, 19, 26, 24.0f, jd);
+    CHECK(jd >= 2436116.25f && jd <= 2436116.5f, "sputnik jd %f\n", jd);   /* 2436116.31, float resolution 0.25 */
+
+    int year, mon, day, hr, minute;
+    float sec;
+    invjday(2458113.5f, year, mon, day, hr, minute, sec);
+    CHECK(year == 2017 && mon == 12 && day == 26 && hr == 0 && minute == 0, "invjday %d-%d-%d %d:%d\n",
+          year, mon, day, hr, minute);
+
+    /* split epochs keep sub-second differences a float jd can't */
+    tconv_split_t a = tconv_split_from_doy(2017, 360, 0.63489756f);
+    tconv_split_t b = a;
+    b.frac += 1.0f / 86400.0f;
+    float dt = tconv_split_diff_min(a, b) * 60.0f;
+    CHECK(dt > 0.99f && dt < 1.01f, "split diff %f s\n", dt);
+}
+
+static void bench(void) {
+    const int reps = 20000;
+    volatile int sink = 0;
+
+    clock_t t0 = clock();
+    for (int r = 0; r < reps; r++) {
+        for (int doy = 1; doy <= 365; doy++) {
+            int mon, day;
+            ref_month_day(2018 + (r & 3), doy, mon, day);
+            sink += mon + day;
+        }
+    }
+    clock_t t1 = clock();
+    for (int r = 0; r < reps; r++) {
+        for (int doy = 1; doy <= 365; doy++) {
+            int32_t y, mon, day;
+            tconv_civil_from_days(tconv_days_from_doy(2018 + (r & 3), doy), &y, &mon, &day);
+            sink += mon + day;
+        }
+    }
+    clock_t t2 = clock();
+
+    double n = reps * 365.0;
+    printf("doy -> month/day: table loop %.1f ns, closed form %.1f ns\n",
+           (t1 - t0) * 1e9 / CLOCKS_PER_SEC / n, (t2 - t1) * 1e9 / CLOCKS_PER_SEC / n);
+}
+
+int main(int argc, char** argv) {
+    test_round_trip();
+    test_jd();
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) bench();
+
+    printf("%s (%d failures)\n", failures ? "FAIL" : "PASS", failures);
+    return failures ? 1 : 0;
+}
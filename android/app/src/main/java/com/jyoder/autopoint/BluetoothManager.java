@@ -6,8 +6,16 @@ import android.bluetooth.BluetoothDevice;
 import android.bluetooth.BluetoothSocket;
 import android.content.Intent;
 import android.os.ParcelUuid;
+import android.os.SystemClock;
 
 import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.nio.charset.StandardCharsets;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
 import java.util.Set;
 import java.util.UUID;
 
@@ -46,6 +54,52 @@ public class BluetoothManager extends Thread{
     private BluetoothDevice connectedDevice;
     private BluetoothSocket socket;
 
+    /* Result of the last clock sync, for the UI */
+    private volatile boolean clockSynced = false;
+    private volatile long syncOffsetUs = 0;
+    private volatile long syncUncertaintyUs = 0;
+    private volatile long driftPpb = 0;
+
+    /* Last link throughput test, bytes/s each way, and the UART baud the laser reported */
+    private volatile long downBytesPerSec = 0;
+    private volatile long upBytesPerSec = 0;
+    private volatile long linkBaud = 0;
+    private volatile boolean linkTestRequested = true;
+
+    private static final int LINK_TEST_BYTES = 16384;
+
+    /* TLE text waiting to go to the laser, and how the last upload went */
+    private volatile String catalogText = null;
+    private volatile int catalogSets = 0;
+    private volatile int catalogErrors = 0;
+
+    /* Give up on an upload after this many timeouts in a row */
+    private static final int CATALOG_MAX_TIMEOUTS = 5;
+
+    /* What we last loaded into the laser's catalog, by norad number. Only good for this connection. */
+    private final Map<Integer, Tle> resident = new HashMap<>();
+
+    /* Telemetry stream. Frames are picked out of whatever else we're reading (see readFrame()). */
+    private final Telemetry telemetry = new Telemetry();
+    private volatile Telemetry.Sample lastSample = null;
+    private volatile int telemetryHz = 50;
+    private int telemetrySentHz = -1;
+    private boolean bootLogged = false;
+
+    /* The laser says when it next needs a sync (SystemClock.elapsedRealtime) */
+    private long nextSyncAt = 0;
+
+    /* Unix microseconds. currentTimeMillis is only ms and can jump, so take it once and
+     * count from the monotonic clock after that. */
+    private final long baseUnixUs = System.currentTimeMillis() * 1000;
+    private final long baseElapsedNs = SystemClock.elapsedRealtimeNanos();
+
+    private static final long REPLY_TIMEOUT_MS = 1000;
+    private static final long TELEMETRY_POLL_MS = 100;
+
+    /* Largest encoded frame, delimiter not included (FRAME_MAX_ENCODED in frame.h) */
+    private static final int FRAME_BUFFER = Frame.MAX_PAYLOAD + 5;
+
     public BluetoothManager(MainActivity act) {
         this.activity = act;
     }
@@ -72,6 +126,265 @@ public class BluetoothManager extends Thread{
         return null;
     }
 
+    public boolean isClockSynced() {
+        return clockSynced;
+    }
+
+    public long getSyncOffsetUs() {
+        return syncOffsetUs;
+    }
+
+    public long getSyncUncertaintyUs() {
+        return syncUncertaintyUs;
+    }
+
+    public long getDriftPpb() {
+        return driftPpb;
+    }
+
+    public long getDownBytesPerSec() {
+        return downBytesPerSec;
+    }
+
+    public long getUpBytesPerSec() {
+        return upBytesPerSec;
+    }
+
+    public long getLinkBaud() {
+        return linkBaud;
+    }
+
+    /* How long the laser's RN42 took from power up to configured, 0 until the first status block */
+    public long getRn42BootUs() {
+        return telemetry.haveStatus ? telemetry.rn42BootUs : 0;
+    }
+
+    public int getCatalogSets() {
+        return catalogSets;
+    }
+
+    public int getCatalogErrors() {
+        return catalogErrors;
+    }
+
+    /* Latest telemetry sample, null until the stream starts */
+    public Telemetry.Sample getLastSample() {
+        return lastSample;
+    }
+
+    /* Stats from the stream: rate, dropped samples, timing, clock status */
+    public Telemetry getTelemetry() {
+        return telemetry;
+    }
+
+    /* Ask for telemetry at up to hz (the laser backs off to what the link takes), 0 stops it */
+    public void setTelemetryRate(int hz) {
+        telemetryHz = hz;
+    }
+
+    /* Replace the laser's catalog with these element sets (2 or 3 line TLEs) */
+    public void requestCatalogUpload(String tles) {
+        catalogText = tles;
+    }
+
+    /* Run the throughput test next time round the loop (it runs once on connect anyway) */
+    public void requestLinkTest() {
+        linkTestRequested = true;
+    }
+
+    private long nowUs() {
+        return baseUnixUs + (SystemClock.elapsedRealtimeNanos() - baseElapsedNs) / 1000;
+    }
+
+    /* Read one frame off the socket, or null if nothing valid shows up in time. Frames that fail
+     * to decode are skipped, and telemetry goes to its decoder rather than the caller. Stamps t[0]
+     * with the time the delimiter came in, and t[1] with the frame's length on the wire. */
+    private Frame readFrame(long timeoutMs, long[] t) throws IOException {
+        InputStream in = socket.getInputStream();
+        byte[] buf = new byte[FRAME_BUFFER];
+        int len = 0;
+        long deadline = SystemClock.elapsedRealtime() + timeoutMs;
+
+        while (SystemClock.elapsedRealtime() < deadline) {
+            if (in.available() == 0) {
+                Thread.yield();
+                continue;
+            }
+            int c = in.read();
+            if (c < 0) throw new IOException("socket closed");
+            if (c == Frame.DELIM) {
+                t[0] = nowUs();
+                t[1] = len + 1;
+                Frame f = len > 0 && len <= buf.length ? Frame.decode(buf, len) : null;
+                len = 0;
+                if (f == null) continue;
+                if (f.type != (Protocol.TELEMETRY | Protocol.REPLY)) return f;
+
+                List<Telemetry.Sample> samples = telemetry.onFrame(f);
+                if (samples != null && !samples.isEmpty()) lastSample = samples.get(samples.size() - 1);
+                if (!bootLogged && telemetry.haveStatus && telemetry.rn42BootUs != 0) {
+                    bootLogged = true;
+                    System.out.println("RN42 ready " + telemetry.rn42BootUs / 1000 + " ms after power up");
+                }
+                continue;
+            }
+            if (len < buf.length) buf[len] = (byte) c;
+            len++;
+        }
+        return null;
+    }
+
+    /* Sync the laser's clock to ours (see TimeSync) */
+    private void syncClock() throws IOException {
+        TimeSync sync = new TimeSync();
+        long[] t4 = new long[2];
+
+        for (int seq = 0; seq < TimeSync.EXCHANGES; seq++) {
+            long t1 = nowUs();
+            socket.getOutputStream().write(TimeSync.request(seq, t1));
+
+            Frame f;
+            while ((f = readFrame(REPLY_TIMEOUT_MS, t4)) != null) {
+                TimeSync.Sample s = TimeSync.parseReply(f, seq, t4[0]);
+                if (s != null) {
+                    sync.add(s);
+                    break;
+                }
+            }
+        }
+
+        if (!sync.hasResult()) return;
+
+        socket.getOutputStream().write(sync.applyPacket());
+        syncOffsetUs = sync.getOffsetUs();
+        syncUncertaintyUs = sync.getUncertaintyUs();
+        clockSynced = true;
+
+        /* ack: { i64 offset, u32 uncertainty, i32 drift ppb, u32 next sync s } */
+        long nextSyncS = 60;
+        Frame f;
+        while ((f = readFrame(REPLY_TIMEOUT_MS, t4)) != null) {
+            if (f.type == (Protocol.TIME_APPLY | Protocol.REPLY) && f.payload.remaining() == 20) {
+                driftPpb = f.payload.getInt(12);
+                nextSyncS = f.payload.getInt(16) & 0xFFFFFFFFL;
+                break;
+            }
+        }
+        nextSyncAt = SystemClock.elapsedRealtime() + nextSyncS * 1000;
+
+        System.out.println("Clock sync: offset " + syncOffsetUs + " us +- " + syncUncertaintyUs + " us, drift "
+                + driftPpb + " ppb, next in " + nextSyncS + " s");
+    }
+
+    /* Measure link throughput both ways (see Throughput) */
+    private void measureThroughput() throws IOException {
+        long[] t = new long[2];
+        Frame f;
+
+        /* down: time from asking to the end marker, counting what actually arrived */
+        long start = nowUs();
+        socket.getOutputStream().write(Throughput.downRequest(LINK_TEST_BYTES));
+        long received = 0;
+        while ((f = readFrame(REPLY_TIMEOUT_MS, t)) != null) {
+            if (Throughput.isDownFill(f)) {
+                received += t[1];
+            } else if (Throughput.parseEnd(f) >= 0) {
+                downBytesPerSec = Throughput.bytesPerSecond(received, t[0] - start);
+                break;
+            }
+        }
+
+        /* up: the laser times it */
+        byte[] filler = Throughput.upFrame();
+        for (int sent = 0; sent < LINK_TEST_BYTES; sent += filler.length) {
+            socket.getOutputStream().write(filler);
+        }
+        socket.getOutputStream().write(Throughput.countRequest());
+        while ((f = readFrame(REPLY_TIMEOUT_MS * 10, t)) != null) {
+            long[] count = Throughput.parseCount(f);
+            if (count != null) {
+                upBytesPerSec = Throughput.bytesPerSecond(count[0], count[1]);
+                linkBaud = count[2];
+                break;
+            }
+        }
+
+        System.out.println("Link test: down " + downBytesPerSec + " B/s (" + received + " of "
+                + LINK_TEST_BYTES + " bytes), up " + upBytesPerSec + " B/s, " + linkBaud + " baud");
+    }
+
+    /* Bring the laser's catalog up to these sets. If we know what it holds (we loaded it this
+     * session), only what changed goes, as deltas (see CatalogDelta); anything it doesn't have,
+     * or turns down, follows as text in a merge upload. */
+    private void syncCatalog(String tles) throws IOException {
+        List<Tle> sets = Tle.parseAll(tles);
+        List<Tle> full = new ArrayList<>();
+        int flags = 0;
+
+        if (resident.isEmpty()) {
+            full.addAll(sets);
+        } else {
+            byte[] delta = CatalogDelta.encode(resident, sets, full);
+            CatalogUpload up = upload(CatalogUpload.DELTA, delta);
+            if (up == null || !up.isDone()) return;
+            if (up.getErrors() > 0) {
+                /* no telling which, so send the lot */
+                full.clear();
+                full.addAll(sets);
+            }
+            flags = CatalogUpload.MERGE;
+        }
+
+        if (!full.isEmpty()) {
+            StringBuilder text = new StringBuilder();
+            for (Tle t : full) text.append(t.text());
+            CatalogUpload up = upload(flags, text.toString().getBytes(StandardCharsets.US_ASCII));
+            if (up == null || !up.isDone()) {
+                resident.clear();
+                return;
+            }
+        }
+
+        if (flags == 0) resident.clear();
+        for (Tle t : sets) resident.put(t.norad, t);
+    }
+
+    /* Stream one upload over (see CatalogUpload). null if the laser never answered the begin. */
+    private CatalogUpload upload(int flags, byte[] data) throws IOException {
+        OutputStream out = socket.getOutputStream();
+        long[] t = new long[2];
+        Frame f;
+
+        out.write(CatalogUpload.beginRequest(flags));
+        CatalogUpload up = null;
+        while (up == null && (f = readFrame(REPLY_TIMEOUT_MS, t)) != null) {
+            up = CatalogUpload.fromBeginReply(f, data);
+        }
+        if (up == null) return null;
+
+        long start = SystemClock.elapsedRealtime();
+        int timeouts = 0;
+        while (!up.isDone()) {
+            byte[] frame;
+            while ((frame = up.poll()) != null) out.write(frame);
+
+            f = readFrame(REPLY_TIMEOUT_MS, t);
+            if (f == null) {
+                if (++timeouts >= CATALOG_MAX_TIMEOUTS) break;
+                up.onTimeout();
+            } else if (up.onReply(f)) {
+                timeouts = 0;
+                catalogSets = up.getSets();
+                catalogErrors = up.getErrors();
+            }
+        }
+
+        System.out.println("Catalog upload" + ((flags & CatalogUpload.DELTA) != 0 ? " (delta)" : "") + ": "
+                + (up.isDone() ? "done" : "gave up") + ", " + up.getSets() + " sets, " + up.getErrors()
+                + " skipped, " + data.length + " bytes in " + (SystemClock.elapsedRealtime() - start) + " ms");
+        return up;
+    }
+
     public synchronized void startConnecting() {
         command = Command.CONNECT;
         this.notify();
@@ -124,6 +437,10 @@ public class BluetoothManager extends Thread{
                    BluetoothSocket sock = dev.createInsecureRfcommSocketToServiceRecord(UUID.fromString("00001101-0000-1000-8000-00805f9b34fb"));
                    sock.connect();
                    socket = sock;
+                   resident.clear();
+                   telemetry.reset();
+                   bootLogged = false;
+                   telemetrySentHz = -1;
                    connectedDevice = dev;
                    state = State.CONNECTED;
                } catch (IOException ex) {
@@ -131,9 +448,24 @@ public class BluetoothManager extends Thread{
                    state = State.CONNECTION_ERROR;
                }
            } else if (state == State.CONNECTED) {
-                String pkt = "$1:69:420:69\n";
                 try {
-                    socket.getOutputStream().write(pkt.getBytes());
+                    if (!clockSynced || SystemClock.elapsedRealtime() >= nextSyncAt) syncClock();
+                    if (linkTestRequested) {
+                        linkTestRequested = false;
+                        measureThroughput();
+                    }
+                    String tles = catalogText;
+                    if (tles != null) {
+                        catalogText = null;
+                        syncCatalog(tles);
+                    }
+                    if (telemetrySentHz != telemetryHz) {
+                        telemetrySentHz = telemetryHz;
+                        socket.getOutputStream().write(Telemetry.request(telemetrySentHz));
+                    }
+
+                    /* nothing else to do, so just take telemetry for a while */
+                    readFrame(TELEMETRY_POLL_MS, new long[2]);
                 } catch (IOException ex) {
                     state = State.CONNECTION_ERROR;
                 }
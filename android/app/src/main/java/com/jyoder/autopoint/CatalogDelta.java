@@ -0,0 +1,99 @@
+package com.jyoder.autopoint;
+
+import java.io.ByteArrayOutputStream;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Delta catalog updates (CATALOG_BEGIN_DELTA, see catalog.h in the firmware).
+ *
+ * For each set the laser already holds, a record of what changed against it: u8 length, then
+ * varints norad, base epoch day, base epoch frac, field mask, and a zigzag delta per mask bit.
+ * Sets that didn't change aren't sent. Sets it doesn't hold (or that moved too far to delta)
+ * have to go as text in a merge upload instead.
+ */
+public class CatalogDelta {
+
+    /* Mask bits, catalog_delta_field_t order */
+    public static final int EPOCH = 0;
+    public static final int NDOT = 1;
+    public static final int NDDOT_M = 2;
+    public static final int NDDOT_E = 3;
+    public static final int BSTAR_M = 4;
+    public static final int BSTAR_E = 5;
+    public static final int INCLO = 6;
+    public static final int NODEO = 7;
+    public static final int ECCO = 8;
+    public static final int ARGPO = 9;
+    public static final int MO = 10;
+    public static final int NO = 11;
+    public static final int FIELDS = 12;
+
+    static void putVarint(ByteArrayOutputStream out, long v) {
+        while (v >= 0x80) {
+            out.write((int) (v & 0x7F) | 0x80);
+            v >>>= 7;
+        }
+        out.write((int) v);
+    }
+
+    static void putZigzag(ByteArrayOutputStream out, int v) {
+        putVarint(out, ((v << 1) ^ (v >> 31)) & 0xFFFFFFFFL);
+    }
+
+    /* Shortest way round */
+    private static int angle(int from, int to) {
+        int d = (to - from) % Tle.DEG_FULL;
+        if (d < 0) d += Tle.DEG_FULL;
+        return d > Tle.DEG_FULL / 2 ? d - Tle.DEG_FULL : d;
+    }
+
+    /* One record (without its length), or null if it can't be a delta. An empty array if nothing changed. */
+    static byte[] record(Tle base, Tle now) {
+        long epoch = (long) (now.epochDay - base.epochDay) * 100000000 + (now.epochFrac - base.epochFrac);
+        if (epoch > Integer.MAX_VALUE || epoch < Integer.MIN_VALUE) return null;
+
+        int[] d = new int[FIELDS];
+        d[EPOCH] = (int) epoch;
+        d[NDOT] = now.ndot - base.ndot;
+        d[NDDOT_M] = now.nddotM - base.nddotM;
+        d[NDDOT_E] = now.nddotE - base.nddotE;
+        d[BSTAR_M] = now.bstarM - base.bstarM;
+        d[BSTAR_E] = now.bstarE - base.bstarE;
+        d[INCLO] = now.inclo - base.inclo;
+        d[NODEO] = angle(base.nodeo, now.nodeo);
+        d[ECCO] = now.ecco - base.ecco;
+        d[ARGPO] = angle(base.argpo, now.argpo);
+        d[MO] = angle(base.mo, now.mo);
+        d[NO] = now.no - base.no;
+
+        int mask = 0;
+        for (int i = 0; i < FIELDS; i++) if (d[i] != 0) mask |= 1 << i;
+        if (mask == 0) return new byte[0];
+
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        putVarint(out, base.norad);
+        putVarint(out, base.epochDay);
+        putVarint(out, base.epochFrac);
+        putVarint(out, mask);
+        for (int i = 0; i < FIELDS; i++) if (d[i] != 0) putZigzag(out, d[i]);
+        return out.toByteArray();
+    }
+
+    /* The delta stream taking resident up to sets. Sets that have to go whole are added to full. */
+    public static byte[] encode(Map<Integer, Tle> resident, List<Tle> sets, List<Tle> full) {
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+
+        for (Tle t : sets) {
+            Tle base = resident.get(t.norad);
+            byte[] rec = base != null ? record(base, t) : null;
+            if (rec == null) {
+                full.add(t);
+            } else if (rec.length > 0) {
+                out.write(rec.length);
+                out.write(rec, 0, rec.length);
+            }
+        }
+        return out.toByteArray();
+    }
+}
@@ -0,0 +1,130 @@
+package com.jyoder.autopoint;
+
+import java.nio.ByteBuffer;
+
+/**
+ * Sending side of a catalog upload (the CATALOG_ frames, see catalog.h in the firmware).
+ *
+ * The TLE text (or delta records, see CatalogDelta) goes out in numbered chunks, up to the laser's window of them in flight at once
+ * (go-back-N). It acknowledges cumulatively every few chunks; a RESEND answer, or no answer
+ * for a while, sends us back to the first chunk it doesn't have. Once everything has gone out
+ * we send END, which it answers with DONE or where to resend from.
+ *
+ * Usage: send beginRequest(), make one from the answer with fromBeginReply(), then keep sending
+ * whatever poll() gives and feeding it replies (or timeouts) until isDone().
+ */
+public class CatalogUpload {
+
+    public static final int STATUS_ACK = 0;
+    public static final int STATUS_DONE = 1;
+    public static final int STATUS_RESEND = 2;
+
+    private final byte[] text;
+    private final int window;
+    private final int chunkMax;
+    private final int chunks;
+
+    /* Oldest chunk the laser hasn't acknowledged, next chunk to send */
+    private int base = 0;
+    private int next = 0;
+    private boolean endSent = false;
+    private boolean done = false;
+
+    private int sets = 0;
+    private int errors = 0;
+
+    public CatalogUpload(byte[] text, int window, int chunkMax) {
+        this.text = text;
+        this.window = window;
+        this.chunkMax = chunkMax;
+        this.chunks = (text.length + chunkMax - 1) / chunkMax;
+    }
+
+    /* Begin flags */
+    public static final int MERGE = 0x01;
+    public static final int DELTA = 0x02;
+
+    public static byte[] beginRequest(int flags) {
+        return Frame.encode(Protocol.CATALOG_BEGIN, new byte[] { (byte) flags });
+    }
+
+    /* From the answer to beginRequest() { u8 window, u8 chunk max, u16 capacity }, or null if it isn't one */
+    public static CatalogUpload fromBeginReply(Frame f, byte[] text) {
+        if (f.type != (Protocol.CATALOG_BEGIN | Protocol.REPLY) || f.payload.remaining() != 4) return null;
+        int window = f.payload.get(0) & 0xFF;
+        int chunkMax = f.payload.get(1) & 0xFF;
+        if (window == 0 || chunkMax == 0) return null;
+        return new CatalogUpload(text, window, chunkMax);
+    }
+
+    /* The next frame to send, or null if we have to wait for an answer */
+    public byte[] poll() {
+        if (done) return null;
+
+        if (next < chunks && next - base < window) {
+            int from = next * chunkMax;
+            int len = Math.min(chunkMax, text.length - from);
+            ByteBuffer p = Frame.payload(2 + len).putShort((short) next).put(text, from, len);
+            next++;
+            return Frame.encode(Protocol.CATALOG_CHUNK, p);
+        }
+
+        if (next == chunks && !endSent) {
+            endSent = true;
+            return Frame.encode(Protocol.CATALOG_END, Frame.payload(2).putShort((short) chunks));
+        }
+        return null;
+    }
+
+    /* An answer from the laser. Returns false if it wasn't for us. */
+    public boolean onReply(Frame f) {
+        if ((f.type != (Protocol.CATALOG_CHUNK | Protocol.REPLY) && f.type != (Protocol.CATALOG_END | Protocol.REPLY))
+                || f.payload.remaining() != 7) {
+            return false;
+        }
+
+        int acked = f.payload.getShort(0) & 0xFFFF;
+        sets = f.payload.getShort(2) & 0xFFFF;
+        errors = f.payload.getShort(4) & 0xFFFF;
+        int status = f.payload.get(6) & 0xFF;
+
+        if (acked > base && acked <= chunks) base = acked;
+
+        if (status == STATUS_DONE) {
+            done = true;
+        } else if (status == STATUS_RESEND) {
+            goBack();
+        }
+        return true;
+    }
+
+    /* Nothing heard for too long: assume the rest of the window is lost */
+    public void onTimeout() {
+        goBack();
+    }
+
+    private void goBack() {
+        next = base;
+        endSent = false;
+    }
+
+    public boolean isDone() {
+        return done;
+    }
+
+    public int getChunks() {
+        return chunks;
+    }
+
+    public int getAcked() {
+        return base;
+    }
+
+    public int getSets() {
+        return sets;
+    }
+
+    public int getErrors() {
+        return errors;
+    }
+}
@@ -0,0 +1,112 @@
+package com.jyoder.autopoint;
+
+import java.io.ByteArrayOutputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * Binary link framing, same as frame.h in the firmware:
+ *
+ *   COBS( type | payload | crc16 ) 0x00
+ *
+ * crc16 is CRC-16/ARC over type and payload, little-endian. COBS leaves 0x00 only as the
+ * delimiter, so a reader can always find the next frame boundary.
+ */
+public class Frame {
+
+    public static final int DELIM = 0x00;
+    public static final int MAX_PAYLOAD = 250;
+
+    public final int type;
+    public final ByteBuffer payload;    /* little-endian, positioned at the start */
+
+    public Frame(int type, byte[] payload) {
+        this.type = type;
+        this.payload = ByteBuffer.wrap(payload).order(ByteOrder.LITTLE_ENDIAN);
+    }
+
+    /* A little-endian buffer to build a payload in */
+    public static ByteBuffer payload(int size) {
+        return ByteBuffer.allocate(size).order(ByteOrder.LITTLE_ENDIAN);
+    }
+
+    public static int crc16(byte[] data, int len) {
+        int crc = 0;
+        for (int i = 0; i < len; i++) {
+            crc ^= data[i] & 0xFF;
+            for (int b = 0; b < 8; b++) {
+                crc = (crc & 1) != 0 ? (crc >>> 1) ^ 0xA001 : crc >>> 1;
+            }
+        }
+        return crc;
+    }
+
+    public static byte[] cobsEncode(byte[] in, int len) {
+        ByteArrayOutputStream out = new ByteArrayOutputStream(len + len / 254 + 1);
+        byte[] block = new byte[254];
+        int n = 0;
+
+        for (int i = 0; i < len; i++) {
+            if (in[i] != 0) block[n++] = in[i];
+            if (in[i] == 0 || n == 254) {
+                out.write(n + 1);
+                out.write(block, 0, n);
+                n = 0;
+            }
+        }
+        out.write(n + 1);
+        out.write(block, 0, n);
+        return out.toByteArray();
+    }
+
+    /* Returns null if it isn't valid COBS */
+    public static byte[] cobsDecode(byte[] in, int len) {
+        ByteArrayOutputStream out = new ByteArrayOutputStream(len);
+        int i = 0;
+
+        while (i < len) {
+            int code = in[i++] & 0xFF;
+            if (code == 0 || i + code - 1 > len) return null;
+            for (int j = 1; j < code; j++) {
+                if (in[i] == 0) return null;
+                out.write(in[i++]);
+            }
+            if (code != 0xFF && i < len) out.write(0);
+        }
+        return out.toByteArray();
+    }
+
+    /* The whole frame as it goes on the wire, delimiter included */
+    public static byte[] encode(int type, byte[] payload) {
+        byte[] raw = new byte[payload.length + 3];
+        raw[0] = (byte) type;
+        System.arraycopy(payload, 0, raw, 1, payload.length);
+        int crc = crc16(raw, payload.length + 1);
+        raw[payload.length + 1] = (byte) crc;
+        raw[payload.length + 2] = (byte) (crc >>> 8);
+
+        byte[] cobs = cobsEncode(raw, raw.length);
+        byte[] out = new byte[cobs.length + 1];
+        System.arraycopy(cobs, 0, out, 0, cobs.length);
+        out[cobs.length] = DELIM;
+        return out;
+    }
+
+    public static byte[] encode(int type, ByteBuffer payload) {
+        return encode(type, payload.array());
+    }
+
+    /* Decode len received bytes (delimiter not included). Returns null for a bad frame. */
+    public static Frame decode(byte[] buf, int len) {
+        byte[] raw = cobsDecode(buf, len);
+        if (raw == null || raw.length < 3) return null;
+
+        int n = raw.length - 2;
+        int crc = (raw[n] & 0xFF) | ((raw[n + 1] & 0xFF) << 8);
+        if (crc16(raw, n) != crc) return null;
+
+        byte[] payload = new byte[n - 1];
+        System.arraycopy(raw, 1, payload, 0, n - 1);
+        return new Frame(raw[0] & 0xFF, payload);
+    }
+}
@@ -0,0 +1,30 @@
+package com.jyoder.autopoint;
+
+/**
+ * Bluetooth message types. Mirrors protocol.h in the firmware, which has the payload layouts.
+ */
+public class Protocol {
+    public static final int REPLY = 0x80;
+
+    public static final int TIME_REQUEST = 0x01;
+    public static final int SITE = 0x02;
+    public static final int TABLE_UPLOAD = 0x03;
+    public static final int TABLE_COMMIT = 0x04;
+    public static final int TABLE_RESET = 0x05;
+    public static final int GAINS = 0x06;
+    public static final int MOUNT_ENABLE = 0x07;
+    public static final int POINTING_MODEL = 0x08;
+    public static final int ZONE = 0x09;
+    public static final int LASER_ARM = 0x0A;
+    public static final int INTERLOCK_STATUS = 0x0B;
+    public static final int TIME_APPLY = 0x0C;
+    public static final int LINK_SEND = 0x0D;
+    public static final int LINK_FILL = 0x0E;
+    public static final int LINK_COUNT = 0x0F;
+    public static final int PACKET_STATS = 0x10;
+    public static final int CATALOG_BEGIN = 0x11;
+    public static final int CATALOG_CHUNK = 0x12;
+    public static final int CATALOG_END = 0x13;
+    public static final int CATALOG_SELECT = 0x14;
+    public static final int TELEMETRY = 0x15;
+}
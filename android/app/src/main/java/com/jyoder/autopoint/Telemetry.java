@@ -0,0 +1,160 @@
+package com.jyoder.autopoint;
+
+import java.nio.BufferUnderflowException;
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * The laser's telemetry stream (TELEMETRY, see telemetry.h in the firmware for how it's batched
+ * and rate controlled, protocol.h for the layout).
+ *
+ * Each frame carries a batch of samples, the first as is and the rest as varint deltas from the
+ * one before, after a header with the worst case timing stats and now and then a status block.
+ * Feed every TELEMETRY reply to onFrame(); it keeps the latest stats and counts frames lost on
+ * the way (a gap in seq).
+ */
+public class Telemetry {
+
+    private static final int FLAG_STATUS = 0x01;
+    private static final int FIELDS = 6;
+
+    private static final double ANGLE_SCALE = 1e-6;
+    private static final double DUTY_SCALE = 1e-4;
+
+    /* state bits */
+    public static final int ARMED = 1 << 0;
+    public static final int LASER_ON = 1 << 1;
+    public static final int MOUNT_ENABLED = 1 << 2;
+    private static final int REASONS_SHIFT = 3;
+
+    public static class Sample {
+        public long unixUs;
+        public double az, el;           /* encoder position, radians */
+        public double azErr, elErr;     /* setpoint - position, radians */
+        public double azDuty, elDuty;   /* -1 to 1 */
+        public int state;
+
+        public double setpointAz() {
+            return az + azErr;
+        }
+
+        public double setpointEl() {
+            return el + elErr;
+        }
+
+        public boolean isLaserOn() {
+            return (state & LASER_ON) != 0;
+        }
+
+        /* interlock reasons holding the laser off (INTERLOCK_* in interlock.h) */
+        public int reasons() {
+            return state >>> REASONS_SHIFT;
+        }
+    }
+
+    /* From the latest frame. Times in ns, worst since the laser powered up. */
+    public long rateHz, droppedSamples, underruns;
+    public long setpointJitterNs, setpointIsrNs, stepperJitterNs, stepperIsrNs, interlockLatencyNs;
+
+    /* From the latest status block */
+    public boolean haveStatus = false;
+    public long syncs, syncAgeS, syncUncertaintyUs, driftPpb, driftSigmaPpb, baud;
+    public long txOverflows, rxLost, rn42BootUs;
+
+    public long frames = 0;
+    public long lostFrames = 0;
+    private int lastSeq = -1;
+
+    /* Start the stream at up to maxHz, or stop it with 0 */
+    public static byte[] request(int maxHz) {
+        return Frame.encode(Protocol.TELEMETRY, Frame.payload(2).putShort((short) maxHz));
+    }
+
+    static long varint(ByteBuffer b) {
+        long v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            int c = b.get() & 0xFF;
+            v |= (long) (c & 0x7F) << shift;
+            if ((c & 0x80) == 0) return v;
+        }
+        throw new BufferUnderflowException();
+    }
+
+    static int zigzag(ByteBuffer b) {
+        int u = (int) varint(b);
+        return (u >>> 1) ^ -(u & 1);
+    }
+
+    /* The samples in a TELEMETRY reply, oldest first, or null if it isn't one or doesn't parse */
+    public List<Sample> onFrame(Frame f) {
+        if (f.type != (Protocol.TELEMETRY | Protocol.REPLY)) return null;
+
+        ByteBuffer b = f.payload.duplicate().order(f.payload.order());
+        List<Sample> out = new ArrayList<>();
+
+        try {
+            int seq = b.getShort() & 0xFFFF;
+            int flags = b.get() & 0xFF;
+            int count = b.get() & 0xFF;
+            long t = b.getLong();
+
+            long rate = varint(b), dropped = varint(b), under = varint(b);
+            long spJitter = varint(b), spIsr = varint(b), stJitter = varint(b), stIsr = varint(b);
+            long latency = varint(b);
+
+            if ((flags & FLAG_STATUS) != 0) {
+                syncs = varint(b);
+                syncAgeS = varint(b);
+                syncUncertaintyUs = varint(b);
+                driftPpb = zigzag(b);
+                driftSigmaPpb = varint(b);
+                baud = varint(b);
+                txOverflows = varint(b);
+                rxLost = varint(b);
+                rn42BootUs = varint(b);
+                haveStatus = true;
+            }
+
+            int[] q = new int[FIELDS];
+            int state = 0;
+            for (int i = 0; i < count; i++) {
+                if (i > 0) t += varint(b);
+                for (int k = 0; k < FIELDS; k++) q[k] += zigzag(b);
+                state ^= (int) varint(b);
+
+                Sample s = new Sample();
+                s.unixUs = t;
+                s.az = q[0] * ANGLE_SCALE;
+                s.el = q[1] * ANGLE_SCALE;
+                s.azErr = q[2] * ANGLE_SCALE;
+                s.elErr = q[3] * ANGLE_SCALE;
+                s.azDuty = q[4] * DUTY_SCALE;
+                s.elDuty = q[5] * DUTY_SCALE;
+                s.state = state;
+                out.add(s);
+            }
+
+            rateHz = rate;
+            droppedSamples = dropped;
+            underruns = under;
+            setpointJitterNs = spJitter;
+            setpointIsrNs = spIsr;
+            stepperJitterNs = stJitter;
+            stepperIsrNs = stIsr;
+            interlockLatencyNs = latency;
+
+            if (lastSeq >= 0) lostFrames += (seq - lastSeq - 1) & 0xFFFF;
+            lastSeq = seq;
+            frames++;
+        } catch (BufferUnderflowException ex) {
+            return null;
+        }
+        return out;
+    }
+
+    /* Call on reconnect: seq starts again wherever the laser is */
+    public void reset() {
+        lastSeq = -1;
+    }
+}
@@ -0,0 +1,59 @@
+package com.jyoder.autopoint;
+
+/**
+ * Bluetooth link throughput test (the LINK_ frames, see linktest.h in the firmware).
+ *
+ * Down: LINK_SEND asks for a number of bytes, the laser streams LINK_FILL replies back and
+ * ends with a LINK_SEND reply { u32 bytes, u32 baud }. We time them from the request going
+ * out to the end marker.
+ *
+ * Up: we send LINK_FILL frames, then ask for the count with LINK_COUNT. The laser answers
+ * { u32 bytes, u32 us from the first starting to the last, u32 baud }, timed on its side so our
+ * socket buffering doesn't flatter the result.
+ */
+public class Throughput {
+
+    /* Filler frame size on the wire, delimiter included */
+    public static final int FRAME_BYTES = 64;
+
+    /* COBS adds one byte, the type and CRC three, the delimiter one */
+    private static final int FILL_PAYLOAD = FRAME_BYTES - 5;
+
+    public static byte[] downRequest(int bytes) {
+        return Frame.encode(Protocol.LINK_SEND, Frame.payload(4).putInt(bytes));
+    }
+
+    /* One uplink filler frame, FRAME_BYTES long. Counting bytes, so none of them need stuffing. */
+    public static byte[] upFrame() {
+        byte[] fill = new byte[FILL_PAYLOAD];
+        for (int i = 0; i < fill.length; i++) fill[i] = (byte) (i + 1);
+        return Frame.encode(Protocol.LINK_FILL, fill);
+    }
+
+    public static byte[] countRequest() {
+        return Frame.encode(Protocol.LINK_COUNT, new byte[0]);
+    }
+
+    public static boolean isDownFill(Frame f) {
+        return f.type == (Protocol.LINK_FILL | Protocol.REPLY);
+    }
+
+    /* Bytes the laser says it sent, from the end marker, or -1 if it isn't one */
+    public static long parseEnd(Frame f) {
+        if (f.type != (Protocol.LINK_SEND | Protocol.REPLY) || f.payload.remaining() != 8) return -1;
+        return f.payload.getInt(0) & 0xFFFFFFFFL;
+    }
+
+    /* { bytes, us on the wire, baud } from a count reply, or null if it isn't one */
+    public static long[] parseCount(Frame f) {
+        if (f.type != (Protocol.LINK_COUNT | Protocol.REPLY) || f.payload.remaining() != 12) return null;
+        return new long[] {
+                f.payload.getInt(0) & 0xFFFFFFFFL,
+                f.payload.getInt(4) & 0xFFFFFFFFL,
+                f.payload.getInt(8) & 0xFFFFFFFFL };
+    }
+
+    public static long bytesPerSecond(long bytes, long us) {
+        return us > 0 ? bytes * 1000000 / us : 0;
+    }
+}
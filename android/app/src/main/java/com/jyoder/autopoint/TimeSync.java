@@ -0,0 +1,81 @@
+package com.jyoder.autopoint;
+
+/**
+ * NTP style clock sync with the laser over bluetooth (see timesync.h in the firmware).
+ *
+ * Each exchange gives four timestamps, in unix microseconds:
+ *   t1: we send the request (our clock)
+ *   t2: request arrived (laser clock)
+ *   t3: reply sent (laser clock)
+ *   t4: we have the reply (our clock)
+ *
+ * The RN42 link adds tens of ms of latency that's rarely the same both ways, so we run a burst
+ * of exchanges and only trust the one with the smallest round trip.
+ */
+public class TimeSync {
+
+    public static final int EXCHANGES = 16;
+
+    public static class Sample {
+        public final long t1, t2, t3, t4;
+
+        public Sample(long t1, long t2, long t3, long t4) {
+            this.t1 = t1;
+            this.t2 = t2;
+            this.t3 = t3;
+            this.t4 = t4;
+        }
+
+        /* How far the laser's clock is behind ours */
+        public long offset() {
+            return ((t1 - t2) + (t4 - t3)) / 2;
+        }
+
+        /* Round trip, minus the time the laser sat on the request */
+        public long delay() {
+            return (t4 - t1) - (t3 - t2);
+        }
+    }
+
+    private Sample best = null;
+    private int count = 0;
+
+    public static byte[] request(int seq, long t1) {
+        return Frame.encode(Protocol.TIME_REQUEST, Frame.payload(12).putInt(seq).putLong(t1));
+    }
+
+    /* Parse a reply to request 'seq', received at t4. Returns null if it isn't one. */
+    public static Sample parseReply(Frame f, int seq, long t4) {
+        if (f.type != (Protocol.TIME_REQUEST | Protocol.REPLY) || f.payload.remaining() != 28) return null;
+        if (f.payload.getInt(0) != seq) return null;
+        return new Sample(f.payload.getLong(4), f.payload.getLong(12), f.payload.getLong(20), t4);
+    }
+
+    public void add(Sample s) {
+        if (s.delay() < 0) return; /* garbage */
+        count++;
+        if (best == null || s.delay() < best.delay()) best = s;
+    }
+
+    public int getCount() {
+        return count;
+    }
+
+    public boolean hasResult() {
+        return best != null;
+    }
+
+    /* Microseconds to step the laser's clock by */
+    public long getOffsetUs() {
+        return best.offset();
+    }
+
+    /* The true offset is within this of getOffsetUs(), however the round trip split up */
+    public long getUncertaintyUs() {
+        return best.delay() / 2;
+    }
+
+    public byte[] applyPacket() {
+        return Frame.encode(Protocol.TIME_APPLY, Frame.payload(12).putLong(getOffsetUs()).putInt((int) getUncertaintyUs()));
+    }
+}
@@ -0,0 +1,140 @@
+package com.jyoder.autopoint;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * A two line element set, parsed into the integers the TLE carries (same units as tle_elements_t
+ * in the firmware's tle.h), plus the text it came from.
+ */
+public class Tle {
+
+    public static final int LINE_LEN = 69;
+
+    /* Angles, 1e-4 degree, wrap at this */
+    public static final int DEG_FULL = 3600000;
+
+    public final String name;
+    public final String line1;
+    public final String line2;
+
+    public int norad;
+    public int epochDay;        /* days since 2000-01-01 */
+    public int epochFrac;       /* 1e-8 day */
+    public int ndot;            /* 1e-8 rev/day^2 */
+    public int nddotM, nddotE;  /* mantissa 1e-5, exponent */
+    public int bstarM, bstarE;
+    public int inclo;           /* 1e-4 degree */
+    public int nodeo;
+    public int ecco;            /* 1e-7 */
+    public int argpo;
+    public int mo;
+    public int no;              /* 1e-8 rev/day */
+
+    private Tle(String name, String line1, String line2) {
+        this.name = name;
+        this.line1 = line1;
+        this.line2 = line2;
+    }
+
+    /* Days since 2000-01-01 (timeconv.h's days_from_civil) */
+    static int daysFromCivil(int y, int m, int d) {
+        y -= m <= 2 ? 1 : 0;
+        int era = (y >= 0 ? y : y - 399) / 400;
+        int yoe = y - era * 400;
+        int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 730425;
+    }
+
+    private static boolean checksumOk(String l) {
+        int sum = 0;
+        for (int i = 0; i < LINE_LEN - 1; i++) {
+            char c = l.charAt(i);
+            if (c >= '0' && c <= '9') sum += c - '0';
+            if (c == '-') sum += 1;
+        }
+        return l.charAt(LINE_LEN - 1) - '0' == sum % 10;
+    }
+
+    /* Columns [from, to] as a fixed point integer, the way tle.c reads them */
+    private static int field(String l, int from, int to) {
+        int v = 0;
+        boolean neg = false;
+        for (int i = from; i <= to; i++) {
+            char c = l.charAt(i);
+            if (c >= '0' && c <= '9') {
+                v = v * 10 + (c - '0');
+            } else if (c == '-' && v == 0) {
+                neg = true;
+            } else if (c != ' ' && c != '.' && c != '+') {
+                throw new NumberFormatException(l.substring(from, to + 1));
+            }
+        }
+        return neg ? -v : v;
+    }
+
+    private static boolean lineOk(String l, char card) {
+        return l.length() >= LINE_LEN && l.charAt(0) == card && l.charAt(1) == ' ' && checksumOk(l);
+    }
+
+    /* null if it isn't a good set */
+    public static Tle parse(String name, String line1, String line2) {
+        if (!lineOk(line1, '1') || !lineOk(line2, '2')) return null;
+
+        Tle t = new Tle(name, line1, line2);
+        try {
+            t.norad = field(line1, 2, 6);
+            if (t.norad <= 0 || t.norad != field(line2, 2, 6)) return null;
+
+            int yy = field(line1, 18, 19);
+            int doy = field(line1, 20, 22);
+            if (line1.charAt(23) != '.' || doy < 1 || doy > 366) return null;
+            t.epochDay = daysFromCivil(yy < 57 ? 2000 + yy : 1900 + yy, 1, 1) + doy - 1;
+            t.epochFrac = field(line1, 24, 31);
+
+            t.ndot = field(line1, 33, 42);
+            t.nddotM = field(line1, 44, 49);
+            t.nddotE = field(line1, 50, 51);
+            t.bstarM = field(line1, 53, 58);
+            t.bstarE = field(line1, 59, 60);
+
+            t.inclo = field(line2, 8, 15);
+            t.nodeo = field(line2, 17, 24);
+            t.ecco = field(line2, 26, 32);
+            t.argpo = field(line2, 34, 41);
+            t.mo = field(line2, 43, 50);
+            t.no = field(line2, 52, 62);
+        } catch (NumberFormatException ex) {
+            return null;
+        }
+        return t;
+    }
+
+    /* Every good set in some TLE text (2 or 3 line sets) */
+    public static List<Tle> parseAll(String text) {
+        List<Tle> sets = new ArrayList<>();
+        String name = "";
+        String line1 = null;
+
+        for (String l : text.split("\r?\n")) {
+            if (l.startsWith("1 ")) {
+                line1 = l;
+            } else if (l.startsWith("2 ") && line1 != null) {
+                Tle t = parse(name, line1, l);
+                if (t != null) sets.add(t);
+                line1 = null;
+                name = "";
+            } else if (!l.trim().isEmpty()) {
+                name = (l.startsWith("0 ") ? l.substring(2) : l).trim();
+                line1 = null;
+            }
+        }
+        return sets;
+    }
+
+    /* The set as upload text */
+    public String text() {
+        return (name.isEmpty() ? "" : name + "\n") + line1 + "\n" + line2 + "\n";
+    }
+}
@@ -0,0 +1,100 @@
+package com.jyoder.autopoint;
+
+import org.junit.Test;
+
+import java.io.ByteArrayOutputStream;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+import static org.junit.Assert.*;
+
+public class CatalogDeltaTest {
+
+    /* The ISS set a day on: new epoch, mean anomaly, node, drag and mean motion */
+    static final String NEXT1 = "1 25544U 98067A   17361.64724323  .00001080  00000-0  25144-4 0  9998";
+    static final String NEXT2 = "2 25544  51.6415 153.9485 0004119 294.1333 041.1617 15.54216737 91695";
+
+    private static Tle iss() {
+        return Tle.parse("ISS", TleTest.ISS1, TleTest.ISS2);
+    }
+
+    private static int varint(byte[] b, int[] at) {
+        int v = 0;
+        for (int shift = 0; ; shift += 7) {
+            int c = b[at[0]++] & 0xFF;
+            v |= (c & 0x7F) << shift;
+            if ((c & 0x80) == 0) return v;
+        }
+    }
+
+    private static int zigzag(byte[] b, int[] at) {
+        int u = varint(b, at);
+        return (u >>> 1) ^ -(u & 1);
+    }
+
+    @Test
+    public void varints() throws Exception {
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        CatalogDelta.putVarint(out, 300);
+        CatalogDelta.putZigzag(out, -1);
+        CatalogDelta.putZigzag(out, 1);
+        assertArrayEquals(new byte[] { (byte) 0xAC, 0x02, 0x01, 0x02 }, out.toByteArray());
+    }
+
+    @Test
+    public void unchangedIsNotSent() throws Exception {
+        Map<Integer, Tle> resident = new HashMap<>();
+        resident.put(25544, iss());
+        List<Tle> full = new ArrayList<>();
+
+        assertEquals(0, CatalogDelta.encode(resident, Arrays.asList(iss()), full).length);
+        assertTrue(full.isEmpty());
+    }
+
+    @Test
+    public void newSetsGoWhole() throws Exception {
+        List<Tle> full = new ArrayList<>();
+        assertEquals(0, CatalogDelta.encode(new HashMap<Integer, Tle>(), Arrays.asList(iss()), full).length);
+        assertEquals(1, full.size());
+    }
+
+    @Test
+    public void dailyRefresh() throws Exception {
+        Tle next = Tle.parse("ISS", NEXT1, NEXT2);
+        assertNotNull(next);
+
+        Map<Integer, Tle> resident = new HashMap<>();
+        resident.put(25544, iss());
+        List<Tle> full = new ArrayList<>();
+        byte[] stream = CatalogDelta.encode(resident, Arrays.asList(next), full);
+
+        assertTrue(full.isEmpty());
+        assertEquals(stream.length - 1, stream[0]);
+        /* a fraction of the 140 bytes of text */
+        assertTrue(stream.length < 40);
+
+        /* norad, the base epoch it applies to, then which fields changed */
+        int[] at = { 1 };
+        assertEquals(25544, varint(stream, at));
+        assertEquals(iss().epochDay, varint(stream, at));
+        assertEquals(iss().epochFrac, varint(stream, at));
+        int mask = 1 << CatalogDelta.EPOCH | 1 << CatalogDelta.NDOT | 1 << CatalogDelta.BSTAR_M
+                | 1 << CatalogDelta.NODEO | 1 << CatalogDelta.ECCO | 1 << CatalogDelta.ARGPO
+                | 1 << CatalogDelta.MO | 1 << CatalogDelta.NO;
+        assertEquals(mask, varint(stream, at));
+
+        /* epoch a day and a bit on, mean anomaly the short way round */
+        assertEquals(101234567, zigzag(stream, at));
+        assertEquals(-210, zigzag(stream, at));
+        assertEquals(-1500, zigzag(stream, at));
+        assertEquals(-49876, zigzag(stream, at));
+        assertEquals(1532, zigzag(stream, at));
+        assertEquals(12, zigzag(stream, at));
+        assertEquals(411617 - 1646117, zigzag(stream, at));
+        assertEquals(1532, zigzag(stream, at));
+        assertEquals(stream.length, at[0]);
+    }
+}
@@ -0,0 +1,90 @@
+package com.jyoder.autopoint;
+
+import org.junit.Test;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import static com.jyoder.autopoint.Frames.*;
+import static org.junit.Assert.*;
+
+public class CatalogUploadTest {
+
+    private static Frame reply(int type, int next, int sets, int errors, int status) {
+        return roundTrip(type | Protocol.REPLY,
+                Frame.payload(7).putShort((short) next).putShort((short) sets).putShort((short) errors)
+                        .put((byte) status));
+    }
+
+    private static List<Frame> drain(CatalogUpload up) {
+        List<Frame> sent = new ArrayList<>();
+        byte[] frame;
+        while ((frame = up.poll()) != null) sent.add(decode(frame));
+        return sent;
+    }
+
+    @Test
+    public void begin() throws Exception {
+        Frame f = roundTrip(Protocol.CATALOG_BEGIN | Protocol.REPLY, new byte[] { 4, (byte) 128, 16, 0 });
+        CatalogUpload up = CatalogUpload.fromBeginReply(f, new byte[300]);
+        assertNotNull(up);
+        assertEquals(3, up.getChunks());
+        assertNull(CatalogUpload.fromBeginReply(reply(Protocol.CATALOG_CHUNK, 0, 0, 0, 0), new byte[300]));
+    }
+
+    /* Stops at the window, and moves on as acks come in */
+    @Test
+    public void slidingWindow() throws Exception {
+        CatalogUpload up = new CatalogUpload(new byte[10 * 8], 4, 8);
+
+        List<Frame> sent = drain(up);
+        assertEquals(4, sent.size());
+        for (int i = 0; i < 4; i++) {
+            assertEquals(Protocol.CATALOG_CHUNK, sent.get(i).type);
+            assertEquals(i, sent.get(i).payload.getShort(0));
+            assertEquals(2 + 8, sent.get(i).payload.remaining());
+        }
+
+        assertTrue(up.onReply(reply(Protocol.CATALOG_CHUNK, 2, 0, 0, CatalogUpload.STATUS_ACK)));
+        sent = drain(up);
+        assertEquals(2, sent.size());
+        assertEquals(4, sent.get(0).payload.getShort(0));
+        assertEquals(5, sent.get(1).payload.getShort(0));
+    }
+
+    /* A resend or a timeout goes back to the first chunk the laser doesn't have */
+    @Test
+    public void goesBack() throws Exception {
+        CatalogUpload up = new CatalogUpload(new byte[10 * 8], 4, 8);
+        drain(up);
+
+        up.onReply(reply(Protocol.CATALOG_CHUNK, 1, 0, 0, CatalogUpload.STATUS_RESEND));
+        List<Frame> sent = drain(up);
+        assertEquals(4, sent.size());
+        assertEquals(1, sent.get(0).payload.getShort(0));
+
+        up.onTimeout();
+        assertEquals(1, decode(up.poll()).payload.getShort(0));
+    }
+
+    @Test
+    public void endsWhenDone() throws Exception {
+        CatalogUpload up = new CatalogUpload(new byte[20], 4, 8);
+
+        List<Frame> sent = drain(up);
+        assertEquals(4, sent.size());
+        assertEquals(4, sent.get(2).payload.remaining());
+        Frame end = sent.get(3);
+        assertEquals(Protocol.CATALOG_END, end.type);
+        assertEquals(3, end.payload.getShort(0));
+
+        /* END only goes once per pass */
+        assertTrue(drain(up).isEmpty());
+
+        up.onReply(reply(Protocol.CATALOG_END, 3, 2, 1, CatalogUpload.STATUS_DONE));
+        assertTrue(up.isDone());
+        assertEquals(2, up.getSets());
+        assertEquals(1, up.getErrors());
+        assertNull(up.poll());
+    }
+}
@@ -0,0 +1,66 @@
+package com.jyoder.autopoint;
+
+import org.junit.Test;
+
+import java.util.Random;
+
+import static org.junit.Assert.*;
+
+public class FrameTest {
+
+    /* CRC-16/ARC check value, same as Crc16() in the firmware */
+    @Test
+    public void crcCheckValue() throws Exception {
+        byte[] check = "123456789".getBytes("US-ASCII");
+        assertEquals(0xBB3D, Frame.crc16(check, check.length));
+    }
+
+    @Test
+    public void cobsVectors() throws Exception {
+        assertArrayEquals(new byte[] { 1, 1 }, Frame.cobsEncode(new byte[] { 0 }, 1));
+        assertArrayEquals(new byte[] { 3, 0x11, 0x22, 2, 0x33 },
+                Frame.cobsEncode(new byte[] { 0x11, 0x22, 0, 0x33 }, 4));
+
+        byte[] long254 = new byte[254];
+        for (int i = 0; i < long254.length; i++) long254[i] = (byte) (i + 1);
+        byte[] enc = Frame.cobsEncode(long254, long254.length);
+        assertEquals(256, enc.length);
+        assertEquals((byte) 0xFF, enc[0]);
+        assertArrayEquals(long254, Frame.cobsDecode(enc, enc.length));
+
+        assertNull(Frame.cobsDecode(new byte[] { 5, 1, 2 }, 3));
+    }
+
+    @Test
+    public void roundTrip() throws Exception {
+        Random r = new Random(1);
+        for (int n = 0; n < 1000; n++) {
+            byte[] payload = new byte[r.nextInt(Frame.MAX_PAYLOAD + 1)];
+            r.nextBytes(payload);
+            int type = r.nextInt(256);
+
+            byte[] wire = Frame.encode(type, payload);
+            for (int i = 0; i < wire.length - 1; i++) assertNotEquals(0, wire[i]);
+            assertEquals(0, wire[wire.length - 1]);
+
+            Frame f = Frame.decode(wire, wire.length - 1);
+            assertNotNull(f);
+            assertEquals(type, f.type);
+            byte[] got = new byte[f.payload.remaining()];
+            f.payload.get(got);
+            assertArrayEquals(payload, got);
+        }
+    }
+
+    @Test
+    public void rejectsCorruption() throws Exception {
+        byte[] wire = Frame.encode(Protocol.SITE, Frame.payload(12).putFloat(1).putFloat(2).putFloat(3));
+        for (int i = 0; i < wire.length - 1; i++) {
+            byte[] bad = wire.clone();
+            bad[i] ^= 0x04;
+            if (bad[i] == 0) continue;
+            assertNull(Frame.decode(bad, bad.length - 1));
+        }
+        assertNull(Frame.decode(wire, 2));
+    }
+}
@@ -0,0 +1,26 @@
+package com.jyoder.autopoint;
+
+import java.nio.ByteBuffer;
+
+/**
+ * Frames as the app receives them, for the parser tests.
+ */
+final class Frames {
+
+    private Frames() {
+    }
+
+    /* A whole frame off the wire, delimiter included */
+    static Frame decode(byte[] wire) {
+        return Frame.decode(wire, wire.length - 1);
+    }
+
+    /* Through the encoder and back, the way a reply from the firmware reaches a parser */
+    static Frame roundTrip(int type, byte[] payload) {
+        return decode(Frame.encode(type, payload));
+    }
+
+    static Frame roundTrip(int type, ByteBuffer payload) {
+        return roundTrip(type, payload.array());
+    }
+}
@@ -0,0 +1,114 @@
+package com.jyoder.autopoint;
+
+import org.junit.Test;
+
+import java.io.ByteArrayOutputStream;
+import java.nio.ByteBuffer;
+import java.util.List;
+
+import static com.jyoder.autopoint.Frames.*;
+import static org.junit.Assert.*;
+
+public class TelemetryTest {
+
+    static final long T0 = 1514246400000000L;
+
+    static final int REPLY = Protocol.TELEMETRY | Protocol.REPLY;
+
+    /* Header and timing block as telemetry.c lays them out */
+    private static ByteArrayOutputStream header(int seq, int flags, int samples) {
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        ByteBuffer b = Frame.payload(12).putShort((short) seq).put((byte) flags).put((byte) samples).putLong(T0);
+        out.write(b.array(), 0, 12);
+        for (long v : new long[] { 50, 0, 3, 1200, 4500, 800, 2000, 3100 }) CatalogDelta.putVarint(out, v);
+        return out;
+    }
+
+    private static void sample(ByteArrayOutputStream out, int[] fields, int state) {
+        for (int v : fields) CatalogDelta.putZigzag(out, v);
+        CatalogDelta.putVarint(out, state);
+    }
+
+    @Test
+    public void decodesDeltas() throws Exception {
+        ByteArrayOutputStream out = header(7, 0x01, 2);
+
+        /* status: syncs, age, uncertainty, drift, sigma, baud, tx overflows, rx lost, RN42 boot */
+        CatalogDelta.putVarint(out, 5);
+        CatalogDelta.putVarint(out, 12);
+        CatalogDelta.putVarint(out, 800);
+        CatalogDelta.putZigzag(out, -1500);
+        CatalogDelta.putVarint(out, 200);
+        CatalogDelta.putVarint(out, 115200);
+        CatalogDelta.putVarint(out, 4);
+        CatalogDelta.putVarint(out, 1);
+        CatalogDelta.putVarint(out, 1850000);
+
+        int on = Telemetry.ARMED | Telemetry.LASER_ON | Telemetry.MOUNT_ENABLED;
+        sample(out, new int[] { 1000000, 500000, -20, 15, 1234, -50 }, on);
+
+        /* 20 ms on, laser cut for pointing error (1 << 5) */
+        CatalogDelta.putVarint(out, 20000);
+        sample(out, new int[] { 8000, -300, 5, -15, 10, 0 }, Telemetry.LASER_ON | (1 << 5) << 3);
+
+        Telemetry tm = new Telemetry();
+        List<Telemetry.Sample> s = tm.onFrame(roundTrip(REPLY, out.toByteArray()));
+        assertNotNull(s);
+        assertEquals(2, s.size());
+
+        assertEquals(T0, s.get(0).unixUs);
+        assertEquals(1.0, s.get(0).az, 1e-9);
+        assertEquals(0.5, s.get(0).el, 1e-9);
+        assertEquals(1.0 - 20e-6, s.get(0).setpointAz(), 1e-9);
+        assertEquals(0.1234, s.get(0).azDuty, 1e-9);
+        assertTrue(s.get(0).isLaserOn());
+        assertEquals(0, s.get(0).reasons());
+
+        assertEquals(T0 + 20000, s.get(1).unixUs);
+        assertEquals(1.008, s.get(1).az, 1e-9);
+        assertEquals(0.4997, s.get(1).el, 1e-9);
+        assertEquals(-15e-6, s.get(1).azErr, 1e-12);
+        assertEquals(0.0, s.get(1).elErr, 1e-12);
+        assertEquals(-0.005, s.get(1).elDuty, 1e-9);
+        assertFalse(s.get(1).isLaserOn());
+        assertEquals(1 << 5, s.get(1).reasons());
+
+        assertEquals(50, tm.rateHz);
+        assertEquals(4500, tm.setpointIsrNs);
+        assertEquals(3100, tm.interlockLatencyNs);
+        assertTrue(tm.haveStatus);
+        assertEquals(-1500, tm.driftPpb);
+        assertEquals(115200, tm.baud);
+        assertEquals(4, tm.txOverflows);
+        assertEquals(1, tm.rxLost);
+        assertEquals(1850000, tm.rn42BootUs);
+    }
+
+    @Test
+    public void countsLostFrames() throws Exception {
+        Telemetry tm = new Telemetry();
+        assertNotNull(tm.onFrame(roundTrip(REPLY, header(0xFFFE, 0, 0).toByteArray())));
+        assertNotNull(tm.onFrame(roundTrip(REPLY, header(0xFFFF, 0, 0).toByteArray())));
+        assertNotNull(tm.onFrame(roundTrip(REPLY, header(2, 0, 0).toByteArray())));
+        assertEquals(3, tm.frames);
+        assertEquals(2, tm.lostFrames);
+    }
+
+    @Test
+    public void rejectsTruncated() throws Exception {
+        ByteArrayOutputStream out = header(1, 0, 3);
+        sample(out, new int[] { 1, 2, 3, 4, 5, 6 }, 0);
+
+        Telemetry tm = new Telemetry();
+        assertNull(tm.onFrame(roundTrip(REPLY, out.toByteArray())));
+        assertEquals(0, tm.frames);
+    }
+
+    @Test
+    public void request() throws Exception {
+        byte[] wire = Telemetry.request(50);
+        Frame f = decode(wire);
+        assertEquals(Protocol.TELEMETRY, f.type);
+        assertEquals(50, f.payload.getShort());
+    }
+}
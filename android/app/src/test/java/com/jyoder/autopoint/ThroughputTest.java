@@ -0,0 +1,51 @@
+package com.jyoder.autopoint;
+
+import org.junit.Test;
+
+import static com.jyoder.autopoint.Frames.*;
+import static org.junit.Assert.*;
+
+public class ThroughputTest {
+
+    @Test
+    public void upFrameIsOneFrame() throws Exception {
+        byte[] frame = Throughput.upFrame();
+        assertEquals(Throughput.FRAME_BYTES, frame.length);
+        assertEquals(frame.length - 1, indexOfZero(frame));
+
+        Frame f = decode(frame);
+        assertNotNull(f);
+        assertEquals(Protocol.LINK_FILL, f.type);
+    }
+
+    @Test
+    public void parsesEnd() throws Exception {
+        int end = Protocol.LINK_SEND | Protocol.REPLY;
+        assertEquals(4096, Throughput.parseEnd(roundTrip(end, Frame.payload(8).putInt(4096).putInt(115200).array())));
+        assertEquals(-1, Throughput.parseEnd(roundTrip(Protocol.LINK_FILL | Protocol.REPLY, new byte[59])));
+        assertEquals(-1, Throughput.parseEnd(roundTrip(end, new byte[4])));
+    }
+
+    @Test
+    public void parsesCount() throws Exception {
+        long[] c = Throughput.parseCount(roundTrip(Protocol.LINK_COUNT | Protocol.REPLY,
+                Frame.payload(12).putInt(6400).putInt(600000).putInt(115200).array()));
+        assertNotNull(c);
+        assertEquals(6400, c[0]);
+        assertEquals(600000, c[1]);
+        assertEquals(115200, c[2]);
+        assertNull(Throughput.parseCount(roundTrip(Protocol.LINK_SEND | Protocol.REPLY, new byte[8])));
+    }
+
+    /* 11.52 kB/s is 115200 baud 8N1 flat out */
+    @Test
+    public void rate() throws Exception {
+        assertEquals(11520, Throughput.bytesPerSecond(11520, 1000000));
+        assertEquals(0, Throughput.bytesPerSecond(100, 0));
+    }
+
+    private static int indexOfZero(byte[] b) {
+        for (int i = 0; i < b.length; i++) if (b[i] == 0) return i;
+        return -1;
+    }
+}
@@ -0,0 +1,61 @@
+package com.jyoder.autopoint;
+
+import org.junit.Test;
+
+import static com.jyoder.autopoint.Frames.*;
+import static org.junit.Assert.*;
+
+public class TimeSyncTest {
+
+    /* Laser clock 5 s behind ours, 20 ms up / 20 ms down, 1 ms turnaround */
+    @Test
+    public void symmetricExchange() throws Exception {
+        TimeSync.Sample s = new TimeSync.Sample(1000000, 1020000 - 5000000, 1021000 - 5000000, 1041000);
+        assertEquals(5000000, s.offset());
+        assertEquals(40000, s.delay());
+    }
+
+    /* Slow exchanges are lopsided; the fastest one should win */
+    @Test
+    public void keepsMinimumDelay() throws Exception {
+        TimeSync sync = new TimeSync();
+        sync.add(new TimeSync.Sample(0, 80000, 81000, 101000));    /* 80 ms up, 20 ms down */
+        sync.add(new TimeSync.Sample(0, 10000, 11000, 21000));     /* 10 ms up, 10 ms down */
+        sync.add(new TimeSync.Sample(0, 20000, 21000, 90000));     /* 20 ms up, 69 ms down */
+
+        assertTrue(sync.hasResult());
+        assertEquals(3, sync.getCount());
+        assertEquals(0, sync.getOffsetUs());
+        assertEquals(10000, sync.getUncertaintyUs());
+
+        byte[] apply = sync.applyPacket();
+        Frame f = decode(apply);
+        assertNotNull(f);
+        assertEquals(Protocol.TIME_APPLY, f.type);
+        assertEquals(0, f.payload.getLong(0));
+        assertEquals(10000, f.payload.getInt(8));
+    }
+
+    @Test
+    public void parsesReply() throws Exception {
+        int type = Protocol.TIME_REQUEST | Protocol.REPLY;
+        TimeSync.Sample s = TimeSync.parseReply(
+                roundTrip(type, Frame.payload(28).putInt(3).putLong(1000).putLong(2000).putLong(3000)), 3, 4000);
+        assertNotNull(s);
+        assertEquals(1000, s.t1);
+        assertEquals(2000, s.t2);
+        assertEquals(3000, s.t3);
+        assertEquals(4000, s.t4);
+
+        assertNull(TimeSync.parseReply(
+                roundTrip(type, Frame.payload(28).putInt(2).putLong(1000).putLong(2000).putLong(3000)), 3, 4000));
+        assertNull(TimeSync.parseReply(roundTrip(Protocol.INTERLOCK_STATUS | Protocol.REPLY, Frame.payload(18)), 3, 4000));
+
+        byte[] req = TimeSync.request(7, 123);
+        Frame f = decode(req);
+        assertNotNull(f);
+        assertEquals(Protocol.TIME_REQUEST, f.type);
+        assertEquals(7, f.payload.getInt(0));
+        assertEquals(123, f.payload.getLong(4));
+    }
+}
@@ -0,0 +1,56 @@
+package com.jyoder.autopoint;
+
+import org.junit.Test;
+
+import java.util.List;
+
+import static org.junit.Assert.*;
+
+public class TleTest {
+
+    static final String ISS1 = "1 25544U 98067A   17360.63489756  .00001290  00000-0  26644-4 0  9993";
+    static final String ISS2 = "2 25544  51.6415 158.9361 0002587 294.1321 164.6117 15.54215205 91681";
+
+    @Test
+    public void parsesFields() throws Exception {
+        Tle t = Tle.parse("ISS", ISS1, ISS2);
+        assertNotNull(t);
+        assertEquals(25544, t.norad);
+        assertEquals(Tle.daysFromCivil(2017, 12, 26), t.epochDay);
+        assertEquals(63489756, t.epochFrac);
+        assertEquals(1290, t.ndot);
+        assertEquals(0, t.nddotM);
+        assertEquals(26644, t.bstarM);
+        assertEquals(-4, t.bstarE);
+        assertEquals(516415, t.inclo);
+        assertEquals(1589361, t.nodeo);
+        assertEquals(2587, t.ecco);
+        assertEquals(2941321, t.argpo);
+        assertEquals(1646117, t.mo);
+        assertEquals(1554215205, t.no);
+    }
+
+    @Test
+    public void days() throws Exception {
+        assertEquals(0, Tle.daysFromCivil(2000, 1, 1));
+        assertEquals(-1, Tle.daysFromCivil(1999, 12, 31));
+        assertEquals(60, Tle.daysFromCivil(2000, 3, 1));
+        assertEquals(6570, Tle.daysFromCivil(2017, 12, 27));
+    }
+
+    @Test
+    public void rejectsBadSets() throws Exception {
+        assertNull(Tle.parse("", ISS1.replace("9993", "9994"), ISS2));
+        assertNull(Tle.parse("", ISS1, ISS1));
+        assertNull(Tle.parse("", ISS1.substring(0, 60), ISS2));
+    }
+
+    @Test
+    public void parsesText() throws Exception {
+        List<Tle> sets = Tle.parseAll("ISS (ZARYA)\r\n" + ISS1 + "\r\n" + ISS2 + "\r\n" + ISS1 + "\n" + ISS2);
+        assertEquals(2, sets.size());
+        assertEquals("ISS (ZARYA)", sets.get(0).name);
+        assertEquals("", sets.get(1).name);
+        assertEquals("ISS (ZARYA)\n" + ISS1 + "\n" + ISS2 + "\n", sets.get(0).text());
+    }
+}